@@ -267,5 +267,95 @@ public class AclTests : IDisposable
                 File.Delete(symlinkPath);
         }
     }
+
+    [Fact]
+    public void TryGetFile_MatchesThrowingVariants()
+    {
+        Assert.Equal(0, Acl.TryGetFileAccess(_testFilePath, out var accessText));
+        Assert.Equal(Acl.GetFileAccess(_testFilePath)["acl_text"]?.ToString(), accessText);
+
+        Assert.Equal(0, Acl.TryGetFileDefault(_testDirPath, out var defaultText));
+        Assert.Equal(Acl.GetFileDefault(_testDirPath)["acl_text"]?.ToString(), defaultText);
+    }
+
+    [Fact]
+    public void CollectInode_WithoutAclXattr_DerivesAclFromMode()
+    {
+        var plainPath = _testFilePath + ".plain";
+        File.WriteAllText(plainPath, "no extended ACL");
+        try
+        {
+            File.SetUnixFileMode(
+                plainPath,
+                UnixFileMode.UserRead | UnixFileMode.UserExecute | UnixFileMode.GroupWrite | UnixFileMode.OtherRead
+            );
+
+            // Act
+            Assert.Equal(0, FileSystem.TryCollectInode(plainPath, FileSystem.CollectParts.Acl, out var plain));
+            Assert.Equal(0, FileSystem.TryCollectInode(_testFilePath, FileSystem.CollectParts.Acl, out var extended));
+            Assert.Equal(0, FileSystem.TryCollectInode(_testDirPath, FileSystem.CollectParts.Acl, out var dir));
+
+            // Assert - same text as libacl, but only entries with an ACL xattr went through it
+            Assert.True(plain!.AccessAclFromMode);
+            Assert.Equal(0, Acl.TryGetFileAccess(plainPath, out var plainText));
+            Assert.Equal(plainText, plain.AccessAcl);
+            Assert.Null(plain.DefaultAcl);
+
+            Assert.False(extended!.AccessAclFromMode);
+            Assert.Equal(0, Acl.TryGetFileAccess(_testFilePath, out var extendedText));
+            Assert.Equal(extendedText, extended.AccessAcl);
+
+            Assert.True(dir!.AccessAclFromMode);
+            Assert.Equal(0, Acl.TryGetFileDefault(_testDirPath, out var defaultText));
+            Assert.Equal(defaultText, dir.DefaultAcl);
+        }
+        finally
+        {
+            File.Delete(plainPath);
+        }
+    }
+
+    [Fact]
+    public void CollectInode_RawAcl_RendersLikeLibacl()
+    {
+        var parts = FileSystem.CollectParts.Acl | FileSystem.CollectParts.AclRaw;
+        string? UserName(long uid) => UserGroupDatabase.LinuxGetPwUidPacked(uid).Name;
+        string? GroupName(long gid) => UserGroupDatabase.LinuxGetGrGidPacked(gid).Name;
+
+        // Act
+        Assert.Equal(0, FileSystem.TryCollectInode(_testFilePath, parts, out var file));
+        Assert.Equal(0, FileSystem.TryCollectInode(_testDirPath, parts, out var dir));
+
+        // Assert - raw values only, rendered to the same text acl_to_any_text produces
+        Assert.Null(file!.AccessAcl);
+        Assert.NotNull(file.AccessAclRaw);
+        Assert.Equal(0, Acl.TryGetFileAccess(_testFilePath, out var accessText));
+        Assert.Equal(accessText, Acl.FormatText(file.AccessAclRaw, UserName, GroupName));
+
+        Assert.True(dir!.AccessAclFromMode);
+        Assert.Null(dir.AccessAclRaw);
+        Assert.NotNull(dir.DefaultAclRaw);
+        Assert.Equal(0, Acl.TryGetFileDefault(_testDirPath, out var defaultText));
+        Assert.Equal(defaultText, Acl.FormatText(dir.DefaultAclRaw, UserName, GroupName));
+
+        // Unresolvable qualifiers stay numeric
+        var named = Acl.ParseRaw(file.AccessAclRaw).First(e => e.Tag == AclTag.User);
+        Assert.Contains($"u:{named.Id}:rwx", Acl.FormatText(file.AccessAclRaw, _ => null, _ => null));
+        Assert.Equal(
+            Acl.FormatText(file.AccessAclRaw, _ => null, _ => null),
+            Acl.FormatNumericText(file.AccessAclRaw)
+        );
+        Assert.Throws<InvalidDataException>(() => Acl.ParseRaw([1, 0, 0, 0]));
+    }
+
+    [Fact]
+    public void TryGetFileAccess_WithNonExistentFile_ReturnsErrno()
+    {
+        const int ENOENT = 2;
+        var nonExistentPath = "/tmp/nonexistent_acl_file_" + Guid.NewGuid() + ".txt";
+
+        Assert.Equal(ENOENT, Acl.TryGetFileAccess(nonExistentPath, out var text));
+        Assert.Null(text);
+    }
 }
 #endif
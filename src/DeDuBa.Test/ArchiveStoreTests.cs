@@ -1,3 +1,4 @@
+using System.Security.Cryptography;
 using System.Text;
 using ArchiveDataHandler;
 using ICSharpCode.SharpZipLib.BZip2;
@@ -78,6 +79,27 @@ public class ArchiveStoreTests : IDisposable
         Assert.True(_store.Stats.ContainsKey("duplicate_blocks"));
     }
 
+    [Fact]
+    public void SaveData_FailedMoveLeavesTheChunkUnregistered()
+    {
+        var data = Encoding.UTF8.GetBytes("unplaceable");
+        var hash = Convert.ToHexString(SHA512.HashData(data)).ToLowerInvariant();
+        // A directory where the chunk file belongs makes the move fail
+        var blocker = Path.Combine(_cfg.DataPath, hash);
+        Directory.CreateDirectory(blocker);
+        Utilities.Log = new StreamWriter(Path.Combine(_tmpDir, "log"));
+
+        Assert.Equal(hash, _store.SaveData(data));
+        Assert.DoesNotContain(hash, _store.Arlist.Keys);
+        Assert.False(_store.Stats.ContainsKey("saved_blocks"));
+
+        Directory.Delete(blocker);
+        Assert.Equal(hash, _store.SaveData(data));
+        Assert.True(File.Exists(Path.Combine(_cfg.DataPath, _store.Arlist[hash], hash)));
+        Assert.Equal(1, _store.Stats["saved_blocks"]);
+        Assert.False(_store.Stats.ContainsKey("duplicate_blocks"));
+    }
+
     [Fact]
     public void SaveStream_Chunking_And_Progress()
     {
@@ -98,4 +120,430 @@ public class ArchiveStoreTests : IDisposable
         Assert.True(hashes.Count >= 1);
         Assert.True(callbackInvocations > 0);
     }
+
+    [Fact]
+    public void SaveBytes_ChunksLikeSaveStream()
+    {
+        var size = 1024 * 40; // two full 16 KiB chunks plus a partial one
+        var buffer = new byte[size];
+        new Random(7).NextBytes(buffer);
+
+        var processed = 0L;
+        var fromBytes = _store.SaveBytes(buffer, "test", bytes => processed += bytes);
+        using var mem = new MemoryStream(buffer);
+        var fromStream = _store.SaveStream(mem, size, "test");
+
+        Assert.Equal(3, fromBytes.Count);
+        Assert.Equal(fromStream, fromBytes);
+        Assert.Equal(size, processed);
+        Assert.Empty(_store.SaveBytes(ReadOnlySpan<byte>.Empty, "empty"));
+    }
+
+    [Fact]
+    public void SaveStream_LargeChunksStreamThroughTempFiles()
+    {
+        // Chunks larger than the read buffer, from a seekable and a forward-only stream
+        var cfg = new BackupConfig(_tmpDir, 9L << 20, true, false, 10);
+        var store = new ArchiveStore(cfg, UtilitiesLogger.Instance);
+        var size = 10 << 20;
+        var buffer = new byte[size];
+        var random = new Random(3);
+        for (var i = 0; i < size; i++)
+            buffer[i] = (byte)random.Next(16);
+
+        var processed = 0L;
+        var hashes = store.SaveStream(new ForwardOnlyStream(buffer), size, "test", bytes => processed += bytes);
+        Assert.Equal(size, processed);
+        Assert.Equal(2, hashes.Count);
+        Assert.Equal(Hash(buffer.AsSpan(0, 9 << 20)), hashes[0]);
+        Assert.Equal(Hash(buffer.AsSpan(9 << 20)), hashes[1]);
+        using (var fs = File.OpenRead(Path.Combine(cfg.DataPath, store.Arlist[hashes[0]], hashes[0])))
+        using (var bzip = new BZip2InputStream(fs))
+        using (var ms = new MemoryStream())
+        {
+            bzip.CopyTo(ms);
+            Assert.Equal(buffer.AsSpan(0, 9 << 20).ToArray(), ms.ToArray());
+        }
+
+        // Known chunks are recognized by hashing alone; nothing new is written
+        var files = Directory.GetFiles(cfg.DataPath, "*", SearchOption.AllDirectories).Length;
+        using var mem = new MemoryStream(buffer);
+        Assert.Equal(hashes, store.SaveStream(mem, size, "test"));
+        Assert.Equal(2, store.Stats["duplicate_blocks"]);
+        Assert.Equal(files, Directory.GetFiles(cfg.DataPath, "*", SearchOption.AllDirectories).Length);
+        Assert.Empty(Directory.GetFiles(cfg.DataPath, ".tmp-*"));
+
+        // Interrupted writes are cleaned up by the next index build
+        File.WriteAllText(Path.Combine(cfg.DataPath, ".tmp-leftover"), "partial");
+        new ArchiveStore(cfg, UtilitiesLogger.Instance).BuildIndex();
+        Assert.Empty(Directory.GetFiles(cfg.DataPath, ".tmp-*"));
+    }
+
+    [Fact]
+    public void SaveStream_PipelineMatchesSerialStorage()
+    {
+        // Ten 16 KiB chunks, two of them equal, plus a partial one
+        var size = 10 * 16384 + 1000;
+        var buffer = new byte[size];
+        new Random(11).NextBytes(buffer);
+        buffer.AsSpan(0, 16384).CopyTo(buffer.AsSpan(5 * 16384));
+        using var serialStream = new MemoryStream(buffer);
+        var serial = _store.SaveStream(serialStream, size, "test");
+
+        var cfg = new BackupConfig(Path.Combine(_tmpDir, "pipeline"), 1024 * 16, true, false, 10)
+        {
+            PipelineThreads = 3,
+        };
+        var store = new ArchiveStore(cfg, UtilitiesLogger.Instance);
+        var processed = 0L;
+        var piped = store.SaveStream(new ForwardOnlyStream(buffer), size, "test", bytes => processed += bytes);
+
+        Assert.Equal(serial, piped);
+        Assert.Equal(size, processed);
+        Assert.Equal(10, store.Stats["saved_blocks"]);
+        Assert.Equal(1, store.Stats["duplicate_blocks"]);
+        Assert.Equal(_store.PackSum, store.PackSum);
+        foreach (var stage in new[] { "read", "hash", "compress", "write", "wall" })
+            Assert.True(store.Stats.ContainsKey($"pipeline_{stage}_ms"));
+        foreach (var hash in piped.Distinct())
+            Assert.Equal(
+                File.ReadAllBytes(Path.Combine(_cfg.DataPath, _store.Arlist[hash], hash)),
+                File.ReadAllBytes(Path.Combine(cfg.DataPath, store.Arlist[hash], hash))
+            );
+        Assert.Empty(Directory.GetFiles(cfg.DataPath, ".tmp-*"));
+
+        // A read failure ends every stage and reaches the caller
+        Assert.Throws<IOException>(() => store.SaveStream(new ForwardOnlyStream(buffer, 3 * 16384), size, "test"));
+    }
+
+    [Fact]
+    public void SaveStream_StoresLargeChunksOfRangesConcurrently()
+    {
+        // Three 5 MiB chunks, the first and last equal, plus a partial one
+        const int chunk = 5 << 20;
+        var size = 3 * chunk + 1000;
+        var buffer = new byte[size];
+        var random = new Random(5);
+        for (var i = 0; i < size; i++)
+            buffer[i] = (byte)random.Next(16);
+        buffer.AsSpan(0, chunk).CopyTo(buffer.AsSpan(2 * chunk));
+        var cfg = new BackupConfig(_tmpDir, chunk, true, false, 10) { PipelineThreads = 3 };
+        var store = new ArchiveStore(cfg, UtilitiesLogger.Instance);
+
+        var processed = 0L;
+        using var stream = new RangeReadableStream(buffer);
+        var hashes = store.SaveStream(stream, size, "test", bytes => processed += bytes);
+
+        Assert.Equal(
+            [
+                Hash(buffer.AsSpan(0, chunk)),
+                Hash(buffer.AsSpan(chunk, chunk)),
+                Hash(buffer.AsSpan(0, chunk)),
+                Hash(buffer.AsSpan(3 * chunk)),
+            ],
+            hashes
+        );
+        Assert.Equal(size, stream.Position);
+        Assert.Equal(3, store.Stats["saved_blocks"]);
+        Assert.Equal(1, store.Stats["duplicate_blocks"]);
+        Assert.True(processed >= size);
+        Assert.Empty(Directory.GetFiles(cfg.DataPath, ".tmp-*"));
+
+        // A file shorter than announced ends the list at its last chunk
+        using var shorter = new RangeReadableStream(buffer.AsSpan(0, chunk + 10).ToArray());
+        Assert.Equal(hashes[..1].Append(Hash(buffer.AsSpan(chunk, 10))), store.SaveStream(shorter, size, "test"));
+    }
+
+    [Fact]
+    public void SaveStream_ContentDefinedChunksSurviveAnInsertion()
+    {
+        var cfg = new BackupConfig(_tmpDir, 1024 * 16, true, false, 10) { Chunking = "cdc:1024:4096:16384" };
+        var store = new ArchiveStore(cfg, UtilitiesLogger.Instance);
+        var size = 1 << 20;
+        var buffer = new byte[size];
+        new Random(13).NextBytes(buffer);
+
+        var processed = 0L;
+        var hashes = store.SaveStream(new ForwardOnlyStream(buffer), size, "test", bytes => processed += bytes);
+        Assert.Equal(size, processed);
+        Assert.Equal(hashes, store.SaveBytes(buffer, "test"));
+        // The chunks put together are the content again
+        using (var content = new MemoryStream())
+        {
+            foreach (var hash in hashes)
+            {
+                using var fs = File.OpenRead(Path.Combine(cfg.DataPath, store.Arlist[hash], hash));
+                using var bzip = new BZip2InputStream(fs);
+                bzip.CopyTo(content);
+            }
+
+            Assert.Equal(buffer, content.ToArray());
+        }
+
+        // One byte inserted near the start only changes the chunks around it, serially and pipelined
+        var shifted = buffer[..100].Append((byte)0x5a).Concat(buffer[100..]).ToArray();
+        var again = store.SaveStream(new MemoryStream(shifted), shifted.Length, "test");
+        Assert.True(again.Count(h => !hashes.Contains(h)) <= 2);
+        Assert.True(hashes.Count > size / 16384);
+        var piped = new ArchiveStore(
+            new BackupConfig(Path.Combine(_tmpDir, "pipeline"), 1024 * 16, true, false, 10)
+            {
+                Chunking = cfg.Chunking,
+                PipelineThreads = 3,
+            },
+            UtilitiesLogger.Instance
+        );
+        Assert.Equal(again, piped.SaveStream(new ForwardOnlyStream(shifted), shifted.Length, "test"));
+    }
+
+    [Fact]
+    public void Chunking_IsRecordedInTheArchive()
+    {
+        Assert.Equal("fixed", _store.Chunking);
+        var cfg = new BackupConfig(_tmpDir, 1024 * 16, true, false, 10) { Chunking = "CDC" };
+        Assert.Equal("cdc:262144:1048576:4194304", new ArchiveStore(cfg, UtilitiesLogger.Instance).Chunking);
+
+        // Without a setting the archive keeps the recorded chunking
+        Assert.Equal("cdc:262144:1048576:4194304", new ArchiveStore(_cfg, UtilitiesLogger.Instance).Chunking);
+        foreach (var invalid in new[] { "cdc:4096:1024:16384", "cdc:32:64:128", "cdc:1024:4096:2147483647", "rabin" })
+            Assert.Throws<ArgumentException>(() =>
+                new ArchiveStore(new BackupConfig(_tmpDir) { Chunking = invalid }, UtilitiesLogger.Instance)
+            );
+    }
+
+    [Fact]
+    public void SaveStream_RecordsZeroChunksWithoutStoringThem()
+    {
+        // 16 KiB chunks: data, two zero chunks, data and a partial one
+        var size = 4 * 16384 + 100;
+        var buffer = new byte[size];
+        new Random(17).NextBytes(buffer.AsSpan(0, 16384));
+        new Random(18).NextBytes(buffer.AsSpan(3 * 16384));
+        List<string> expected =
+        [
+            Hash(buffer.AsSpan(0, 16384)),
+            ArchiveStore.ZeroRunPrefix + 2 * 16384,
+            Hash(buffer.AsSpan(3 * 16384, 16384)),
+            Hash(buffer.AsSpan(4 * 16384)),
+        ];
+
+        Assert.Equal(expected, _store.SaveStream(new MemoryStream(buffer), size, "test"));
+        Assert.Equal(expected, _store.SaveBytes(buffer, "test"));
+        Assert.Equal(4, _store.Stats["zero_blocks"]);
+        Assert.Equal(4 * 16384, _store.Stats["zero_bytes"]);
+        Assert.False(_store.Arlist.ContainsKey(Hash(new byte[16384])));
+        var piped = new ArchiveStore(
+            new BackupConfig(Path.Combine(_tmpDir, "pipeline"), 1024 * 16, true, false, 10) { PipelineThreads = 2 },
+            UtilitiesLogger.Instance
+        );
+        Assert.Equal(expected, piped.SaveStream(new ForwardOnlyStream(buffer), size, "test"));
+
+        // Chunks larger than the read buffer, hashed first or compressed while hashed
+        var cfg = new BackupConfig(Path.Combine(_tmpDir, "large"), 9L << 20, true, false, 10);
+        var large = new ArchiveStore(cfg, UtilitiesLogger.Instance);
+        var zeros = new byte[10 << 20];
+        List<string> run = [ArchiveStore.ZeroRunPrefix + zeros.Length];
+        Assert.Equal(run, large.SaveStream(new MemoryStream(zeros), zeros.Length, "test"));
+        Assert.Equal(run, large.SaveStream(new ForwardOnlyStream(zeros), zeros.Length, "test"));
+        Assert.Empty(Directory.GetFiles(cfg.DataPath, "*", SearchOption.AllDirectories));
+
+        // Leading zeros of a chunk with other content are hashed with it
+        zeros[(9 << 20) - 1] = 1;
+        Assert.Equal(
+            [Hash(zeros.AsSpan(0, 9 << 20)), ArchiveStore.ZeroRunPrefix + (1 << 20)],
+            large.SaveStream(new MemoryStream(zeros), zeros.Length, "test")
+        );
+    }
+
+    [Fact]
+    public void SaveStream_RecordsHolesOfSparseFiles()
+    {
+        // A 1 MiB hole, data with a 4 KiB hole in it (read as data), and a trailing 1 MiB hole
+        const int hole = 1 << 20;
+        var size = hole + 40000 + hole;
+        var buffer = new byte[size];
+        new Random(19).NextBytes(buffer.AsSpan(hole, 20000));
+        new Random(20).NextBytes(buffer.AsSpan(hole + 24096, 40000 - 24096));
+        using var stream = new SparseStream(buffer, [(hole, hole + 20000), (hole + 24096, hole + 40000)]);
+
+        var processed = 0L;
+        var hashes = _store.SaveStream(stream, size, "test", bytes => processed += bytes);
+
+        Assert.Equal(
+            [
+                ArchiveStore.HolePrefix + hole,
+                Hash(buffer.AsSpan(hole, 16384)),
+                Hash(buffer.AsSpan(hole + 16384, 16384)),
+                Hash(buffer.AsSpan(hole + 32768, 40000 - 32768)),
+                ArchiveStore.HolePrefix + hole,
+            ],
+            hashes
+        );
+        Assert.Equal(2 * hole, _store.Stats["hole_bytes"]);
+        Assert.Equal(size, processed);
+        Assert.Equal(size, stream.Position);
+        // The holes were not read
+        Assert.Equal(40000, stream.BytesRead);
+
+        // A file that shrank in its trailing hole only has the hole up to its new end recorded
+        stream.SetLength(size - hole / 2);
+        stream.Position = 0;
+        var shrunk = _store.SaveStream(stream, size, "test");
+        Assert.Equal(hashes[..^1].Append(ArchiveStore.HolePrefix + hole / 2), shrunk);
+        Assert.Equal(size - hole / 2, stream.Position);
+
+        // Truncated at the end of its data, it has no trailing hole at all
+        stream.SetLength(hole + 40000);
+        stream.Position = 0;
+        var cut = _store.SaveStream(stream, size, "test");
+        Assert.Equal(hashes[..^1], cut);
+        Assert.Equal(hole + 40000, stream.Position);
+    }
+
+    [Fact]
+    public void SaveValue_AnswersRepeatsFromCache()
+    {
+        var acl = Encoding.UTF8.GetBytes("u::rw-,u:daemon:rwx,g::r--,m::rwx,o::r--");
+        var label = Encoding.UTF8.GetBytes("system_u:object_r:user_home_t:s0");
+
+        var first = _store.SaveValue(acl, "acl");
+        var again = _store.SaveValue((byte[])acl.Clone(), "acl");
+        var other = _store.SaveValue(label, "label");
+
+        Assert.Equal(_store.SaveBytes(acl, "acl"), first);
+        Assert.Equal(first, again);
+        Assert.NotEqual(first, other);
+        Assert.Equal(1, _store.Stats["value_cache_hits"]);
+        Assert.Equal(2, _store.Stats["value_cache_misses"]);
+
+        // Values longer than the limit are saved but not remembered
+        var large = new byte[8192];
+        Assert.Equal(_store.SaveValue(large, "large"), _store.SaveValue(large, "large"));
+        Assert.Equal(1, _store.Stats["value_cache_hits"]);
+    }
+
+    [Fact]
+    public void SaveValue_DropsLeastRecentlyUsedBeyondCapacity()
+    {
+        var store = new ArchiveStore(
+            new BackupConfig(_tmpDir, 1024 * 16, true, false, 10) { ValueCacheEntries = 2 },
+            UtilitiesLogger.Instance
+        );
+        byte[] a = [1];
+        byte[] b = [2];
+        byte[] c = [3];
+
+        store.SaveValue(a, "a");
+        store.SaveValue(b, "b");
+        store.SaveValue(a, "a"); // hit: b is now the least recently used
+        store.SaveValue(c, "c"); // evicts b
+        store.SaveValue(a, "a"); // hit
+        store.SaveValue(b, "b"); // miss
+
+        Assert.Equal(2, store.Stats["value_cache_hits"]);
+        Assert.Equal(4, store.Stats["value_cache_misses"]);
+    }
+
+    private static string Hash(ReadOnlySpan<byte> data)
+    {
+        return Convert.ToHexString(SHA512.HashData(data)).ToLowerInvariant();
+    }
+
+    // A sparse file: zeros outside the data extents, which are sorted
+    private sealed class SparseStream : MemoryStream, ISparseReadable
+    {
+        private readonly (long Start, long End)[] _extents;
+
+        public SparseStream(byte[] data, (long Start, long End)[] extents)
+            : base(data)
+        {
+            _extents = extents;
+        }
+
+        public long BytesRead { get; private set; }
+
+        public bool TryFindData(long offset, out long start, out long end)
+        {
+            foreach (var extent in _extents)
+                if (extent.End > offset)
+                {
+                    start = Math.Max(extent.Start, offset);
+                    end = extent.End;
+                    return true;
+                }
+
+            start = end = Length;
+            return false;
+        }
+
+        // Span reads of a derived MemoryStream come here too
+        public override int Read(byte[] buffer, int offset, int count)
+        {
+            var read = base.Read(buffer, offset, count);
+            BytesRead += read;
+            return read;
+        }
+    }
+
+    // A file-like source that can be read by ranges
+    private sealed class RangeReadableStream : MemoryStream, IRangeReadable
+    {
+        private readonly byte[] _data;
+
+        public RangeReadableStream(byte[] data)
+            : base(data)
+        {
+            _data = data;
+        }
+
+        public Stream OpenRange(long offset, long length)
+        {
+            var start = (int)Math.Min(offset, _data.Length);
+            return new MemoryStream(_data, start, (int)Math.Min(length, _data.Length - start));
+        }
+    }
+
+    // A pipe-like source: no seeking, short reads, optionally failing at an offset
+    private sealed class ForwardOnlyStream(byte[] data, int failAt = int.MaxValue) : Stream
+    {
+        private int _position;
+
+        public override bool CanRead => true;
+        public override bool CanSeek => false;
+        public override bool CanWrite => false;
+        public override long Length => throw new NotSupportedException();
+
+        public override long Position
+        {
+            get => throw new NotSupportedException();
+            set => throw new NotSupportedException();
+        }
+
+        public override int Read(byte[] buffer, int offset, int count)
+        {
+            if (_position >= failAt)
+                throw new IOException("read failed");
+            var n = Math.Min(Math.Min(count, 100_000), Math.Min(data.Length, failAt) - _position);
+            Array.Copy(data, _position, buffer, offset, n);
+            _position += n;
+            return n;
+        }
+
+        public override void Flush() { }
+
+        public override long Seek(long offset, SeekOrigin origin)
+        {
+            throw new NotSupportedException();
+        }
+
+        public override void SetLength(long value)
+        {
+            throw new NotSupportedException();
+        }
+
+        public override void Write(byte[] buffer, int offset, int count)
+        {
+            throw new NotSupportedException();
+        }
+    }
 }
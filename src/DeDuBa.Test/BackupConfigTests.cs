@@ -15,5 +15,48 @@ public class BackupConfigTests
         Assert.Equal(1024L * 1024L * 1024L, cfg.ChunkSize);
         Assert.True(cfg.Testing);
         Assert.False(cfg.Verbose);
+        Assert.Equal(4096, cfg.ValueCacheEntries);
+    }
+
+    [Fact]
+    public void FromUtilities_ReadsSchedulingFromEnvironment()
+    {
+        var oldThreads = Environment.GetEnvironmentVariable("DEDU_SCAN_THREADS");
+        var oldDiskOrder = Environment.GetEnvironmentVariable("DEDU_DISK_ORDER");
+        var oldNssPreload = Environment.GetEnvironmentVariable("DEDU_NSS_PRELOAD");
+        var oldPipeline = Environment.GetEnvironmentVariable("DEDU_PIPELINE_THREADS");
+        var oldChunking = Environment.GetEnvironmentVariable("DEDU_CHUNKING");
+        try
+        {
+            Environment.SetEnvironmentVariable("DEDU_SCAN_THREADS", "3");
+            Environment.SetEnvironmentVariable("DEDU_DISK_ORDER", "true");
+            Environment.SetEnvironmentVariable("DEDU_NSS_PRELOAD", "1");
+            Environment.SetEnvironmentVariable("DEDU_PIPELINE_THREADS", "4");
+            Environment.SetEnvironmentVariable("DEDU_CHUNKING", " cdc:4096:16384:65536 ");
+            var cfg = BackupConfig.FromUtilitiesWithOverride("/tmp/myarchive");
+            Assert.Equal(3, cfg.ScanThreads);
+            Assert.True(cfg.DiskOrder);
+            Assert.True(cfg.PreloadOwnerNames);
+            Assert.Equal(4, cfg.PipelineThreads);
+            Assert.Equal("cdc:4096:16384:65536", cfg.Chunking);
+
+            Environment.SetEnvironmentVariable("DEDU_SCAN_THREADS", "none");
+            Environment.SetEnvironmentVariable("DEDU_DISK_ORDER", null);
+            Environment.SetEnvironmentVariable("DEDU_PIPELINE_THREADS", "-1");
+            Environment.SetEnvironmentVariable("DEDU_CHUNKING", "");
+            cfg = BackupConfig.FromUtilitiesWithOverride("/tmp/myarchive");
+            Assert.Equal(0, cfg.ScanThreads);
+            Assert.False(cfg.DiskOrder);
+            Assert.Equal(0, cfg.PipelineThreads);
+            Assert.Null(cfg.Chunking);
+        }
+        finally
+        {
+            Environment.SetEnvironmentVariable("DEDU_SCAN_THREADS", oldThreads);
+            Environment.SetEnvironmentVariable("DEDU_DISK_ORDER", oldDiskOrder);
+            Environment.SetEnvironmentVariable("DEDU_NSS_PRELOAD", oldNssPreload);
+            Environment.SetEnvironmentVariable("DEDU_PIPELINE_THREADS", oldPipeline);
+            Environment.SetEnvironmentVariable("DEDU_CHUNKING", oldChunking);
+        }
     }
 }
@@ -194,6 +194,54 @@ public class HighLevelOsApiTests : IDisposable
         Assert.Throws<Exception>(() => _osApi.CreateMinimalInodeDataFromPath(nonExistentPath));
     }
 
+    [Fact]
+    public void TryCreateMinimalInodeDataFromPath_NonExistentFile_ReturnsErrorCode()
+    {
+        // ENOENT and ERROR_FILE_NOT_FOUND are both 2
+        const int notFound = 2;
+        var nonExistentPath = Path.Combine(_tmpDir, "does_not_exist.txt");
+
+        Assert.Equal(notFound, _osApi.TryCreateMinimalInodeDataFromPath(nonExistentPath, out var data));
+        Assert.Null(data);
+    }
+
+    [Fact]
+    public void TryCreateMinimalInodeDataFromPath_RegularFile_MatchesThrowingVariant()
+    {
+        var expected = _osApi.CreateMinimalInodeDataFromPath(_testFilePath);
+
+        Assert.Equal(0, _osApi.TryCreateMinimalInodeDataFromPath(_testFilePath, out var data));
+        Assert.NotNull(data);
+        Assert.Equal(expected.FileIndex, data.FileIndex);
+        Assert.Equal(expected.Mode, data.Mode);
+        Assert.Equal(expected.Size, data.Size);
+        Assert.Equal(expected.Flags, data.Flags);
+    }
+
+    [Fact]
+    public void DirectoryHandleOverloads_MatchPathVariants()
+    {
+        // Null on platforms without directory handles; the overloads then use the path
+        using var dir = _osApi.OpenDirectoryHandle(_tmpDir);
+
+        foreach (var path in new[] { _testFilePath, _testDirPath, _testSymlinkPath })
+        {
+            if (path is null)
+                continue;
+
+            Assert.Equal(0, _osApi.TryCreateMinimalInodeDataFromPath(path, out var expected));
+            Assert.Equal(0, _osApi.TryCreateMinimalInodeDataFromPath(dir, path, out var actual));
+            Assert.Equal(expected!.FileIndex, actual!.FileIndex);
+            Assert.Equal(expected.Flags, actual.Flags);
+
+            expected = _osApi.CompleteInodeDataFromPath(path, ref expected, _archiveStore);
+            actual = _osApi.CompleteInodeDataFromPath(dir, path, ref actual, _archiveStore);
+            Assert.Equal(expected.Hashes, actual.Hashes);
+            Assert.Equal(expected.Acl, actual.Acl);
+            Assert.Equal(expected.Xattr.Keys, actual.Xattr.Keys);
+        }
+    }
+
     [Fact]
     public void CreateMinimalInodeDataFromPath_ThenComplete_ProducesFullMetadata()
     {
@@ -247,6 +295,31 @@ public class HighLevelOsApiTests : IDisposable
         Assert.Equal(file2, entries[2]);
     }
 
+    [Fact]
+    public void ReadDirectory_MatchesListDirectoryAndMinimalData()
+    {
+        File.WriteAllText(Path.Combine(_testDirPath, "b.txt"), "b");
+        File.WriteAllText(Path.Combine(_testDirPath, "a.txt"), "a");
+        Directory.CreateDirectory(Path.Combine(_testDirPath, "c"));
+
+        var entries = _osApi.ReadDirectory(_testDirPath);
+
+        Assert.Equal(_osApi.ListDirectory(_testDirPath), entries.Select(e => e.Path));
+        foreach (var (path, data) in entries)
+        {
+            // Platforms without bulk metadata leave Data null
+            if (data is null)
+                continue;
+            Assert.Equal(0, _osApi.TryCreateMinimalInodeDataFromPath(path, out var expected));
+            Assert.Equal(expected!.FileIndex, data.FileIndex);
+            Assert.Equal(expected.Flags, data.Flags);
+            Assert.Equal(expected.Size, data.Size);
+            Assert.Equal(expected.MTime, data.MTime);
+        }
+
+        Assert.Throws<OsException>(() => _osApi.ReadDirectory(Path.Combine(_testDirPath, "missing")));
+    }
+
     [Fact]
     public void Canonicalizefilename_ReturnsCanonicalPath()
     {
@@ -9,6 +9,8 @@ using static OsCallsCommon.ValXfer;
 
 namespace DeDuBa.Test;
 
+// In the shared collection: the pool counters are process-wide, and every class using the shim runs in it
+[Collection("TestEnvironment")]
 public class OsCallsLinuxTests
 {
     private static string FindLibPath()
@@ -91,6 +93,77 @@ public class OsCallsLinuxTests
                 NativeLibrary.TryGetExport(handle, "linux_acl_get_file_default", out _),
                 "linux_acl_get_file_default must exist"
             );
+            Assert.True(NativeLibrary.TryGetExport(handle, "linux_lstat_into", out _), "linux_lstat_into must exist");
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_shim_get_api", out _),
+                "linux_shim_get_api must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_lstat_packed", out _),
+                "linux_lstat_packed must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_getpwuid_packed", out _),
+                "linux_getpwuid_packed must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_getgrgid_packed", out _),
+                "linux_getgrgid_packed must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_llistxattr_packed", out _),
+                "linux_llistxattr_packed must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_acl_get_file_access_packed", out _),
+                "linux_acl_get_file_access_packed must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_opendir_handle", out _),
+                "linux_opendir_handle must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_fstatat_into", out _),
+                "linux_fstatat_into must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_read_directory", out _),
+                "linux_read_directory must exist"
+            );
+            Assert.True(NativeLibrary.TryGetExport(handle, "linux_walk_open", out _), "linux_walk_open must exist");
+            Assert.True(NativeLibrary.TryGetExport(handle, "linux_walk_take", out _), "linux_walk_take must exist");
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_walk_close", out _),
+                "linux_walk_close must exist"
+            );
+            Assert.True(NativeLibrary.TryGetExport(handle, "linux_statx", out _), "linux_statx must exist");
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_fs_is_remote", out _),
+                "linux_fs_is_remote must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_data_offsets", out _),
+                "linux_data_offsets must exist"
+            );
+            Assert.True(
+                NativeLibrary.TryGetExport(handle, "linux_collect_inode", out _),
+                "linux_collect_inode must exist"
+            );
+            foreach (var name in new[] { "linux_lgetxattrs_packed", "linux_fgetxattrs_packed" })
+                Assert.True(NativeLibrary.TryGetExport(handle, name, out _), name + " must exist");
+            foreach (
+                var name in new[]
+                {
+                    "linux_user_name_packed",
+                    "linux_group_name_packed",
+                    "linux_name_cache_configure",
+                    "linux_name_cache_preload",
+                    "linux_open_content",
+                    "linux_read_content",
+                    "linux_find_data",
+                }
+            )
+                Assert.True(NativeLibrary.TryGetExport(handle, name, out _), name + " must exist");
         }
         finally
         {
@@ -136,6 +209,259 @@ public class OsCallsLinuxTests
         }
     }
 
+    [Fact]
+    public void LinuxLStatIntoMatchesCursorLStat()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var tmp = Path.GetTempFileName();
+        try
+        {
+            File.WriteAllText(tmp, "hello");
+            var j = FileSystem.LinuxLStat(tmp);
+            Assert.Equal(0, FileSystem.LinuxLStatInto(tmp, out var st));
+
+            Assert.Equal(j["st_dev"]!.GetValue<long>(), st.Dev);
+            Assert.Equal(j["st_ino"]!.GetValue<long>(), st.Ino);
+            Assert.Equal(j["st_mode"]!.GetValue<long>(), st.Mode);
+            Assert.Equal(j["st_nlink"]!.GetValue<long>(), st.NLink);
+            Assert.Equal(j["st_uid"]!.GetValue<long>(), st.Uid);
+            Assert.Equal(j["st_gid"]!.GetValue<long>(), st.Gid);
+            Assert.Equal(j["st_rdev"]!.GetValue<long>(), st.RDev);
+            Assert.Equal(5, st.Size);
+            Assert.Equal(j["st_size"]!.GetValue<long>(), st.Size);
+            Assert.Equal(j["st_blocks"]!.GetValue<long>(), st.Blocks);
+            Assert.Equal(
+                j["st_mtim"]!.GetValue<double>(),
+                st.MTim.TvSec + st.MTim.TvNsec / (double)(1000 * 1000 * 1000)
+            );
+
+            Assert.Equal(2, FileSystem.LinuxLStatInto(tmp + "-missing", out _)); // ENOENT
+        }
+        finally
+        {
+            File.Delete(tmp);
+        }
+    }
+
+    [Fact]
+    public unsafe void ShimApiTableIsVersionedAndSizeChecked()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var handle = NativeLibrary.Load(FindLibPath());
+        try
+        {
+            var getApi = (delegate* unmanaged[Cdecl]<uint, ulong*, int>)
+                NativeLibrary.GetExport(handle, "linux_shim_get_api");
+            var table = stackalloc ulong[64];
+
+            // Full table: size and version header, then non-null entries
+            new Span<ulong>(table, 64).Clear();
+            *(uint*)table = 64 * sizeof(ulong);
+            Assert.Equal(0, getApi(1, table));
+            var size = *(uint*)table;
+            Assert.True(size > 8 && size <= 64 * sizeof(ulong) && size % 8 == 0, $"size {size}");
+            Assert.Equal(1u, ((uint*)table)[1]);
+            for (var i = 1; i < size / 8; i++)
+                Assert.True(table[i] != 0, $"entry {i} is null");
+
+            // An older caller with a shorter table is never written past its size
+            new Span<ulong>(table, 64).Fill(0xdeadbeef);
+            *(uint*)table = 3 * sizeof(ulong);
+            Assert.Equal(0, getApi(1, table));
+            Assert.Equal(3u * sizeof(ulong), *(uint*)table);
+            Assert.Equal(0xdeadbeefUL, table[3]);
+
+            // Unknown version
+            *(uint*)table = 64 * sizeof(ulong);
+            Assert.Equal(95, getApi(2, table)); // ENOTSUP
+        }
+        finally
+        {
+            NativeLibrary.Free(handle);
+        }
+    }
+
+    [Fact]
+    public void PackedResultsMatchCursorResults()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var tmp = Path.GetTempFileName();
+        try
+        {
+            File.WriteAllText(tmp, "hello");
+            var j = FileSystem.LinuxLStat(tmp);
+            var st = FileSystem.LinuxLStatPacked(tmp);
+            Assert.Equal(0, FileSystem.LinuxLStatInto(tmp, out var flat));
+            Assert.Equal(flat, st);
+            Assert.Equal(j["st_ino"]!.GetValue<long>(), st.Ino);
+            Assert.Equal(
+                j["st_ctim"]!.GetValue<double>(),
+                st.CTim.TvSec + st.CTim.TvNsec / (double)(1000 * 1000 * 1000)
+            );
+            Assert.Throws<Exception>(() => FileSystem.LinuxLStatPacked(tmp + "-missing"));
+
+            var pw = UserGroupDatabase.GetPwUid(0);
+            var pwPacked = UserGroupDatabase.LinuxGetPwUidPacked(0);
+            Assert.Equal(pw["pw_name"]!.ToString(), pwPacked.Name);
+            Assert.Equal(pw["pw_dir"]!.ToString(), pwPacked.Dir);
+            Assert.Equal(pw["pw_shell"]!.ToString(), pwPacked.Shell);
+            Assert.Equal(0L, pwPacked.Uid);
+
+            var gr = UserGroupDatabase.GetGrGid(0);
+            var grPacked = UserGroupDatabase.LinuxGetGrGidPacked(0);
+            Assert.Equal(gr["gr_name"]!.ToString(), grPacked.Name);
+            Assert.Equal(0L, grPacked.Gid);
+            // The cursor transport reports an empty member list as {} rather than []
+            var members = gr["gr_mem"] is JsonArray mem ? mem.Select(m => m!.ToString()).ToArray() : [];
+            Assert.Equal(members, grPacked.Members.ToArray());
+
+            // An id without a database entry decodes to an empty record
+            Assert.Null(UserGroupDatabase.LinuxGetGrGidPacked(0x7ffffff0).Name);
+        }
+        finally
+        {
+            File.Delete(tmp);
+        }
+    }
+
+    [Fact]
+    public void PackedAndCursorTransportsAreTimedOnTheSameLookups()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        // The local group with the longest member list, where the transports differ most
+        var gid = File.Exists("/etc/group")
+            ? File.ReadLines("/etc/group")
+                .Select(line => line.Split(':'))
+                .Where(f => f.Length == 4 && long.TryParse(f[2], out _))
+                .OrderByDescending(f => f[3].Length)
+                .Select(f => long.Parse(f[2]))
+                .FirstOrDefault()
+            : 0;
+        var tmp = Path.GetTempFileName();
+        try
+        {
+            var gr = UserGroupDatabase.LinuxGetGrGid(gid);
+            var members = gr["gr_mem"] is JsonArray mem ? mem.Select(m => m!.ToString()).ToArray() : [];
+            Assert.Equal(members, UserGroupDatabase.LinuxGetGrGidPacked(gid).Members.ToArray());
+
+            // ValXfer.ToNode walks the cursor with one P/Invoke per value; DecodePacked reads one buffer
+            var lookups = new (string Name, Func<object> Cursor, Func<object> Packed)[]
+            {
+                ("lstat", () => FileSystem.LinuxLStat(tmp), () => FileSystem.LinuxLStatPacked(tmp)),
+                (
+                    "getpwuid(0)",
+                    () => UserGroupDatabase.LinuxGetPwUid(0),
+                    () => UserGroupDatabase.LinuxGetPwUidPacked(0)
+                ),
+                (
+                    $"getgrgid({gid}), {members.Length} members",
+                    () => UserGroupDatabase.LinuxGetGrGid(gid),
+                    () => UserGroupDatabase.LinuxGetGrGidPacked(gid)
+                ),
+            };
+            foreach (var (name, cursor, packed) in lookups)
+            {
+                var cursorNs = TimeNs(cursor);
+                var packedNs = TimeNs(packed);
+                var ratio = cursorNs / packedNs;
+                Console.WriteLine(
+                    $"[BENCH] {name, -32} ToNode {cursorNs, 8:F0} ns, DecodePacked {packedNs, 8:F0} ns ({ratio:F2}x)"
+                );
+            }
+        }
+        finally
+        {
+            File.Delete(tmp);
+        }
+    }
+
+    // Mean time of one call after a warm-up, in nanoseconds
+    private static double TimeNs(Func<object> call)
+    {
+        for (var i = 0; i < 200; i++)
+            call();
+        const int iterations = 2000;
+        var watch = Stopwatch.StartNew();
+        for (var i = 0; i < iterations; i++)
+            call();
+        return watch.Elapsed.TotalNanoseconds / iterations;
+    }
+
+    [Fact]
+    public void NameCacheMatchesDatabaseLookups()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        try
+        {
+            foreach (var ttl in new[] { 0, 600 })
+            {
+                Assert.Equal(
+                    0,
+                    UserGroupDatabase.ConfigureNameCache(TimeSpan.FromSeconds(ttl), TimeSpan.FromMinutes(1))
+                );
+                // Twice: the second answer comes from the cache when it is enabled
+                for (var round = 0; round < 2; round++)
+                {
+                    Assert.Equal(UserGroupDatabase.LinuxGetPwUidPacked(0).Name, UserGroupDatabase.LinuxGetUserName(0));
+                    Assert.Equal(UserGroupDatabase.LinuxGetGrGidPacked(0).Name, UserGroupDatabase.LinuxGetGroupName(0));
+                    Assert.Null(UserGroupDatabase.LinuxGetUserName(0x7ffffff0));
+                    Assert.Null(UserGroupDatabase.LinuxGetGroupName(0x7ffffff0));
+                }
+            }
+
+            Assert.Equal(0, UserGroupDatabase.PreloadNameCache(out var users, out var groups));
+            Assert.True(users > 0);
+            Assert.True(groups > 0);
+            Assert.Equal(UserGroupDatabase.LinuxGetPwUidPacked(0).Name, UserGroupDatabase.LinuxGetUserName(0));
+
+            Assert.Equal(22, UserGroupDatabase.ConfigureNameCache(TimeSpan.FromSeconds(-1), TimeSpan.Zero)); // EINVAL
+        }
+        finally
+        {
+            UserGroupDatabase.ConfigureNameCache(TimeSpan.FromMinutes(10), TimeSpan.FromMinutes(1));
+        }
+    }
+
+    [Fact]
+    public void CursorPoolDoesNotLeakHandles()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var tmp = Path.GetTempFileName();
+        var missing = tmp + "-missing";
+        try
+        {
+            void Calls()
+            {
+                FileSystem.LStat(tmp);
+                UserGroupDatabase.GetGrGid(0);
+                Xattr.ListXattr(tmp);
+                Assert.Throws<Exception>(() => FileSystem.LStat(missing));
+            }
+
+            // Warm up this thread's free lists with the same calls, then measure
+            for (var i = 0; i < 10; i++)
+                Calls();
+            var before = GetPoolStats();
+            for (var i = 0; i < 1000; i++)
+                Calls();
+            var after = GetPoolStats();
+
+            Assert.Equal(before.LiveHandles, after.LiveHandles);
+            // Steady state is served from the free lists, not the heap
+            Assert.Equal(0, after.HeapAllocs - before.HeapAllocs);
+        }
+        finally
+        {
+            File.Delete(tmp);
+        }
+    }
+
     [Fact]
     public unsafe void LinuxGetpwuidAndWrapperProduceSameOutput()
     {
@@ -175,6 +501,468 @@ public class OsCallsLinuxTests
         }
     }
 
+    [Fact]
+    public void HandleRelativeCallsMatchPathCalls()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENOENT = 2;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_at_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            var file = Path.Combine(dir, "file");
+            var link = Path.Combine(dir, "link");
+            File.WriteAllText(file, "hello");
+            File.CreateSymbolicLink(link, "file");
+
+            Assert.Equal(0, FileSystem.TryOpenDirectory(dir, out var handle));
+            using (handle)
+            {
+                foreach (var path in new[] { file, link })
+                {
+                    Assert.Equal(0, FileSystem.TryLStat(path, out var expected));
+                    Assert.Equal(0, FileSystem.TryLStatAt(handle!, Path.GetFileName(path), out var actual));
+                    Assert.Equal(expected, actual);
+                }
+
+                Assert.Equal(0, FileSystem.TryLStatAt(handle!, "", out var self));
+                Assert.Equal(0, FileSystem.TryLStat(dir, out var dirStat));
+                Assert.Equal(dirStat.Ino, self.Ino);
+
+                Assert.Equal(
+                    FileSystem.ReadLink(link).ToJsonString(),
+                    FileSystem.ReadLinkAt(handle!, "link").ToJsonString()
+                );
+
+                Assert.Equal(0, FileSystem.TryOpenReadAt(handle!, "file", out var fd));
+                using (var stream = new FileStream(fd!, FileAccess.Read))
+                using (var reader = new StreamReader(stream))
+                    Assert.Equal("hello", reader.ReadToEnd());
+
+                // O_NOFOLLOW: the symlink itself cannot be opened for reading
+                Assert.NotEqual(0, FileSystem.TryOpenReadAt(handle!, "link", out var none));
+                Assert.Null(none);
+
+                Assert.Equal(ENOENT, FileSystem.TryLStatAt(handle!, "missing", out _));
+                Assert.Equal(ENOENT, FileSystem.TryOpenAt(handle!, "missing", out var missing));
+                Assert.Null(missing);
+            }
+
+            Assert.True(handle!.IsClosed);
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void ReadDirectoryMatchesEnumerationAndLStat()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENOENT = 2;
+        const byte DT_DIR = 4;
+        const byte DT_REG = 8;
+        const byte DT_LNK = 10;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_readdir_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            // Long names so the listing spans several 64 KiB getdents64 batches
+            var padding = new string('x', 200);
+            for (var i = 0; i < 1000; i++)
+                File.WriteAllText(Path.Combine(dir, $"file{i:d4}{padding}"), "");
+            Directory.CreateDirectory(Path.Combine(dir, "sub"));
+            File.CreateSymbolicLink(Path.Combine(dir, "link"), "missing");
+
+            Assert.Equal(0, FileSystem.TryReadDirectory(dir, true, out var entries));
+            // With stat, entries are stat-ed and returned in inode order
+            Assert.Equal(entries!.Select(e => (ulong)e.Ino).Order(), entries!.Select(e => (ulong)e.Ino));
+            foreach (var entry in entries!)
+            {
+                Assert.Equal(0, FileSystem.TryLStat(Path.Combine(dir, entry.Name), out var expected));
+                Assert.Equal(0, entry.StatError);
+                Assert.Equal(expected, entry.Stat);
+                Assert.Equal(expected.Ino, entry.Ino);
+            }
+
+            // Compared last: .NET's enumeration follows the symlink, which may update its atime
+            Assert.Equal(
+                Directory.GetFileSystemEntries(dir).Select(Path.GetFileName).Order(StringComparer.Ordinal),
+                entries!.Select(e => e.Name).Order(StringComparer.Ordinal)
+            );
+
+            var types = entries!.ToDictionary(e => e.Name, e => e.Type);
+            // d_type is optional; where the filesystem reports it, it must agree with lstat
+            if (types["sub"] != 0)
+            {
+                Assert.Equal(DT_DIR, types["sub"]);
+                Assert.Equal(DT_LNK, types["link"]);
+                Assert.Equal(DT_REG, types[$"file0000{padding}"]);
+            }
+
+            Assert.Equal(0, FileSystem.TryReadDirectory(dir, false, out var names));
+            Assert.All(names!, e => Assert.Null(e.Stat));
+            Assert.Equal(entries!.Count, names!.Count);
+
+            Assert.Equal(ENOENT, FileSystem.TryReadDirectory(Path.Combine(dir, "missing"), false, out var none));
+            Assert.Null(none);
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void StatxMatchesLStat()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int EINVAL = 22;
+        const int ENOENT = 2;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_statx_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            var file = Path.Combine(dir, "file");
+            File.WriteAllText(file, "statx");
+            File.CreateSymbolicLink(Path.Combine(dir, "link"), "file");
+            var all = FileSystem.StatxMask.BasicStats | FileSystem.StatxMask.BTime | FileSystem.StatxMask.MntId;
+
+            foreach (var name in new[] { "file", "link" })
+            {
+                var path = Path.Combine(dir, name);
+                Assert.Equal(0, FileSystem.TryLStat(path, out var st));
+                Assert.Equal(0, FileSystem.TryStatx(path, all, FileSystem.StatxSync.AsStat, out var stx));
+                Assert.True(stx.Mask.HasFlag(FileSystem.StatxMask.BasicStats));
+                Assert.Equal(st.Dev, stx.Dev);
+                Assert.Equal(st.Ino, stx.Ino);
+                Assert.Equal(st.Mode, stx.Mode);
+                Assert.Equal(st.NLink, stx.NLink);
+                Assert.Equal(st.Uid, stx.Uid);
+                Assert.Equal(st.Gid, stx.Gid);
+                Assert.Equal(st.Size, stx.Size);
+                Assert.Equal(st.MTim, stx.MTime);
+                Assert.Equal(st.CTim, stx.CTime);
+            }
+
+            Assert.Equal(0, FileSystem.TryOpenDirectory(dir, out var handle));
+            using (handle)
+            {
+                Assert.Equal(0, FileSystem.TryIsRemote(handle!, out _));
+                Assert.Equal(0, FileSystem.TryLStat(file, out var st));
+                Assert.Equal(
+                    0,
+                    FileSystem.TryStatxAt(
+                        handle!,
+                        "file",
+                        FileSystem.StatxMask.Type | FileSystem.StatxMask.Ino,
+                        FileSystem.StatxSync.DontSync,
+                        out var stx
+                    )
+                );
+                Assert.True(stx.Mask.HasFlag(FileSystem.StatxMask.Type | FileSystem.StatxMask.Ino));
+                Assert.Equal(st.Ino, stx.Ino);
+                Assert.Equal(ENOENT, FileSystem.TryStatxAt(handle!, "missing", FileSystem.StatxMask.Ino, 0, out _));
+            }
+
+            // AT_STATX_FORCE_SYNC | AT_STATX_DONT_SYNC is not a sync mode
+            var invalidSync = FileSystem.StatxSync.ForceSync | FileSystem.StatxSync.DontSync;
+            Assert.Equal(EINVAL, FileSystem.TryStatx(file, FileSystem.StatxMask.Ino, invalidSync, out _));
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void CollectInodeMatchesSeparateCalls()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENOENT = 2;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_collect_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            File.WriteAllText(Path.Combine(dir, "file"), "collect");
+            var target = new string('t', 300) + "/\u00e9";
+            File.CreateSymbolicLink(Path.Combine(dir, "link"), target);
+            var all = FileSystem.CollectParts.Owner | FileSystem.CollectParts.Acl | FileSystem.CollectParts.Link;
+
+            Assert.Equal(0, FileSystem.TryOpenDirectory(dir, out var handle));
+            using (handle)
+                foreach (var name in new[] { "file", "link", "." })
+                {
+                    var path = Path.Combine(dir, name);
+                    Assert.Equal(0, FileSystem.TryCollectInode(path, all, out var byPath));
+                    Assert.Equal(0, FileSystem.TryCollectInodeAt(handle!, name, all, out var byHandle));
+                    Assert.Equal(0, FileSystem.TryLStat(path, out var st));
+                    foreach (var metadata in new[] { byPath!, byHandle! })
+                    {
+                        Assert.Equal(st.Ino, metadata.Stat.Ino);
+                        Assert.Equal(st.Mode, metadata.Stat.Mode);
+                        Assert.Equal(st.MTim, metadata.Stat.MTim);
+                        Assert.Equal(UserGroupDatabase.LinuxGetPwUidPacked(st.Uid).Name, metadata.UserName);
+                        Assert.Equal(UserGroupDatabase.LinuxGetGrGidPacked(st.Gid).Name, metadata.GroupName);
+                        Assert.Equal(0, metadata.LinkError);
+                        if (name == "link")
+                            Assert.Equal(System.Text.Encoding.UTF8.GetBytes(target), metadata.LinkTarget);
+                        else
+                            Assert.Null(metadata.LinkTarget);
+                        // Symlinks carry no ACLs; elsewhere it is what acl_get_file reads, if supported
+                        if (name == "link")
+                            Assert.Null(metadata.AccessAcl);
+                        else
+                            Assert.Equal(Acl.TryGetFileAccess(path, out var acl) == 0 ? acl : null, metadata.AccessAcl);
+                    }
+                }
+
+            Assert.Equal(ENOENT, FileSystem.TryCollectInode(Path.Combine(dir, "missing"), 0, out var missing));
+            Assert.Null(missing);
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void ContentStreamReadsWholeFile()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENOENT = 2;
+        const int ELOOP = 40;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_content_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            // Several pages plus a partial one, read in pieces that do not line up with pages
+            var content = new byte[3 * 4096 + 1234];
+            new Random(42).NextBytes(content);
+            var path = Path.Combine(dir, "file");
+            File.WriteAllBytes(path, content);
+            File.CreateSymbolicLink(Path.Combine(dir, "link"), path);
+
+            foreach (var dropBehind in new[] { true, false })
+            {
+                Assert.Equal(0, FileSystem.TryOpenContent(path, out var file));
+                using var stream = new ContentStream(file!, dropBehind);
+                var read = new MemoryStream();
+                var buffer = new byte[1000];
+                int n;
+                while ((n = stream.Read(buffer, 0, buffer.Length)) > 0)
+                    read.Write(buffer, 0, n);
+                Assert.Equal(content, read.ToArray());
+                Assert.Equal(content.Length, stream.Position);
+                Assert.Equal(content.Length, stream.Length);
+
+                // Rewound, the same bytes again
+                stream.Position = 5000;
+                Assert.Equal(1000, stream.Read(buffer, 0, buffer.Length));
+                Assert.Equal(content.AsSpan(5000, 1000).ToArray(), buffer);
+                Assert.Equal(content.Length - 10, stream.Seek(-10, SeekOrigin.End));
+
+                // A range reads independently of the stream and ends at its end
+                using (var range = stream.OpenRange(4000, 9000))
+                {
+                    var part = new byte[10000];
+                    Assert.Equal(9000, range.ReadAtLeast(part, part.Length, false));
+                    Assert.Equal(content.AsSpan(4000, 9000).ToArray(), part[..9000]);
+                }
+
+                Assert.Equal(content.Length - 10, stream.Position);
+                Assert.Equal(10, stream.Read(buffer, 0, buffer.Length));
+            }
+
+            Assert.Equal(0, FileSystem.TryOpenDirectory(dir, out var handle));
+            using (handle)
+            {
+                using (var stream = ContentStream.Open(handle, "file"))
+                {
+                    var whole = new byte[content.Length + 100];
+                    Assert.Equal(content.Length, stream.Read(whole));
+                    Assert.Equal(content, whole[..content.Length]);
+                    Assert.Equal(0, stream.Read(whole));
+                }
+
+                // Like the inode metadata, content is never read through a symlink
+                Assert.Equal(ELOOP, FileSystem.TryOpenContentAt(handle!, "link", out var link));
+                Assert.Null(link);
+            }
+
+            Assert.Equal(ENOENT, FileSystem.TryOpenContent(Path.Combine(dir, "missing"), out var missing));
+            Assert.Null(missing);
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void ContentStreamFindsDataOfSparseFile()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENXIO = 6;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_sparse_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            // 1 MiB of data after a 4 MiB hole, then a 4 MiB hole up to end of file
+            var path = Path.Combine(dir, "sparse");
+            var data = new byte[1 << 20];
+            new Random(7).NextBytes(data);
+            using (var writer = new FileStream(path, FileMode.CreateNew))
+            {
+                writer.Position = 4 << 20;
+                writer.Write(data);
+                writer.SetLength(9 << 20);
+            }
+
+            Assert.Equal(0, FileSystem.TryOpenContent(path, out var file));
+            using var stream = new ContentStream(file!);
+            Assert.True(stream.TryFindData(0, out var start, out var end));
+            // Filesystems without hole tracking report all of the file as data
+            if (start == 0)
+            {
+                Assert.Equal(9 << 20, end);
+                return;
+            }
+
+            // Allocation may round the data out to larger blocks
+            Assert.InRange(start, 1, 4 << 20);
+            Assert.InRange(end, 5 << 20, 9 << 20);
+            Assert.True(stream.TryFindData(4 << 20, out var again, out _));
+            Assert.Equal(4 << 20, again);
+            if (end < 9 << 20)
+            {
+                Assert.False(stream.TryFindData(end, out _, out _));
+                Assert.Equal(ENXIO, FileSystem.TryFindData(file!, end, out _, out _));
+            }
+
+            // A range ends where it ends, also for finding data
+            using var range = (ContentStream)stream.OpenRange(0, start);
+            Assert.False(range.TryFindData(0, out _, out _));
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void DataOffsetsReportFirstExtent()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var dir = Path.Combine(Path.GetTempPath(), "deduba_fiemap_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(dir);
+        try
+        {
+            foreach (var name in new[] { "a", "b" })
+            {
+                using var stream = new FileStream(Path.Combine(dir, name), FileMode.CreateNew);
+                stream.Write(new byte[64 * 1024]);
+                stream.Flush(true); // allocate the extents now instead of at writeback
+            }
+
+            File.WriteAllText(Path.Combine(dir, "empty"), "");
+            Assert.Equal(0, FileSystem.TryOpenDirectory(dir, out var handle));
+            using (handle)
+            {
+                var offsets = new long[4];
+                Assert.Equal(0, FileSystem.TryGetDataOffsets(handle!, ["a", "b", "empty", "missing"], offsets));
+                Assert.Equal(-1, offsets[2]);
+                Assert.Equal(-1, offsets[3]);
+                // Filesystems without FIEMAP (tmpfs) report -1; where known, the two files cannot share an extent
+                if (offsets[0] >= 0 && offsets[1] >= 0)
+                    Assert.NotEqual(offsets[0], offsets[1]);
+            }
+        }
+        finally
+        {
+            Directory.Delete(dir, true);
+        }
+    }
+
+    [Fact]
+    public void DirectoryWalkerMatchesReadDirectory()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        const int ENOENT = 2;
+        var root = Path.Combine(Path.GetTempPath(), "deduba_walk_" + Guid.NewGuid().ToString("N"));
+        Directory.CreateDirectory(root);
+        try
+        {
+            for (var i = 0; i < 8; i++)
+            for (var j = 0; j < 8; j++)
+            {
+                var sub = Path.Combine(root, $"d{i}", $"e{j}");
+                Directory.CreateDirectory(sub);
+                for (var k = 0; k < 4; k++)
+                    File.WriteAllText(Path.Combine(sub, $"f{k}"), "");
+            }
+
+            var excluded = Path.Combine(root, "d7");
+            Assert.Equal(0, DirectoryWalker.TryOpen([root], [excluded], 4, 0, out var walker));
+            using (walker)
+            {
+                // Breadth-first like the backup traversal; excluded subtrees are read on demand
+                var queue = new Queue<string>([root]);
+                var visited = 0;
+                while (queue.Count > 0)
+                {
+                    var dir = queue.Dequeue();
+                    Assert.Equal(0, FileSystem.TryLStat(dir, out var st));
+                    Assert.Equal(0, walker!.TryTake(dir, st.Dev, st.Ino, out var taken));
+                    Assert.Equal(0, FileSystem.TryReadDirectory(dir, true, out var expected));
+                    Assert.Equal(
+                        expected!.Select(e => (e.Name, e.Ino, e.Stat!.Value.Mode)).Order(),
+                        taken!.Select(e => (e.Name, e.Ino, e.Stat!.Value.Mode)).Order()
+                    );
+                    foreach (var entry in taken!.Where(e => e.Name.StartsWith('d') || e.Name.StartsWith('e')))
+                        queue.Enqueue(Path.Combine(dir, entry.Name));
+                    visited++;
+                }
+
+                Assert.Equal(1 + 8 + 64, visited);
+                Assert.Equal(ENOENT, walker!.TryTake(Path.Combine(root, "missing"), 0, 0, out var none));
+                Assert.Null(none);
+            }
+        }
+        finally
+        {
+            Directory.Delete(root, true);
+        }
+    }
+
+    [Fact]
+    public void ReadLinkReturnsLongTargetsIntact()
+    {
+        if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            return;
+        var link = Path.Combine(Path.GetTempPath(), "deduba_longlink_" + Guid.NewGuid().ToString("N"));
+        // Longer than the initial readlink buffer, so the native side has to grow it
+        var target = string.Join('/', Enumerable.Repeat(new string('t', 200), 8));
+        File.CreateSymbolicLink(link, target);
+        try
+        {
+            Assert.Equal(target, FileSystem.ReadLink(link)["path"]!.GetValue<string>());
+        }
+        finally
+        {
+            File.Delete(link);
+        }
+    }
+
     [Fact]
     public void CSharpLinuxWrappersMirrorMethods()
     {
@@ -135,6 +135,31 @@ public class XattrTests : IDisposable
         Assert.Equal("This is a test file", obj["value"]?.ToString());
     }
 
+    [Fact]
+    public void GetXattrBytes_ReturnsExactBinaryValue()
+    {
+        // Arrange - embedded NUL and invalid UTF-8 must survive unchanged
+        SetXattr(_testFilePath, "user.binary", "0x00ff7f0a00");
+
+        // Act
+        var bytes = Xattr.LinuxGetXattrBytes(_testFilePath, "user.binary", span => span.ToArray());
+
+        // Assert
+        Assert.Equal(new byte[] { 0x00, 0xff, 0x7f, 0x0a, 0x00 }, bytes);
+    }
+
+    [Fact]
+    public void GetXattrBytes_WithNonExistentAttribute_ThrowsException()
+    {
+        var ex = Assert.Throws<Exception>(() =>
+        {
+            Xattr.LinuxGetXattrBytes(_testFilePath, "user.nonexistent", span => span.Length);
+        });
+
+        Assert.NotNull(ex.InnerException);
+        Assert.IsType<Win32Exception>(ex.InnerException);
+    }
+
     [Fact]
     public void GetXattr_WithNonExistentAttribute_ThrowsException()
     {
@@ -150,6 +175,75 @@ public class XattrTests : IDisposable
         Assert.IsType<Win32Exception>(ex.InnerException);
     }
 
+    [Fact]
+    public void ListXattrPacked_MatchesCursorListing()
+    {
+        var names = Xattr.LinuxListXattrPacked(_testFilePath);
+        var expected = Xattr.ListXattr(_testFilePath).AsArray().Select(n => n!.ToString()).ToArray();
+
+        Assert.Equal(expected, names);
+        Assert.Equal(3, names.Length);
+    }
+
+    [Fact]
+    public void ListXattrPacked_WithNonExistentFile_ThrowsException()
+    {
+        var nonExistentPath = "/tmp/nonexistent_file_" + Guid.NewGuid() + ".txt";
+
+        var ex = Assert.Throws<Exception>(() => Xattr.LinuxListXattrPacked(nonExistentPath));
+
+        Assert.IsType<Win32Exception>(ex.InnerException);
+    }
+
+    [Fact]
+    public void TryListXattr_MatchesPackedListing()
+    {
+        Assert.Equal(0, Xattr.TryListXattr(_testFilePath, out var names));
+        Assert.Equal(Xattr.LinuxListXattrPacked(_testFilePath), names);
+    }
+
+    [Fact]
+    public void TryListXattr_ThroughHandle_MatchesPathResults()
+    {
+        Assert.Equal(0, FileSystem.TryOpenDirectory(Path.GetDirectoryName(_testFilePath)!, out var dir));
+        using (dir)
+        {
+            Assert.Equal(0, FileSystem.TryOpenAt(dir!, Path.GetFileName(_testFilePath), out var entry));
+            using (entry)
+            {
+                Assert.Equal(0, Xattr.TryListXattr(entry!, out var names));
+                Assert.Equal(Xattr.LinuxListXattrPacked(_testFilePath), names);
+
+                foreach (var name in names!)
+                {
+                    Assert.Equal(0, Xattr.TryGetXattrBytes(entry!, name, bytes => bytes.ToArray(), out var value));
+                    Assert.Equal(Xattr.LinuxGetXattrBytes(_testFilePath, name, bytes => bytes.ToArray()), value);
+                }
+            }
+        }
+    }
+
+    [Fact]
+    public void TryListXattr_WithNonExistentFile_ReturnsErrno()
+    {
+        const int ENOENT = 2;
+        var nonExistentPath = "/tmp/nonexistent_file_" + Guid.NewGuid() + ".txt";
+
+        Assert.Equal(ENOENT, Xattr.TryListXattr(nonExistentPath, out var names));
+        Assert.Null(names);
+    }
+
+    [Fact]
+    public void TryGetXattrBytes_WithMissingAttribute_ReturnsEnodata()
+    {
+        const int ENODATA = 61;
+
+        var rc = Xattr.TryGetXattrBytes(_testFilePath, "user.nonexistent", bytes => bytes.Length, out var length);
+
+        Assert.Equal(ENODATA, rc);
+        Assert.Equal(0, length);
+    }
+
     [Fact]
     public void ListXattr_WithNonExistentFile_ThrowsException()
     {
@@ -229,5 +323,69 @@ public class XattrTests : IDisposable
                 File.Delete(symlinkPath);
         }
     }
+
+    [Fact]
+    public void CollectInode_ReturnsXattrValuesOfWantedNamespaces()
+    {
+        // Act
+        var rc = FileSystem.TryCollectInode(_testFilePath, FileSystem.CollectParts.Xattrs, out var metadata);
+        var filteredRc = FileSystem.TryCollectInode(
+            _testFilePath,
+            FileSystem.CollectParts.XattrSecurity,
+            out var filtered
+        );
+
+        // Assert - same names and bytes as listing and reading them one by one
+        Assert.Equal(0, rc);
+        Assert.Equal(0, Xattr.TryListXattr(_testFilePath, out var names));
+        Assert.Equal(names, metadata!.Xattrs.Select(x => x.Key));
+        foreach (var (name, value) in metadata.Xattrs)
+            Assert.Equal(Xattr.LinuxGetXattrBytes(_testFilePath, name, span => span.ToArray()), value);
+        Assert.Equal(0, filteredRc);
+        Assert.DoesNotContain(filtered!.Xattrs, x => x.Key.StartsWith("user."));
+        Assert.Null(filtered.UserName);
+        Assert.Null(filtered.LinkTarget);
+    }
+
+    [Fact]
+    public void TryGetXattrValues_ReturnsEveryValueInOneCall()
+    {
+        // Larger than the initial native scratch buffer, so the ERANGE retry is taken
+        var large = new string('v', 3000);
+        SetXattr(_testFilePath, "user.large", large);
+
+        // Act
+        var rc = Xattr.TryGetXattrValues(_testFilePath, Xattr.XattrNamespaces.All, out var xattrs);
+
+        // Assert
+        Assert.Equal(0, rc);
+        Assert.Equal(0, Xattr.TryListXattr(_testFilePath, out var names));
+        Assert.Equal(names, xattrs!.Select(x => x.Key));
+        foreach (var (name, value) in xattrs)
+            Assert.Equal(Xattr.LinuxGetXattrBytes(_testFilePath, name, span => span.ToArray()), value);
+        Assert.Equal(large, System.Text.Encoding.UTF8.GetString(xattrs.Single(x => x.Key == "user.large").Value));
+
+        Assert.Equal(0, Xattr.TryGetXattrValues(_testFilePath, Xattr.XattrNamespaces.Trusted, out var trusted));
+        Assert.DoesNotContain(trusted!, x => x.Key.StartsWith("user."));
+
+        Assert.Equal(0, FileSystem.TryOpenDirectory(Path.GetDirectoryName(_testFilePath)!, out var dir));
+        using (dir)
+        {
+            Assert.Equal(0, FileSystem.TryOpenAt(dir!, Path.GetFileName(_testFilePath), out var entry));
+            using (entry)
+            {
+                Assert.Equal(0, Xattr.TryGetXattrValues(entry!, Xattr.XattrNamespaces.User, out var byHandle));
+                Assert.Equal(xattrs.Select(x => x.Key), byHandle!.Select(x => x.Key));
+                Assert.Equal(
+                    xattrs.Select(x => Convert.ToHexString(x.Value)),
+                    byHandle.Select(x => Convert.ToHexString(x.Value))
+                );
+            }
+        }
+
+        const int ENOENT = 2;
+        Assert.Equal(ENOENT, Xattr.TryGetXattrValues(_testFilePath + ".missing", 0, out var missing));
+        Assert.Null(missing);
+    }
 }
 #endif
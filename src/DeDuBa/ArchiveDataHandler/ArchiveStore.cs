@@ -1,7 +1,10 @@
+using System.Buffers;
 using System.Collections.Concurrent;
+using System.Runtime.ExceptionServices;
 using System.Security.Cryptography;
 using System.Text.RegularExpressions;
 using ICSharpCode.SharpZipLib.BZip2;
+using OsCallsCommon;
 using UtilitiesLibrary;
 
 namespace ArchiveDataHandler;
@@ -13,15 +16,46 @@ namespace ArchiveDataHandler;
 /// </summary>
 public sealed class ArchiveStore : IArchiveStore
 {
+    // Metadata values longer than this rarely repeat and are not worth the memory
+    private const int MaxCachedValueLength = 4096;
+
+    // Content is read in pieces of this size into one pooled buffer, so memory does not grow with ChunkSize
+    private const int PieceSize = 4 << 20;
+
+    // Chunk files being written; renamed to their hash when complete
+    private const string TempPrefix = ".tmp-";
+
+    // In the archive root: how the archive cuts file content, "fixed" or "cdc:MIN:AVG:MAX"
+    private const string ChunkingFile = "chunking";
+
+    // Holes shorter than this are read as data: a few extra reads cost less than the entries
+    private const long MinHole = 64 << 10;
+
+    /// <summary>
+    ///     Prefix of a hash list entry that stands for a chunk of zero bytes, followed by its length; nothing is
+    ///     stored for it. Adjacent ones are merged into one run.
+    /// </summary>
+    public const string ZeroRunPrefix = "zero:";
+
+    /// <summary>
+    ///     Prefix of a hash list entry that stands for a hole of a sparse file (reading as zeros), followed by its
+    ///     length; nothing is read or stored for it.
+    /// </summary>
+    public const string HolePrefix = "hole:";
+
     private static readonly object _instanceLock = new();
     private static IArchiveStore? _instance;
     private readonly ConcurrentDictionary<string, string> _arlist = new();
+    private readonly ContentChunker? _chunker;
+    private readonly object _commitLock = new();
     private readonly IBackupConfig _config;
     private readonly Action<string> _log;
     private readonly ILogging _logger;
     private readonly ConcurrentDictionary<string, HashSet<string>> _preflist = new();
     private readonly object _reorgLock = new();
     private readonly ConcurrentDictionary<string, long> _stats = new();
+    private readonly ValueCache _values;
+    private long _packSum;
 
     /// <summary>
     ///     Initializes a new instance of the <see cref="ArchiveStore" /> class.
@@ -48,6 +82,8 @@ public sealed class ArchiveStore : IArchiveStore
             throw;
         }
 
+        _chunker = ResolveChunking();
+        _values = new ValueCache(_config.ValueCacheEntries, MaxCachedValueLength);
         _instance = this;
     }
 
@@ -79,7 +115,13 @@ public sealed class ArchiveStore : IArchiveStore
     public IReadOnlyDictionary<string, long> Stats => _stats;
 
     /// <inheritdoc />
-    public long PackSum { get; private set; }
+    public long PackSum => Interlocked.Read(ref _packSum);
+
+    /// <summary>
+    ///     Gets how file content is cut into chunks: <c>fixed</c> or content-defined, <c>cdc:MIN:AVG:MAX</c> (see
+    ///     <see cref="IBackupConfig.Chunking" />).
+    /// </summary>
+    public string Chunking => _chunker?.ToString() ?? "fixed";
 
     /// <inheritdoc />
     public void BuildIndex()
@@ -98,13 +140,26 @@ public sealed class ArchiveStore : IArchiveStore
         if (_config.Verbose)
             _log.Invoke($"GetTargetPathForHash: {hash}");
 
+        var prefix = PlaceHash(hash);
+        if (prefix is null)
+            return null;
+        Register(hash, prefix);
+        return Path.Combine(_config.DataPath, prefix, hash);
+    }
+
+    /// <summary>
+    ///     Chooses the prefix directory for a new hash, splitting a full one first, without registering the hash.
+    ///     Returns <c>null</c> (and accounts the stored size in <see cref="PackSum" />) if it is registered already.
+    /// </summary>
+    private string? PlaceHash(string hash)
+    {
         if (_arlist.TryGetValue(hash, out var existingPrefix))
         {
             var fPath = Path.Combine(_config.DataPath, existingPrefix, hash);
             try
             {
                 if (File.Exists(fPath))
-                    PackSum += new FileInfo(fPath).Length;
+                    Interlocked.Add(ref _packSum, new FileInfo(fPath).Length);
             }
             catch
             {
@@ -200,98 +255,750 @@ public sealed class ArchiveStore : IArchiveStore
             prefix = JoinPrefix(prefix, dir2);
         }
 
+        return prefix;
+    }
+
+    /// <summary>Adds a hash whose file is in place under <paramref name="prefix" /> to the index.</summary>
+    private void Register(string hash, string prefix)
+    {
         _arlist[hash] = prefix;
         var pset = _preflist.GetOrAdd(prefix, _ => []);
         lock (pset)
         {
             pset.Add(hash);
         }
-
-        return Path.Combine(_config.DataPath, prefix, hash);
     }
 
     /// <inheritdoc />
     public string SaveData(ReadOnlySpan<byte> data)
     {
-        var hashBytes = SHA512.HashData(data);
-        var hash = BitConverter.ToString(hashBytes).Replace("-", "").ToLowerInvariant();
-        var outFile = GetTargetPathForHash(hash);
-        if (outFile != null)
+        var hash = Hex(SHA512.HashData(data));
+        if (IsStored(hash, data.Length))
+            return hash;
+
+        var temp = TempPath();
+        try
         {
-            _stats.AddOrUpdate("saved_blocks", 1, (_, v) => v + 1);
-            var dataLen = data.Length;
-            _stats.AddOrUpdate("saved_bytes", dataLen, (_, v) => v + dataLen);
+            using var output = File.Create(temp);
+            using var bzip2 = new BZip2OutputStream(output);
+            // In slices: Stream.Write(ReadOnlySpan) copies through a rented array of the whole length
+            for (var rest = data; !rest.IsEmpty; rest = rest[Math.Min(rest.Length, PieceSize)..])
+                bzip2.Write(rest[..Math.Min(rest.Length, PieceSize)]);
+        }
+        catch (Exception ex)
+        {
+            return Abandon(temp, hash, ex);
+        }
 
-            try
-            {
-                var directory = Path.GetDirectoryName(outFile);
-                if (!string.IsNullOrEmpty(directory))
-                    CreateDirectoryWithLogging(directory);
+        return Commit(temp, hash, data.Length);
+    }
+
+    /// <inheritdoc />
+    public List<string> SaveStream(Stream fileStream, long size, string tag, Action<long>? progress = null)
+    {
+        // The holes of a sparse file are recorded instead of read
+        if (fileStream is ISparseReadable sparse && fileStream.CanSeek && size >= MinHole)
+            return Coalesce(SaveSparse(fileStream, sparse, size, progress));
+        return Coalesce(SaveContent(fileStream, size, progress));
+    }
+
+    /// <summary>
+    ///     Stores up to <paramref name="size" /> bytes of <paramref name="fileStream" /> as chunks.
+    /// </summary>
+    private List<string> SaveContent(Stream fileStream, long size, Action<long>? progress)
+    {
+        if (_chunker is not null)
+            return SaveContentDefined(fileStream, size, _chunker, progress);
 
-                using (var outputStream = File.Create(outFile))
-                using (var bzip2 = new BZip2OutputStream(outputStream))
+        // Several chunks that each fit in memory: hash and compress them on worker threads
+        if (_config.PipelineThreads > 0 && size > _config.ChunkSize && _config.ChunkSize <= PieceSize)
+            return new IngestPipeline(this, _config.PipelineThreads).Run(
+                fileStream,
+                size,
+                (int)_config.ChunkSize,
+                progress
+            );
+
+        // Several chunks too large for memory from a file that can be read at any offset: one per worker
+        if (_config.PipelineThreads > 0 && size > _config.ChunkSize && fileStream is IRangeReadable ranges)
+            return SaveRanges(fileStream, ranges, size, progress);
+
+        // Memory is one pooled piece, whatever the chunk size: a chunk that fits is hashed and compressed from
+        // it, a larger one is streamed through it (SaveLargeChunk)
+        var hashes = new List<string>();
+        var buffer = ArrayPool<byte>.Shared.Rent((int)Math.Clamp(Math.Min(size, _config.ChunkSize), 1, PieceSize));
+        var capacity = Math.Min(buffer.Length, PieceSize);
+        try
+        {
+            while (size > 0)
+            {
+                var chunk = Math.Min(_config.ChunkSize, size);
+                long read;
+                string hash;
+                if (chunk <= capacity)
+                {
+                    read = fileStream.ReadAtLeast(buffer.AsSpan(0, (int)chunk), (int)chunk, false);
+                    if (read == 0)
+                        break;
+                    progress?.Invoke(read);
+                    hash = StoreChunk(buffer.AsSpan(0, (int)read));
+                }
+                else
                 {
-                    bzip2.Write(data.ToArray(), 0, data.Length);
+                    hash = SaveLargeChunk(fileStream, chunk, buffer, capacity, progress, out read);
+                    if (read == 0)
+                        break;
                 }
+
+                hashes.Add(hash);
+                size -= read;
+                // The stream ended before the announced size
+                if (read < chunk)
+                    break;
             }
-            catch (Exception ex)
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+
+        return hashes;
+    }
+
+    /// <inheritdoc />
+    public List<string> SaveBytes(ReadOnlySpan<byte> data, string tag, Action<long>? progress = null)
+    {
+        var hashes = new List<string>();
+        if (_chunker is not null)
+        {
+            var cuts = new long[data.Length / (_chunker.MinSize + 1) + 1];
+            var start = 0;
+            foreach (var cut in cuts.AsSpan(0, _chunker.FindBoundaries(data, true, cuts)))
             {
-                _logger.Error(outFile, nameof(BZip2OutputStream), ex);
+                hashes.Add(StoreChunk(data[start..(int)cut]));
+                progress?.Invoke(cut - start);
+                start = (int)cut;
+            }
+
+            return Coalesce(hashes);
+        }
+
+        var chunkSize = (int)Math.Min(_config.ChunkSize, int.MaxValue);
+
+        while (!data.IsEmpty)
+        {
+            var chunk = data[..Math.Min(chunkSize, data.Length)];
+            hashes.Add(StoreChunk(chunk));
+            data = data[chunk.Length..];
+            progress?.Invoke(chunk.Length);
+        }
+
+        return Coalesce(hashes);
+    }
+
+    /// <inheritdoc />
+    public List<string> SaveValue(ReadOnlySpan<byte> data, string tag)
+    {
+        if (_values.TryGet(data, out var cached))
+        {
+            // Stored before in this run: a duplicate, as SaveData would have found
+            _stats.AddOrUpdate("value_cache_hits", 1, (_, v) => v + 1);
+            _stats.AddOrUpdate("duplicate_blocks", cached.Count, (_, v) => v + cached.Count);
+            var dataLen = data.Length;
+            _stats.AddOrUpdate("duplicate_bytes", dataLen, (_, v) => v + dataLen);
+            return cached;
+        }
+
+        var hashes = SaveBytes(data, tag);
+        if (_values.Capacity > 0 && data.Length <= _values.MaxValueLength)
+            _stats.AddOrUpdate("value_cache_misses", 1, (_, v) => v + 1);
+        _values.Add(data, hashes);
+        return hashes;
+    }
+
+    /// <summary>
+    ///     Parses a chunking specification (see <see cref="IBackupConfig.Chunking" />).
+    /// </summary>
+    /// <returns>The chunker, or <c>null</c> for fixed-size chunks.</returns>
+    /// <exception cref="ArgumentException">The specification is not valid.</exception>
+    internal static ContentChunker? ParseChunking(string spec)
+    {
+        var parts = spec.Trim().ToLowerInvariant().Split(':');
+        switch (parts)
+        {
+            case ["fixed"]:
+                return null;
+            case ["cdc"]:
+                return new ContentChunker(256 << 10, 1 << 20, 4 << 20);
+            case ["cdc", _, _, _] when parts.Skip(1).All(p => int.TryParse(p, out _)):
                 try
                 {
-                    PackSum += new FileInfo(outFile).Length;
+                    return new ContentChunker(int.Parse(parts[1]), int.Parse(parts[2]), int.Parse(parts[3]));
+                }
+                catch (ArgumentOutOfRangeException ex)
+                {
+                    throw new ArgumentException(
+                        $"Chunking '{spec}': need 64 <= MIN < AVG < MAX <= {ContentChunker.MaxChunkSize}",
+                        nameof(spec),
+                        ex
+                    );
                 }
-                catch { }
+            default:
+                throw new ArgumentException($"Chunking '{spec}': expected fixed, cdc or cdc:MIN:AVG:MAX", nameof(spec));
+        }
+    }
 
-                return hash;
+    /// <summary>
+    ///     Chooses the chunking of this archive: the configured one, which is then recorded in the archive root, or
+    ///     else the recorded one. Chunks cut differently do not match, so a change is worth a warning.
+    /// </summary>
+    private ContentChunker? ResolveChunking()
+    {
+        var record = Path.Combine(_config.ArchiveRoot, ChunkingFile);
+        var recorded = File.Exists(record) ? File.ReadAllText(record).Trim() : null;
+        if (_config.Chunking is null)
+            return recorded is null ? null : ParseChunking(recorded);
+
+        var chunker = ParseChunking(_config.Chunking);
+        var chosen = chunker?.ToString() ?? "fixed";
+        if (recorded == chosen)
+            return chunker;
+        if (recorded is not null)
+            _logger.Warn($"Chunking changed from {recorded} to {chosen}: new chunks will not match earlier ones");
+        try
+        {
+            File.WriteAllText(record, chosen + "\n");
+        }
+        catch (Exception ex)
+        {
+            _logger.Error(record, nameof(File.WriteAllText), ex);
+            throw;
+        }
+
+        return chunker;
+    }
+
+    /// <summary>
+    ///     Stores up to <paramref name="size" /> bytes of <paramref name="stream" /> in content-defined chunks. The
+    ///     content passes through one pooled window of at least two maximal chunks: the complete chunks found in it
+    ///     are stored, on the pipeline's workers with <see cref="IBackupConfig.PipelineThreads" />, and the incomplete
+    ///     rest moves to the front before the window is refilled.
+    /// </summary>
+    private List<string> SaveContentDefined(Stream stream, long size, ContentChunker chunker, Action<long>? progress)
+    {
+        // The whole content if it fits, so small files do not hold a large buffer; MaxChunkSize keeps the bound
+        // well below Array.MaxLength
+        var capacity = (int)Math.Clamp(size, 1, Math.Max(4L * PieceSize, 2L * chunker.MaxSize));
+        var window = ArrayPool<byte>.Shared.Rent(capacity);
+        var cuts = new long[capacity / (chunker.MinSize + 1) + 1];
+        try
+        {
+            if (_config.PipelineThreads > 0)
+                return new IngestPipeline(this, _config.PipelineThreads).Run(add =>
+                    CutChunks(
+                        stream,
+                        size,
+                        chunker,
+                        window,
+                        capacity,
+                        cuts,
+                        progress,
+                        (start, length) =>
+                        {
+                            var buffer = ArrayPool<byte>.Shared.Rent(length);
+                            window.AsSpan(start, length).CopyTo(buffer);
+                            add(buffer, length);
+                        }
+                    )
+                );
+
+            var hashes = new List<string>();
+            CutChunks(
+                stream,
+                size,
+                chunker,
+                window,
+                capacity,
+                cuts,
+                progress,
+                (start, length) => hashes.Add(StoreChunk(window.AsSpan(start, length)))
+            );
+            return hashes;
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(window);
+        }
+    }
+
+    /// <summary>
+    ///     Reads up to <paramref name="size" /> bytes through <paramref name="window" /> and hands each complete
+    ///     content-defined chunk in it to <paramref name="store" /> as offset and length, in stream order.
+    /// </summary>
+    private static void CutChunks(
+        Stream stream,
+        long size,
+        ContentChunker chunker,
+        byte[] window,
+        int capacity,
+        long[] cuts,
+        Action<long>? progress,
+        Action<int, int> store
+    )
+    {
+        var filled = 0;
+        var ended = size <= 0;
+        while (true)
+        {
+            while (!ended && filled < capacity)
+            {
+                var read = stream.Read(window, filled, (int)Math.Min(capacity - filled, size));
+                if (read == 0)
+                    break;
+                progress?.Invoke(read);
+                filled += read;
+                size -= read;
+                ended = size == 0;
             }
 
-            try
+            // The stream ended before the announced size
+            ended |= filled < capacity;
+            if (filled == 0)
+                return;
+
+            var start = 0;
+            foreach (var cut in cuts.AsSpan(0, chunker.FindBoundaries(window.AsSpan(0, filled), ended, cuts)))
             {
-                PackSum += new FileInfo(outFile).Length;
+                store(start, (int)cut - start);
+                start = (int)cut;
             }
-            catch { }
 
-            if (_config.Verbose)
-                _log.Invoke(hash);
+            if (ended && start == filled)
+                return;
+            window.AsSpan(start, filled - start).CopyTo(window);
+            filled -= start;
         }
-        else
+    }
+
+    /// <summary>
+    ///     Stores <paramref name="size" /> bytes of a sparse file: each stretch of data, up to the next hole of at
+    ///     least <see cref="MinHole" /> bytes, is stored as by <see cref="SaveContent" />, and each such hole becomes
+    ///     a <see cref="HolePrefix" /> entry. Shorter holes are read with the data around them. Time thus goes with
+    ///     the allocated data rather than the apparent size.
+    /// </summary>
+    private List<string> SaveSparse(Stream stream, ISparseReadable sparse, long size, Action<long>? progress)
+    {
+        var hashes = new List<string>();
+        var offset = stream.Position;
+        var end = offset + size;
+        while (offset < end)
         {
-            _stats.AddOrUpdate("duplicate_blocks", 1, (_, v) => v + 1);
-            var dataLen2 = data.Length;
-            _stats.AddOrUpdate("duplicate_bytes", dataLen2, (_, v) => v + dataLen2);
-            if (_config.Verbose)
-                _log.Invoke($"{hash} already exists");
+            // Data from offset up to the next hole that is worth skipping, or up to the end
+            var dataEnd = offset;
+            var holeEnd = end;
+            while (dataEnd < end)
+            {
+                if (!sparse.TryFindData(dataEnd, out var start, out var stop))
+                {
+                    // No more data: a hole up to the end, or up to end of file if the file shrank; what no longer
+                    // exists is not recorded, so the list ends early as when a read comes up short
+                    end = Math.Clamp(stream.Length, dataEnd, end);
+                    start = stop = end;
+                }
+
+                var next = Math.Min(start, end);
+                if (next - dataEnd >= MinHole)
+                {
+                    holeEnd = next;
+                    break;
+                }
+
+                dataEnd = next < end ? Math.Min(Math.Max(stop, next + 1), end) : end;
+            }
+
+            // The end may have moved in, to where the file now ends
+            holeEnd = Math.Min(holeEnd, end);
+
+            if (dataEnd > offset)
+            {
+                stream.Position = offset;
+                hashes.AddRange(SaveContent(stream, dataEnd - offset, progress));
+                // The file shrank while it was read
+                if (stream.Position < dataEnd)
+                    return hashes;
+            }
+
+            if (holeEnd > dataEnd)
+            {
+                var hole = holeEnd - dataEnd;
+                hashes.Add(HolePrefix + hole);
+                _stats.AddOrUpdate("hole_bytes", hole, (_, v) => v + hole);
+                progress?.Invoke(hole);
+            }
+
+            offset = holeEnd;
         }
 
-        return hash;
+        stream.Position = end;
+        return hashes;
     }
 
-    /// <inheritdoc />
-    public List<string> SaveStream(Stream fileStream, long size, string tag, Action<long>? progress = null)
+    /// <summary>
+    ///     Records a chunk of zero bytes as a <see cref="ZeroRunPrefix" /> entry and any other as by
+    ///     <see cref="SaveData" />.
+    /// </summary>
+    private string StoreChunk(ReadOnlySpan<byte> data)
     {
-        var hashes = new List<string>();
-        var total = size;
-        var processed = 0L;
-        var bufferSize = (int)Math.Min(_config.ChunkSize, size <= 0 ? _config.ChunkSize : size);
-        var buffer = new byte[bufferSize];
+        return ZeroRun(data) ?? SaveData(data);
+    }
+
+    /// <summary>
+    ///     Returns the <see cref="ZeroRunPrefix" /> entry for <paramref name="data" /> if it is all zero bytes, else
+    ///     <c>null</c>.
+    /// </summary>
+    internal string? ZeroRun(ReadOnlySpan<byte> data)
+    {
+        return !data.IsEmpty && IsZero(data) ? CountZeroRun(data.Length) : null;
+    }
+
+    // Vectorized by the runtime (up to AVX-512 / SVE)
+    private static bool IsZero(ReadOnlySpan<byte> data)
+    {
+        return data.IndexOfAnyExcept((byte)0) < 0;
+    }
+
+    private static void AppendZeros(IncrementalHash sha, long count)
+    {
+        if (count == 0)
+            return;
+        var zeros = ArrayPool<byte>.Shared.Rent((int)Math.Min(count, PieceSize));
+        Array.Clear(zeros);
+        for (; count > 0; count -= Math.Min(count, zeros.Length))
+            sha.AppendData(zeros, 0, (int)Math.Min(count, zeros.Length));
+        ArrayPool<byte>.Shared.Return(zeros);
+    }
 
-        while (size > 0)
+    private string CountZeroRun(long length)
+    {
+        _stats.AddOrUpdate("zero_blocks", 1, (_, v) => v + 1);
+        _stats.AddOrUpdate("zero_bytes", length, (_, v) => v + length);
+        return ZeroRunPrefix + length;
+    }
+
+    /// <summary>
+    ///     Merges adjacent <see cref="ZeroRunPrefix" /> entries, and adjacent <see cref="HolePrefix" /> entries, into
+    ///     one each.
+    /// </summary>
+    private static List<string> Coalesce(List<string> hashes)
+    {
+        var merged = new List<string>(hashes.Count);
+        foreach (var entry in hashes)
         {
-            var toRead = (int)Math.Min(bufferSize, size);
-            var read = fileStream.Read(buffer, 0, toRead);
-            if (read == 0)
+            var prefix = entry.StartsWith(ZeroRunPrefix, StringComparison.Ordinal) ? ZeroRunPrefix
+                : entry.StartsWith(HolePrefix, StringComparison.Ordinal) ? HolePrefix
+                : null;
+            if (prefix is not null && merged.Count > 0 && merged[^1].StartsWith(prefix, StringComparison.Ordinal))
+                merged[^1] = prefix + (long.Parse(merged[^1][prefix.Length..]) + long.Parse(entry[prefix.Length..]));
+            else
+                merged.Add(entry);
+        }
+
+        return merged;
+    }
+
+    /// <summary>
+    ///     Stores the chunks of <paramref name="stream" /> concurrently on <see cref="IBackupConfig.PipelineThreads" />
+    ///     workers, each reading its chunk's range through its own stream and piece buffer (see
+    ///     <see cref="SaveLargeChunk" />). Hashes are collected by chunk index, so the result is the same as reading
+    ///     the chunks one after another, up to the first chunk the file turns out to end in.
+    /// </summary>
+    private List<string> SaveRanges(Stream stream, IRangeReadable ranges, long size, Action<long>? progress)
+    {
+        var start = stream.Position;
+        var chunkSize = _config.ChunkSize;
+        var count = (int)((size + chunkSize - 1) / chunkSize);
+        var hashes = new string[count];
+        var lengths = new long[count];
+        var gate = new object();
+        // The caller's progress callback need not be thread-safe
+        Action<long>? report = progress is null
+            ? null
+            : n =>
+            {
+                lock (gate)
+                {
+                    progress(n);
+                }
+            };
+
+        try
+        {
+            Parallel.For(
+                0,
+                count,
+                new ParallelOptions { MaxDegreeOfParallelism = _config.PipelineThreads },
+                () => ArrayPool<byte>.Shared.Rent(PieceSize),
+                (i, _, buffer) =>
+                {
+                    var length = Math.Min(chunkSize, size - i * chunkSize);
+                    using var range = ranges.OpenRange(start + i * chunkSize, length);
+                    hashes[i] = SaveLargeChunk(range, length, buffer, PieceSize, report, out lengths[i]);
+                    return buffer;
+                },
+                buffer => ArrayPool<byte>.Shared.Return(buffer)
+            );
+        }
+        catch (AggregateException ex)
+        {
+            ExceptionDispatchInfo.Throw(ex.InnerExceptions[0]);
+        }
+
+        var result = new List<string>(count);
+        var total = 0L;
+        for (var i = 0; i < count && lengths[i] > 0; i++)
+        {
+            result.Add(hashes[i]);
+            total += lengths[i];
+            if (lengths[i] < Math.Min(chunkSize, size - i * chunkSize))
                 break;
-            var span = new ReadOnlySpan<byte>(buffer, 0, read);
-            var h = SaveData(span);
-            hashes.Add(h);
+        }
+
+        stream.Position = start + total;
+        return result;
+    }
 
-            size -= read;
-            processed += read;
-            progress?.Invoke(read);
+    /// <summary>
+    ///     Stores a chunk larger than the read buffer without holding it in memory. A seekable stream is read
+    ///     twice: once only to hash (most chunks of an incremental backup are already stored), and for a new chunk
+    ///     again to compress, hashing once more so the stored name matches the stored bytes even if the file
+    ///     changed in between. Other streams are compressed while hashing and the result dropped if it is a
+    ///     duplicate.
+    /// </summary>
+    /// <param name="stream">Source, positioned at the chunk.</param>
+    /// <param name="length">Chunk length.</param>
+    /// <param name="buffer">Read buffer.</param>
+    /// <param name="capacity">Usable length of <paramref name="buffer" />.</param>
+    /// <param name="progress">Progress callback, invoked for the first pass only.</param>
+    /// <param name="read">Receives the number of bytes the chunk turned out to have.</param>
+    /// <returns>Hash of the chunk as stored.</returns>
+    private string SaveLargeChunk(
+        Stream stream,
+        long length,
+        byte[] buffer,
+        int capacity,
+        Action<long>? progress,
+        out long read
+    )
+    {
+        using var sha = IncrementalHash.CreateHash(HashAlgorithmName.SHA512);
+        var start = stream.CanSeek ? stream.Position : -1;
+        var hash = "";
+        var zero = true;
+        read = 0;
+        if (start >= 0)
+        {
+            // Leading zero bytes are only counted, and hashed once other content follows
+            var zeros = 0L;
+            read = Pump(
+                stream,
+                length,
+                buffer,
+                capacity,
+                n =>
+                {
+                    if (zero && IsZero(buffer.AsSpan(0, n)))
+                        zeros += n;
+                    else
+                    {
+                        if (zero)
+                            AppendZeros(sha, zeros);
+                        zero = false;
+                        sha.AppendData(buffer, 0, n);
+                    }
+
+                    progress?.Invoke(n);
+                }
+            );
+            if (read > 0 && zero)
+                return CountZeroRun(read);
+            hash = Hex(sha.GetHashAndReset());
+            if (read == 0 || IsStored(hash, read))
+                return hash;
+            stream.Position = start;
         }
 
-        return hashes;
+        var temp = TempPath();
+        try
+        {
+            using (var output = File.Create(temp))
+            using (var bzip2 = new BZip2OutputStream(output))
+                read = Pump(
+                    stream,
+                    start >= 0 ? read : length,
+                    buffer,
+                    capacity,
+                    n =>
+                    {
+                        sha.AppendData(buffer, 0, n);
+                        zero = zero && IsZero(buffer.AsSpan(0, n));
+                        bzip2.Write(buffer, 0, n);
+                        if (start < 0)
+                            progress?.Invoke(n);
+                    }
+                );
+        }
+        catch (Exception ex)
+        {
+            return Abandon(temp, start >= 0 ? hash : Hex(sha.GetHashAndReset()), ex);
+        }
+
+        var stored = Hex(sha.GetHashAndReset());
+        if (read == 0)
+        {
+            Discard(temp);
+            return stored;
+        }
+
+        if (start < 0 && zero)
+        {
+            Discard(temp);
+            return CountZeroRun(read);
+        }
+
+        if (start < 0 && IsStored(stored, read))
+        {
+            Discard(temp);
+            return stored;
+        }
+
+        return Commit(temp, stored, read);
+    }
+
+    /// <summary>
+    ///     Reads up to <paramref name="length" /> bytes in pieces of the buffer, handing each to
+    ///     <paramref name="consume" />.
+    /// </summary>
+    /// <returns>Bytes read; less than <paramref name="length" /> at end of stream.</returns>
+    private static long Pump(Stream stream, long length, byte[] buffer, int capacity, Action<int> consume)
+    {
+        var total = 0L;
+        while (total < length)
+        {
+            var want = (int)Math.Min(capacity, length - total);
+            var n = stream.ReadAtLeast(buffer.AsSpan(0, want), want, false);
+            if (n == 0)
+                break;
+            consume(n);
+            total += n;
+        }
+
+        return total;
+    }
+
+    /// <summary>
+    ///     Tells whether a chunk is stored already, counting it as a duplicate if so.
+    /// </summary>
+    internal bool IsStored(string hash, long length)
+    {
+        if (!_arlist.ContainsKey(hash))
+            return false;
+        GetTargetPathForHash(hash); // accounts the stored size in PackSum
+        CountDuplicate(hash, length);
+        return true;
+    }
+
+    /// <summary>
+    ///     Moves a completely written chunk file to its place and only then registers its hash, so
+    ///     <see cref="IsStored" />, which other threads call without the lock, never sees a hash whose file is not
+    ///     there (yet, or after a failed move); if another thread stored the same chunk meanwhile, this copy is
+    ///     dropped.
+    /// </summary>
+    internal string Commit(string temp, string hash, long length)
+    {
+        // Placement (and the directory reorganization it may trigger) is not safe for concurrent callers
+        lock (_commitLock)
+        {
+            var prefix = PlaceHash(hash);
+            if (prefix is null)
+            {
+                CountDuplicate(hash, length);
+                Discard(temp);
+                return hash;
+            }
+
+            var outFile = Path.Combine(_config.DataPath, prefix, hash);
+            try
+            {
+                var directory = Path.GetDirectoryName(outFile);
+                if (!string.IsNullOrEmpty(directory))
+                    CreateDirectoryWithLogging(directory);
+                File.Move(temp, outFile, true);
+                Interlocked.Add(ref _packSum, new FileInfo(outFile).Length);
+            }
+            catch (Exception ex)
+            {
+                Discard(temp);
+                _logger.Error(outFile, nameof(File.Move), ex);
+                return hash;
+            }
+
+            Register(hash, prefix);
+        }
+
+        _stats.AddOrUpdate("saved_blocks", 1, (_, v) => v + 1);
+        _stats.AddOrUpdate("saved_bytes", length, (_, v) => v + length);
+        if (_config.Verbose)
+            _log.Invoke(hash);
+        return hash;
+    }
+
+    /// <summary>Adds <paramref name="value" /> to the archive statistic <paramref name="key" />.</summary>
+    internal void CountStat(string key, long value)
+    {
+        _stats.AddOrUpdate(key, value, (_, v) => v + value);
+    }
+
+    /// <summary>Logs a failed chunk write and removes what was written of it.</summary>
+    internal string Abandon(string temp, string hash, Exception ex)
+    {
+        _logger.Error(temp, nameof(BZip2OutputStream), ex);
+        Discard(temp);
+        return hash;
+    }
+
+    /// <summary>Removes a chunk file that was not kept.</summary>
+    private static void Discard(string temp)
+    {
+        try
+        {
+            File.Delete(temp);
+        }
+        catch
+        {
+            // ignore; BuildIndex removes leftovers
+        }
+    }
+
+    private void CountDuplicate(string hash, long length)
+    {
+        _stats.AddOrUpdate("duplicate_blocks", 1, (_, v) => v + 1);
+        _stats.AddOrUpdate("duplicate_bytes", length, (_, v) => v + length);
+        if (_config.Verbose)
+            _log.Invoke($"{hash} already exists");
+    }
+
+    /// <summary>
+    ///     A unique file name in the data directory (same filesystem as the chunks, so the final move is a rename)
+    ///     for a chunk being written.
+    /// </summary>
+    internal string TempPath()
+    {
+        return Path.Combine(_config.DataPath, $"{TempPrefix}{Guid.NewGuid():N}");
+    }
+
+    internal static string Hex(byte[] hash)
+    {
+        return Convert.ToHexString(hash).ToLowerInvariant();
     }
 
     /// <summary>
@@ -357,6 +1064,11 @@ public sealed class ArchiveStore : IArchiveStore
                 set.Add(file);
             }
         }
+        else if (file.StartsWith(TempPrefix, StringComparison.Ordinal))
+        {
+            // A chunk whose write was interrupted
+            Discard(entry);
+        }
         else
         {
             Utilities.Warn($"Bad entry in archive: {entry}");
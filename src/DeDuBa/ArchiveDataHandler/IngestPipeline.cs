@@ -0,0 +1,255 @@
+using System.Buffers;
+using System.Diagnostics;
+using System.Runtime.ExceptionServices;
+using System.Security.Cryptography;
+using System.Threading.Channels;
+using ICSharpCode.SharpZipLib.BZip2;
+
+namespace ArchiveDataHandler;
+
+/// <summary>
+///     Staged storage of the chunks of one stream: the caller reads, a pool of workers hashes, another pool
+///     compresses and a single writer stores the chunk files. The stages are connected by bounded channels, so a slow
+///     stage holds the earlier ones back instead of letting chunks pile up, and memory stays at a few chunks per
+///     worker. Chunks are numbered as they are read and their hashes returned in that order, and each is stored
+///     exactly as <see cref="ArchiveStore.SaveData" /> would, so the result does not differ from storing them one
+///     after another.
+/// </summary>
+/// <remarks>
+///     The busy time of each stage is added to the archive statistics as <c>pipeline_read_ms</c> (reading, and
+///     finding content-defined chunk boundaries), <c>pipeline_hash_ms</c>, <c>pipeline_compress_ms</c> and
+///     <c>pipeline_write_ms</c>, next to the elapsed <c>pipeline_wall_ms</c>: a stage's utilization is its busy time
+///     over the elapsed time times its workers (one for reading and writing).
+/// </remarks>
+internal sealed class IngestPipeline
+{
+    private const int Read = 0;
+    private const int Hash = 1;
+    private const int Compress = 2;
+    private const int Write = 3;
+
+    private static readonly string[] StageNames = ["read", "hash", "compress", "write"];
+
+    private readonly ArchiveStore _store;
+    private readonly long[] _ticks = new long[StageNames.Length];
+    private readonly int _workers;
+
+    /// <summary>
+    ///     Initializes a new instance of the <see cref="IngestPipeline" /> class.
+    /// </summary>
+    /// <param name="store">Store the chunks go to.</param>
+    /// <param name="workers">Number of hashing and of compressing workers.</param>
+    public IngestPipeline(ArchiveStore store, int workers)
+    {
+        _store = store;
+        _workers = Math.Max(workers, 1);
+    }
+
+    /// <summary>
+    ///     Reads up to <paramref name="size" /> bytes in chunks of <paramref name="chunkSize" /> and stores them.
+    /// </summary>
+    /// <param name="stream">Source stream.</param>
+    /// <param name="size">Bytes to read; less are stored if the stream ends early.</param>
+    /// <param name="chunkSize">Chunk size; each chunk is held in memory.</param>
+    /// <param name="progress">Invoked on the calling thread with the bytes of each chunk read.</param>
+    /// <returns>Chunk hashes in stream order.</returns>
+    public List<string> Run(Stream stream, long size, int chunkSize, Action<long>? progress)
+    {
+        return Run(add =>
+        {
+            while (size > 0)
+            {
+                var length = (int)Math.Min(chunkSize, size);
+                var buffer = ArrayPool<byte>.Shared.Rent(length);
+                var read = stream.ReadAtLeast(buffer.AsSpan(0, length), length, false);
+                if (read == 0)
+                {
+                    ArrayPool<byte>.Shared.Return(buffer);
+                    break;
+                }
+
+                progress?.Invoke(read);
+                add(buffer, read);
+                size -= read;
+                if (read < length)
+                    break;
+            }
+        });
+    }
+
+    /// <summary>
+    ///     Stores the chunks <paramref name="produce" /> passes, in that order, to the callback it is given: a
+    ///     buffer rented from <see cref="ArrayPool{T}.Shared" />, which the pipeline returns, and the chunk length.
+    ///     The callback blocks while the hashing stage is behind. The producer's time outside the callback counts as
+    ///     the read stage.
+    /// </summary>
+    /// <param name="produce">Runs on the calling thread and hands over every chunk.</param>
+    /// <returns>Chunk hashes in the order produced.</returns>
+    public List<string> Run(Action<Action<byte[], int>> produce)
+    {
+        var toHash = Channel.CreateBounded<Chunk>(_workers);
+        var toCompress = Channel.CreateBounded<Chunk>(_workers);
+        var toWrite = Channel.CreateBounded<Chunk>(_workers);
+        var wall = Stopwatch.StartNew();
+        var stages = new[]
+        {
+            Stage(_workers, toHash, toCompress, Hash, HashChunk),
+            Stage(_workers, toCompress, toWrite, Compress, CompressChunk),
+            Stage(1, toWrite, null, Write, WriteChunk),
+        };
+
+        var chunks = new List<Chunk>();
+        Exception? failure = null;
+        var start = Stopwatch.GetTimestamp();
+        var blocked = 0L;
+        try
+        {
+            produce(
+                (buffer, length) =>
+                {
+                    var chunk = new Chunk(buffer, length);
+                    chunks.Add(chunk);
+                    var wait = Stopwatch.GetTimestamp();
+                    toHash.Writer.WriteAsync(chunk).AsTask().GetAwaiter().GetResult();
+                    blocked += Stopwatch.GetTimestamp() - wait;
+                }
+            );
+        }
+        catch (Exception ex)
+        {
+            failure = ex;
+        }
+        finally
+        {
+            _ticks[Read] = Stopwatch.GetTimestamp() - start - blocked;
+            toHash.Writer.TryComplete(failure);
+        }
+
+        var all = Task.WhenAll(stages);
+        try
+        {
+            all.Wait();
+        }
+        catch (AggregateException)
+        {
+            // A failed stage fails those after it with the same exception and those before it (blocked writing
+            // to it) with a ChannelClosedException; a read failure travels down the stages
+            var errors = all.Exception!.InnerExceptions;
+            failure = errors.FirstOrDefault(e => e is not ChannelClosedException) ?? errors[0];
+        }
+        finally
+        {
+            _store.CountStat("pipeline_wall_ms", wall.ElapsedMilliseconds);
+            for (var i = 0; i < StageNames.Length; i++)
+                _store.CountStat(
+                    $"pipeline_{StageNames[i]}_ms",
+                    (long)Stopwatch.GetElapsedTime(0, Interlocked.Read(ref _ticks[i])).TotalMilliseconds
+                );
+        }
+
+        if (failure is not null)
+            ExceptionDispatchInfo.Throw(failure);
+        return [.. chunks.Select(c => c.Hash)];
+    }
+
+    /// <summary>
+    ///     Runs <paramref name="workers" /> tasks that take chunks from <paramref name="input" />, process them and
+    ///     pass those <paramref name="process" /> returns true for on to <paramref name="output" />, which is
+    ///     completed when the last worker ends. A failure also completes <paramref name="input" />, so the stage
+    ///     before does not block on a channel nobody reads any more.
+    /// </summary>
+    private Task Stage(int workers, Channel<Chunk> input, Channel<Chunk>? output, int stage, Func<Chunk, bool> process)
+    {
+        var tasks = new Task[workers];
+        for (var i = 0; i < workers; i++)
+            tasks[i] = Task.Run(async () =>
+            {
+                await foreach (var chunk in input.Reader.ReadAllAsync())
+                {
+                    var start = Stopwatch.GetTimestamp();
+                    var forward = process(chunk);
+                    Interlocked.Add(ref _ticks[stage], Stopwatch.GetTimestamp() - start);
+                    if (forward && output is not null)
+                        await output.Writer.WriteAsync(chunk);
+                }
+            });
+        return Task.WhenAll(tasks)
+            .ContinueWith(
+                done =>
+                {
+                    var error = done.Exception?.InnerException;
+                    output?.Writer.TryComplete(error);
+                    if (error is not null)
+                    {
+                        input.Writer.TryComplete(error);
+                        ExceptionDispatchInfo.Throw(error);
+                    }
+                },
+                TaskScheduler.Default
+            );
+    }
+
+    // Chunks of zero bytes and chunks already in the archive stop here
+    private bool HashChunk(Chunk chunk)
+    {
+        var zero = _store.ZeroRun(chunk.Data);
+        chunk.Hash = zero ?? ArchiveStore.Hex(SHA512.HashData(chunk.Data));
+        if (zero is null && !_store.IsStored(chunk.Hash, chunk.Length))
+            return true;
+        chunk.Release();
+        return false;
+    }
+
+    private bool CompressChunk(Chunk chunk)
+    {
+        var compressed = new MemoryStream();
+        using (var bzip2 = new BZip2OutputStream(compressed) { IsStreamOwner = false })
+            bzip2.Write(chunk.Buffer!, 0, chunk.Length);
+        chunk.Release();
+        chunk.Compressed = compressed;
+        return true;
+    }
+
+    private bool WriteChunk(Chunk chunk)
+    {
+        var temp = _store.TempPath();
+        try
+        {
+            using var output = File.Create(temp);
+            chunk.Compressed!.WriteTo(output);
+        }
+        catch (Exception ex)
+        {
+            _store.Abandon(temp, chunk.Hash, ex);
+            return false;
+        }
+        finally
+        {
+            chunk.Compressed = null;
+        }
+
+        _store.Commit(temp, chunk.Hash, chunk.Length);
+        return false;
+    }
+
+    /// <summary>A chunk on its way through the stages.</summary>
+    private sealed class Chunk(byte[] buffer, int length)
+    {
+        /// <summary>Pooled buffer holding the content until it is hashed (duplicate) or compressed.</summary>
+        public byte[]? Buffer { get; private set; } = buffer;
+
+        public int Length { get; } = length;
+
+        public ReadOnlySpan<byte> Data => Buffer.AsSpan(0, Length);
+
+        public string Hash { get; set; } = "";
+
+        public MemoryStream? Compressed { get; set; }
+
+        public void Release()
+        {
+            ArrayPool<byte>.Shared.Return(Buffer!);
+            Buffer = null;
+        }
+    }
+}
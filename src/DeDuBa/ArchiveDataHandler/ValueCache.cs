@@ -0,0 +1,139 @@
+namespace ArchiveDataHandler;
+
+/// <summary>
+///     Bounded map from small metadata values (ACL texts, xattr values) to the chunk hashes they were saved as,
+///     keyed by their exact bytes: a hash collision of the bucket key is resolved by comparing the content, never
+///     by trusting the hash. The least recently used value is dropped once <see cref="Capacity" /> is reached.
+///     Thread-safe.
+/// </summary>
+internal sealed class ValueCache
+{
+    private readonly Dictionary<int, Entry> _buckets = [];
+    private readonly object _lock = new();
+    private readonly LinkedList<Entry> _lru = new();
+
+    /// <summary>
+    ///     Initializes a new instance of the <see cref="ValueCache" /> class.
+    /// </summary>
+    /// <param name="capacity">Maximum number of values remembered; 0 disables the cache.</param>
+    /// <param name="maxValueLength">Longer values are not remembered.</param>
+    public ValueCache(int capacity, int maxValueLength)
+    {
+        Capacity = Math.Max(capacity, 0);
+        MaxValueLength = maxValueLength;
+    }
+
+    /// <summary>Maximum number of values remembered.</summary>
+    public int Capacity { get; }
+
+    /// <summary>Length in bytes of the longest value remembered.</summary>
+    public int MaxValueLength { get; }
+
+    /// <summary>Number of values currently remembered.</summary>
+    public int Count
+    {
+        get
+        {
+            lock (_lock)
+            {
+                return _lru.Count;
+            }
+        }
+    }
+
+    /// <summary>
+    ///     Looks up the hashes <paramref name="value" /> was saved as.
+    /// </summary>
+    /// <param name="value">Value bytes.</param>
+    /// <param name="hashes">Receives the chunk hashes on a hit.</param>
+    /// <returns>True if the value is remembered.</returns>
+    public bool TryGet(ReadOnlySpan<byte> value, out List<string> hashes)
+    {
+        hashes = [];
+        if (Capacity == 0 || value.Length > MaxValueLength)
+            return false;
+        var key = KeyOf(value);
+        lock (_lock)
+        {
+            for (_buckets.TryGetValue(key, out var entry); entry is not null; entry = entry.Next)
+                if (value.SequenceEqual(entry.Value))
+                {
+                    _lru.Remove(entry.Node);
+                    _lru.AddFirst(entry.Node);
+                    hashes = [.. entry.Hashes];
+                    return true;
+                }
+        }
+
+        return false;
+    }
+
+    /// <summary>
+    ///     Remembers the hashes <paramref name="value" /> was saved as, dropping the least recently used value if
+    ///     the cache is full. Values longer than <see cref="MaxValueLength" /> are ignored.
+    /// </summary>
+    /// <param name="value">Value bytes (copied).</param>
+    /// <param name="hashes">Its chunk hashes.</param>
+    public void Add(ReadOnlySpan<byte> value, IReadOnlyCollection<string> hashes)
+    {
+        if (Capacity == 0 || value.Length > MaxValueLength)
+            return;
+        var key = KeyOf(value);
+        lock (_lock)
+        {
+            _buckets.TryGetValue(key, out var head);
+            for (var entry = head; entry is not null; entry = entry.Next)
+                if (value.SequenceEqual(entry.Value))
+                    return;
+            if (_lru.Count >= Capacity)
+                Remove(_lru.Last!.Value);
+            var added = new Entry(key, value.ToArray(), [.. hashes]) { Next = head };
+            _lru.AddFirst(added.Node);
+            _buckets[key] = added;
+        }
+    }
+
+    private void Remove(Entry victim)
+    {
+        _lru.Remove(victim.Node);
+        if (_buckets[victim.Key] == victim)
+        {
+            if (victim.Next is null)
+                _buckets.Remove(victim.Key);
+            else
+                _buckets[victim.Key] = victim.Next;
+            return;
+        }
+
+        for (var entry = _buckets[victim.Key]; entry.Next is not null; entry = entry.Next)
+            if (entry.Next == victim)
+            {
+                entry.Next = victim.Next;
+                return;
+            }
+    }
+
+    private static int KeyOf(ReadOnlySpan<byte> value)
+    {
+        var hash = new HashCode();
+        hash.AddBytes(value);
+        return hash.ToHashCode();
+    }
+
+    private sealed class Entry
+    {
+        public Entry(int key, byte[] value, string[] hashes)
+        {
+            Key = key;
+            Value = value;
+            Hashes = hashes;
+            Node = new LinkedListNode<Entry>(this);
+        }
+
+        public int Key { get; }
+        public byte[] Value { get; }
+        public string[] Hashes { get; }
+        public LinkedListNode<Entry> Node { get; }
+        public Entry? Next { get; set; }
+    }
+}
@@ -1,4 +1,5 @@
 using System.ComponentModel;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Text.Json;
 using ArchiveDataHandler;
@@ -242,6 +243,9 @@ public class DedubaClass
                 _archiveStore = new ArchiveStore(_config, UtilitiesLogger.Instance);
                 _archiveStore.BuildIndex();
 
+                if (_config.PreloadOwnerNames && _osApi is not null)
+                    Logger.ConWrite($"Preloaded {_osApi.PreloadOwnerNames()} user and group names\n");
+
                 if (Utilities.VerboseOutput)
                 {
                     Logger.ConWrite("Before backup:\n");
@@ -440,6 +444,32 @@ public class DedubaClass
         );
     }
 
+    // ##############################################################################
+    /// <summary>
+    ///     Reorders the children of <paramref name="directory" /> for reading in on-disk order: regular files by
+    ///     the physical offset of their first extent, after everything else (directories, symlinks, empty files
+    ///     and files without a known offset), which keeps name order. Returns the list unchanged where the
+    ///     platform reports no offsets.
+    /// </summary>
+    private static List<DirectoryListingEntry> OrderByDiskOffset(
+        string directory,
+        List<DirectoryListingEntry> children
+    )
+    {
+        var files = children.Where(c => c.Data is { Size: > 0 } data && data.Flags.Contains("reg")).ToList();
+        if (files.Count < 2)
+            return children;
+        var offsets = _osApi?.GetDataOffsets(directory, [.. files.Select(f => Path.GetFileName(f.Path))]);
+        if (offsets is null)
+            return children;
+
+        var offsetOf = new Dictionary<string, long>(files.Count, StringComparer.Ordinal);
+        for (var i = 0; i < files.Count; i++)
+            offsetOf[files[i].Path] = offsets[i];
+        // OrderBy is stable: equal keys keep name order
+        return [.. children.OrderBy(c => offsetOf.GetValueOrDefault(c.Path, -1))];
+    }
+
     // ##############################################################################
     /// <summary>
     ///     Processes a set of filesystem entries, iterating through directories and emitting inode records.
@@ -450,21 +480,34 @@ public class DedubaClass
         // Suppress verbose debug output while running the worker; errors still print (colorized)
         // var prevVerboseOutput = Utilities.VerboseOutput;
         Utilities.VerboseOutput = false;
+        // Handle on the parent directory of the entries being processed. A directory's children are queued
+        // together, so they are dequeued consecutively and one handle serves all of them.
+        SafeHandle? dirHandle = null;
+        string? dirHandlePath = null;
         try
         {
-            // Initialize work queue with initial files (FIFO queue for breadth-first traversal)
-            var workQueue = new Queue<string>();
+            // Initialize work queue with initial files (FIFO queue for breadth-first traversal). Children carry
+            // the metadata read together with their directory listing, if any.
+            var workQueue = new Queue<DirectoryListingEntry>();
 
             // Enqueue initial files in order
             foreach (var entry in filesToBackup.OrderBy(e => e, StringComparer.Ordinal))
-                workQueue.Enqueue(entry);
+                workQueue.Enqueue(new DirectoryListingEntry(entry, null));
 
             _statusQueueTotal += filesToBackup.Length;
 
+            // Directory listings are read ahead on background threads where the platform supports it; the
+            // traversal below still takes them one by one in its own order.
+            using var scanner = _osApi!.OpenDirectoryScanner(
+                [.. filesToBackup.Select(Path.GetFullPath)],
+                string.IsNullOrEmpty(_archive) ? [] : [Path.GetFullPath(_archive)],
+                _config?.ScanThreads ?? 0
+            );
+
             // Process work queue until empty
             while (workQueue.Count > 0)
             {
-                var entry = workQueue.Dequeue();
+                var (entry, minimalData) = workQueue.Dequeue();
 
                 // Skip any entries that live inside the archive/data store so we do not recurse into it
                 if (!string.IsNullOrEmpty(_archive) && IsPathWithinArchive(entry))
@@ -479,20 +522,28 @@ public class DedubaClass
                 var file = Path.GetFileName(entry);
                 var dir = Path.Combine(volume ?? string.Empty, directories ?? string.Empty);
                 var name = file;
-                InodeData? minimalData = null;
 
                 // $dir is the current directory name,
                 // $name is the current filename within that directory
                 // $entry is the complete pathname to the file.
                 var start = DateTime.Now;
-                try
+                if (dir != dirHandlePath)
                 {
-                    minimalData =
-                        _osApi!.CreateMinimalInodeDataFromPath(entry) ?? throw new Win32Exception("null inodeData");
+                    dirHandle?.Dispose();
+                    dirHandle = _osApi!.OpenDirectoryHandle(dir);
+                    dirHandlePath = dir;
                 }
-                catch (Exception ex)
+
+                // Entries vanishing or turning unreadable mid-walk are routine: report them without unwinding
+                if (minimalData is null)
                 {
-                    Logger.Error(entry, nameof(IHighLevelOsApi.CreateMinimalInodeDataFromPath), ex);
+                    var statError = _osApi!.TryCreateMinimalInodeDataFromPath(dirHandle, entry, out minimalData);
+                    if (statError != 0)
+                        Logger.Error(
+                            entry,
+                            nameof(IHighLevelOsApi.TryCreateMinimalInodeDataFromPath),
+                            new Win32Exception(statError)
+                        );
                 }
 
                 var stDev = minimalData?.Device ?? 0;
@@ -539,10 +590,13 @@ public class DedubaClass
                             try
                             {
                                 // Enqueue children into work queue and update total
-                                var childEntries = _osApi
-                                    ?.ListDirectory(entry)
-                                    .Where(x => !IsPathWithinArchive(x))
-                                    .ToList();
+                                var listing =
+                                    scanner is null
+                                        ? _osApi?.ReadDirectory(entry)
+                                        : scanner.ReadDirectory(entry, minimalData!);
+                                var childEntries = listing?.Where(x => !IsPathWithinArchive(x.Path)).ToList();
+                                if (childEntries != null && _config is { DiskOrder: true })
+                                    childEntries = OrderByDiskOffset(entry, childEntries);
 
                                 _statusQueueTotal += childEntries?.Count ?? 0;
 
@@ -552,7 +606,7 @@ public class DedubaClass
                             }
                             catch (OsException ex)
                             {
-                                Logger.Error(entry, "ListDirectory", ex);
+                                Logger.Error(entry, "ReadDirectory", ex);
                             }
                             catch (Exception ex)
                             {
@@ -577,7 +631,12 @@ public class DedubaClass
                             }
 
                             inodeData = minimalData;
-                            inodeData = _osApi!.CompleteInodeDataFromPath(entry, ref inodeData, _archiveStore!);
+                            inodeData = _osApi!.CompleteInodeDataFromPath(
+                                dirHandle,
+                                entry,
+                                ref inodeData,
+                                _archiveStore!
+                            );
                             flags = inodeData.Flags;
                             fileSize = inodeData.Size;
                         }
@@ -596,7 +655,11 @@ public class DedubaClass
                         // because it's built up as children are processed
                         if (flags.Contains("dir"))
                         {
-                            var dataIsdir = Sdpack(Dirtmp.TryGetValue(entry, out var value) ? value : [], "dir");
+                            // Children may be processed out of name order (DiskOrder); the record stays in name order
+                            var dirEntries = Dirtmp.TryGetValue(entry, out var value)
+                                ? value.OrderBy(e => (string?)((object?[])e)[0], StringComparer.Ordinal).ToList()
+                                : [];
+                            var dataIsdir = Sdpack(dirEntries, "dir");
                             Dirtmp.Remove(entry);
                             var size = dataIsdir.Length;
                             MemoryStream dirMem;
@@ -727,6 +790,7 @@ public class DedubaClass
         }
         finally
         {
+            dirHandle?.Dispose();
             // Ensure VerboseOutput flag is restored after this worker scope
             // Utilities.VerboseOutput = prevVerboseOutput;
             // Move to next line after status updates
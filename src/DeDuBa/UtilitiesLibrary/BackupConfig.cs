@@ -79,6 +79,49 @@ public sealed class BackupConfig : IBackupConfig
     /// </summary>
     public int PrefixSplitThreshold { get; init; } = 255;
 
+    /// <summary>
+    ///     Gets the number of threads scanning directories ahead of the backup traversal
+    ///     (0, the default, uses one per CPU). Set from <c>DEDU_SCAN_THREADS</c>.
+    /// </summary>
+    public int ScanThreads { get; init; }
+
+    /// <summary>
+    ///     Gets a value indicating whether the files of each directory are backed up in on-disk order (physical
+    ///     offset of their first extent) rather than name order, to cut seeks on rotational disks. Directory
+    ///     records keep name order either way. Set from <c>DEDU_DISK_ORDER</c> (<c>1</c> or <c>true</c>).
+    /// </summary>
+    public bool DiskOrder { get; init; }
+
+    /// <summary>
+    ///     Gets the number of distinct ACL texts and xattr values whose chunk hashes
+    ///     <see cref="ArchiveDataHandler.IArchiveStore.SaveValue" /> remembers (default: 4096; 0 disables). Set from
+    ///     <c>DEDU_VALUE_CACHE</c>.
+    /// </summary>
+    public int ValueCacheEntries { get; init; } = 4096;
+
+    /// <summary>
+    ///     Gets a value indicating whether every user and group name is resolved before the backup starts (see
+    ///     <see cref="OsCallsCommon.IHighLevelOsApi.PreloadOwnerNames" />); worthwhile with a slow directory service
+    ///     and many distinct owners. Set from <c>DEDU_NSS_PRELOAD</c> (<c>1</c> or <c>true</c>).
+    /// </summary>
+    public bool PreloadOwnerNames { get; init; }
+
+    /// <summary>
+    ///     Gets the number of hashing and of compressing threads that files of several chunks are stored with
+    ///     (0, the default, stores chunks one after another on the backup thread). Chunks of up to 4 MiB go through
+    ///     the staged pipeline; larger ones are stored one per thread where the file can be read by ranges
+    ///     (<see cref="ArchiveDataHandler.IRangeReadable" />). Set from <c>DEDU_PIPELINE_THREADS</c>.
+    /// </summary>
+    public int PipelineThreads { get; init; }
+
+    /// <summary>
+    ///     Gets how file content is cut into chunks: <c>fixed</c> at <see cref="ChunkSize" /> offsets, or
+    ///     content-defined with <c>cdc</c> (256 KiB / 1 MiB / 4 MiB minimum, mean and maximum chunk size) or
+    ///     <c>cdc:MIN:AVG:MAX</c> (MAX at most 256 MiB). The choice is recorded in the archive; <c>null</c>, the
+    ///     default, keeps the recorded one (<c>fixed</c> for a new archive). Set from <c>DEDU_CHUNKING</c>.
+    /// </summary>
+    public string? Chunking { get; init; }
+
     /// <summary>
     ///     Set the global BackupConfig instance. Can only be called once.
     /// </summary>
@@ -145,7 +188,29 @@ public sealed class BackupConfig : IBackupConfig
 
         var archiveRoot = !string.IsNullOrEmpty(overrideArchiveRoot) ? overrideArchiveRoot : baseArchiveRoot;
 
-        return new BackupConfig(archiveRoot, chunkSize, testing, verbose, prefixSplitThreshold);
+        var envScanThreads = Environment.GetEnvironmentVariable("DEDU_SCAN_THREADS");
+        var scanThreads = int.TryParse(envScanThreads, out var threads) && threads > 0 ? threads : 0;
+        var envDiskOrder = Environment.GetEnvironmentVariable("DEDU_DISK_ORDER");
+        var diskOrder = envDiskOrder == "1" || string.Equals(envDiskOrder, "true", StringComparison.OrdinalIgnoreCase);
+        var envValueCache = Environment.GetEnvironmentVariable("DEDU_VALUE_CACHE");
+        var valueCacheEntries = int.TryParse(envValueCache, out var entries) && entries >= 0 ? entries : 4096;
+        var envPipelineThreads = Environment.GetEnvironmentVariable("DEDU_PIPELINE_THREADS");
+        var pipelineThreads = int.TryParse(envPipelineThreads, out var workers) && workers > 0 ? workers : 0;
+        var envChunking = Environment.GetEnvironmentVariable("DEDU_CHUNKING");
+        var chunking = string.IsNullOrWhiteSpace(envChunking) ? null : envChunking.Trim();
+        var envNssPreload = Environment.GetEnvironmentVariable("DEDU_NSS_PRELOAD");
+        var preloadOwnerNames =
+            envNssPreload == "1" || string.Equals(envNssPreload, "true", StringComparison.OrdinalIgnoreCase);
+
+        return new BackupConfig(archiveRoot, chunkSize, testing, verbose, prefixSplitThreshold)
+        {
+            ScanThreads = scanThreads,
+            DiskOrder = diskOrder,
+            ValueCacheEntries = valueCacheEntries,
+            PreloadOwnerNames = preloadOwnerNames,
+            PipelineThreads = pipelineThreads,
+            Chunking = chunking,
+        };
     }
 
     /// <summary>
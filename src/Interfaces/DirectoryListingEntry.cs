@@ -0,0 +1,12 @@
+namespace OsCallsCommon;
+
+/// <summary>
+///     One entry of <see cref="IHighLevelOsApi.ReadDirectory" />: the full path of a directory child and, when the
+///     platform could collect it together with the listing, its minimal <see cref="InodeData" />.
+/// </summary>
+/// <param name="Path">Full path of the entry.</param>
+/// <param name="Data">
+///     Minimal (stat-only) metadata as <c>TryCreateMinimalInodeDataFromPath</c> would return it, or null if it was
+///     not collected or could not be read; callers then stat the entry themselves.
+/// </param>
+public readonly record struct DirectoryListingEntry(string Path, InodeData? Data);
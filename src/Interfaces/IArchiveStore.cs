@@ -62,11 +62,37 @@ public interface IArchiveStore
 
     /// <summary>
     ///     Reads a stream in chunks, hashes and stores each chunk, and returns the list of chunk hashes.
+    ///     Memory use does not grow with the chunk size: larger chunks are hashed and compressed piecewise, and a
+    ///     seekable stream is hashed before it is compressed, so known chunks cost no compression. Chunks are cut at
+    ///     fixed offsets or, with content-defined chunking (<see cref="UtilitiesLibrary.IBackupConfig.Chunking" />),
+    ///     where the content says. Chunks of zero bytes are not stored but listed as <c>zero:LENGTH</c>, and the holes
+    ///     of a sparse file (<see cref="ISparseReadable" />) are not even read but listed as <c>hole:LENGTH</c>.
     /// </summary>
     /// <param name="stream">Source stream to read from.</param>
     /// <param name="size">Expected size in bytes to read from the stream.</param>
     /// <param name="tag">Descriptive tag for logging and progress reporting.</param>
     /// <param name="progress">Optional callback invoked with bytes processed for progress tracking.</param>
-    /// <returns>List of hex-encoded SHA-512 hashes for each chunk.</returns>
+    /// <returns>List of hex-encoded SHA-512 hashes for each chunk, and of zero run and hole entries.</returns>
     List<string> SaveStream(Stream stream, long size, string tag, Action<long>? progress = null);
+
+    /// <summary>
+    ///     Hashes and stores an in-memory byte sequence, split into chunks exactly as <see cref="SaveStream" />
+    ///     would split the same bytes, and returns the list of chunk hashes.
+    /// </summary>
+    /// <param name="data">Bytes to store (for example a borrowed native buffer).</param>
+    /// <param name="tag">Descriptive tag for logging and progress reporting.</param>
+    /// <param name="progress">Optional callback invoked with bytes processed for progress tracking.</param>
+    /// <returns>List of hex-encoded SHA-512 hashes for each chunk; empty for empty input.</returns>
+    List<string> SaveBytes(ReadOnlySpan<byte> data, string tag, Action<long>? progress = null);
+
+    /// <summary>
+    ///     Stores a small metadata value (ACL text, xattr value) like <see cref="SaveBytes" />. Values already saved
+    ///     in this run are answered from a bounded cache keyed by their exact bytes, without hashing or archive
+    ///     lookups; the <c>value_cache_hits</c> / <c>value_cache_misses</c> entries of <see cref="Stats" /> count
+    ///     them.
+    /// </summary>
+    /// <param name="data">Bytes to store.</param>
+    /// <param name="tag">Descriptive tag for logging.</param>
+    /// <returns>List of hex-encoded SHA-512 hashes for each chunk; empty for empty input.</returns>
+    List<string> SaveValue(ReadOnlySpan<byte> data, string tag);
 }
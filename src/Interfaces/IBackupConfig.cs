@@ -37,6 +37,40 @@ public interface IBackupConfig
     /// </summary>
     int PrefixSplitThreshold { get; init; }
 
+    /// <summary>
+    ///     Threads scanning directories ahead of the backup traversal; 0 picks one per CPU.
+    /// </summary>
+    int ScanThreads { get; init; }
+
+    /// <summary>
+    ///     When <c>true</c>, reads the files of each directory in on-disk order instead of name order
+    ///     (for rotational disks).
+    /// </summary>
+    bool DiskOrder { get; init; }
+
+    /// <summary>
+    ///     Number of distinct small metadata values (ACL texts, xattr values) whose archive hashes are remembered
+    ///     for the run; 0 disables the cache.
+    /// </summary>
+    int ValueCacheEntries { get; init; }
+
+    /// <summary>
+    ///     When <c>true</c>, all user and group names are resolved once before the backup starts.
+    /// </summary>
+    bool PreloadOwnerNames { get; init; }
+
+    /// <summary>
+    ///     Hashing and compressing threads for files of several chunks (large chunks: where the file can be read
+    ///     by ranges); 0 stores chunks one after another.
+    /// </summary>
+    int PipelineThreads { get; init; }
+
+    /// <summary>
+    ///     How file content is cut into chunks: <c>fixed</c> (<see cref="ChunkSize" /> bytes) or content-defined,
+    ///     <c>cdc</c> or <c>cdc:MIN:AVG:MAX</c>; <c>null</c> keeps what the archive was created with.
+    /// </summary>
+    string? Chunking { get; init; }
+
     /// <summary>
     ///     Static singleton accessor for a default <see cref="IBackupConfig" /> implementation.
     ///     Implementations should provide a matching static property returning an `IBackupConfig` singleton.
@@ -0,0 +1,19 @@
+namespace OsCallsCommon;
+
+/// <summary>
+///     Scan of directory trees running ahead of the backup traversal, from
+///     <see cref="IHighLevelOsApi.OpenDirectoryScanner" />. The traversal still visits directories one by one, in its
+///     own order; the scanner only has their listings ready (or in progress) by the time they are asked for.
+/// </summary>
+public interface IDirectoryScanner : IDisposable
+{
+    /// <summary>
+    ///     <see cref="IHighLevelOsApi.ReadDirectory" /> for a directory inside the scanned trees: same result, taken
+    ///     from the scan when it already listed the directory.
+    /// </summary>
+    /// <param name="path">Directory path to enumerate</param>
+    /// <param name="directory">Minimal metadata of the directory itself (identifies it to the scan).</param>
+    /// <returns>Entries sorted by path, with their minimal metadata where collected.</returns>
+    /// <exception cref="T:OsCallsCommon.OsException">Thrown if directory cannot be read</exception>
+    DirectoryListingEntry[] ReadDirectory(string path, InodeData directory);
+}
@@ -1,3 +1,4 @@
+using System.Runtime.InteropServices;
 using System.Text.Json.Nodes;
 using ArchiveDataHandler;
 
@@ -28,6 +29,43 @@ public interface IHighLevelOsApi
     /// <exception cref="T:OsCallsCommon.OsException">Thrown on permission denied, not found, or I/O errors</exception>
     InodeData CreateMinimalInodeDataFromPath(string path);
 
+    /// <summary>
+    ///     Non-throwing variant of <see cref="CreateMinimalInodeDataFromPath" /> for the traversal hot path,
+    ///     where entries that vanished or cannot be read are expected outcomes: the failure is returned as an
+    ///     error code instead of being logged and thrown.
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <param name="data">Receives the minimal <see cref="InodeData" /> on success, null otherwise.</param>
+    /// <returns>
+    ///     0 on success, otherwise the native error code (errno on Linux, Win32 error on Windows), as accepted by
+    ///     <see cref="System.ComponentModel.Win32Exception(int)" />.
+    /// </returns>
+    int TryCreateMinimalInodeDataFromPath(string path, out InodeData? data);
+
+    /// <summary>
+    ///     Opens a handle on a directory whose entries are about to be processed. Passed to the overloads taking
+    ///     a <c>directory</c>, it lets the platform address each entry by name relative to the directory instead
+    ///     of resolving the full path again for every call.
+    /// </summary>
+    /// <param name="path">Directory path.</param>
+    /// <returns>
+    ///     The handle (dispose when done), or null if the platform has no such handles or the directory cannot be
+    ///     opened; the <c>directory</c> overloads then fall back to the path.
+    /// </returns>
+    SafeHandle? OpenDirectoryHandle(string path);
+
+    /// <summary>
+    ///     <see cref="TryCreateMinimalInodeDataFromPath(string, out InodeData)" /> for an entry of an open
+    ///     directory.
+    /// </summary>
+    /// <param name="directory">
+    ///     Handle from <see cref="OpenDirectoryHandle" /> on the parent of <paramref name="path" />, or null.
+    /// </param>
+    /// <param name="path">Full path of the entry; its last component is resolved relative to the handle.</param>
+    /// <param name="data">Receives the minimal <see cref="InodeData" /> on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native error code.</returns>
+    int TryCreateMinimalInodeDataFromPath(SafeHandle? directory, string path, out InodeData? data);
+
     /// <summary>
     ///     Completes an existing <see cref="InodeData" /> instance with ACLs, xattrs, and content hashes for the specified
     ///     path.
@@ -40,6 +78,24 @@ public interface IHighLevelOsApi
     /// <returns>Completed <see cref="InodeData" /> instance.</returns>
     InodeData CompleteInodeDataFromPath(string path, ref InodeData data, IArchiveStore archiveStore);
 
+    /// <summary>
+    ///     <see cref="CompleteInodeDataFromPath(string, ref InodeData, IArchiveStore)" /> for an entry of an open
+    ///     directory.
+    /// </summary>
+    /// <param name="directory">
+    ///     Handle from <see cref="OpenDirectoryHandle" /> on the parent of <paramref name="path" />, or null.
+    /// </param>
+    /// <param name="path">Full path of the entry (also used to tag stored streams).</param>
+    /// <param name="data">Reference to an existing <see cref="InodeData" /> to complete.</param>
+    /// <param name="archiveStore">Archive store used to save auxiliary data streams.</param>
+    /// <returns>Completed <see cref="InodeData" /> instance.</returns>
+    InodeData CompleteInodeDataFromPath(
+        SafeHandle? directory,
+        string path,
+        ref InodeData data,
+        IArchiveStore archiveStore
+    );
+
     /// <summary>
     ///     List directory entries for breadth-first traversal.
     ///     Returns full paths, sorted, excluding "." and "..".
@@ -51,6 +107,43 @@ public interface IHighLevelOsApi
     /// <exception cref="T:OsCallsCommon.OsException">Thrown if directory cannot be read</exception>
     string[] ListDirectory(string path);
 
+    /// <summary>
+    ///     <see cref="ListDirectory" /> together with each child's minimal <see cref="InodeData" />, collected in
+    ///     bulk where the platform supports it (one native call per directory on Linux), so the traversal does not
+    ///     have to stat every child again. Same paths and order as <see cref="ListDirectory" />.
+    /// </summary>
+    /// <param name="path">Directory path to enumerate</param>
+    /// <returns>Entries sorted by path; their <c>Data</c> is null where not collected.</returns>
+    /// <exception cref="T:OsCallsCommon.OsException">Thrown if directory cannot be read</exception>
+    DirectoryListingEntry[] ReadDirectory(string path);
+
+    /// <summary>
+    ///     Starts scanning the directory trees below <paramref name="roots" /> on background threads, so that
+    ///     listings (with metadata) are read in parallel ahead of a traversal that consumes them through
+    ///     <see cref="IDirectoryScanner.ReadDirectory" />. Only the devices of the roots are scanned.
+    /// </summary>
+    /// <param name="roots">Backup roots.</param>
+    /// <param name="excluded">Paths whose subtrees the traversal skips (e.g. the archive).</param>
+    /// <param name="threads">Worker threads; 0 picks a default.</param>
+    /// <returns>The scanner (dispose when done), or null if the platform has none or it cannot be started.</returns>
+    IDirectoryScanner? OpenDirectoryScanner(IReadOnlyList<string> roots, IReadOnlyList<string> excluded, int threads);
+
+    /// <summary>
+    ///     Physical disk offsets of the first data block of files in one directory, so their contents can be
+    ///     read in on-disk order instead of name order.
+    /// </summary>
+    /// <param name="directory">Directory containing the files.</param>
+    /// <param name="names">File names within <paramref name="directory" />.</param>
+    /// <returns>One byte offset per name (-1 where unknown), or null if the platform cannot tell.</returns>
+    long[]? GetDataOffsets(string directory, IReadOnlyList<string> names);
+
+    /// <summary>
+    ///     Resolves every user and group name the system can enumerate up front, so that owner lookups during the
+    ///     backup do not wait on a remote directory service (LDAP, SSSD).
+    /// </summary>
+    /// <returns>Number of names cached; 0 if the platform has no such cache.</returns>
+    int PreloadOwnerNames();
+
     /// <summary>
     ///     Canonicalizes a filesystem path by resolving symlinks and normalizing separators.
     ///     Returns a JsonNode containing the canonical path.
@@ -0,0 +1,18 @@
+namespace ArchiveDataHandler;
+
+/// <summary>
+///     A content stream whose data can also be read in ranges by independent readers at the same time (positional
+///     reads on one file), which lets <see cref="IArchiveStore.SaveStream" /> store the chunks of a large file
+///     concurrently.
+/// </summary>
+public interface IRangeReadable
+{
+    /// <summary>
+    ///     Opens a stream over <paramref name="length" /> bytes from <paramref name="offset" />, with its own position
+    ///     and independent of this one and of other ranges; disposing it leaves the underlying file open.
+    /// </summary>
+    /// <param name="offset">Start of the range in the content.</param>
+    /// <param name="length">Length of the range; it ends early at end of content.</param>
+    /// <returns>A readable, seekable stream positioned at <paramref name="offset" />.</returns>
+    Stream OpenRange(long offset, long length);
+}
@@ -0,0 +1,21 @@
+namespace ArchiveDataHandler;
+
+/// <summary>
+///     A content stream that knows where its file has data, which lets <see cref="IArchiveStore.SaveStream" /> record
+///     the holes of a sparse file instead of reading, hashing and compressing them as zeros.
+/// </summary>
+public interface ISparseReadable
+{
+    /// <summary>
+    ///     Finds the first stretch of data at or after <paramref name="offset" />. Content without hole information
+    ///     is all data.
+    /// </summary>
+    /// <param name="offset">Offset in the content to search from.</param>
+    /// <param name="start">Receives the start of the data; <paramref name="offset" /> if it lies in data.</param>
+    /// <param name="end">Receives the end of the data: the next hole, or end of content.</param>
+    /// <returns>
+    ///     <c>false</c> if only a hole follows <paramref name="offset" /> up to end of content, or
+    ///     <paramref name="offset" /> is at or past it (the content may have shrunk).
+    /// </returns>
+    bool TryFindData(long offset, out long start, out long end);
+}
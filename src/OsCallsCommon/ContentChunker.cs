@@ -0,0 +1,128 @@
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace OsCallsCommon;
+
+/// <summary>
+///     Content-defined chunk boundaries (FastCDC style) from the native chunker of OsCallsCommonShim. Boundaries
+///     depend only on the content and the three sizes, so an insertion or deletion moves the chunks after it
+///     instead of changing them, and they still deduplicate.
+/// </summary>
+public sealed unsafe partial class ContentChunker
+{
+    /// <summary>
+    ///     Largest <see cref="MaxSize" /> allowed, 256 MiB, so a window of a few maximal chunks still fits an array.
+    /// </summary>
+    public const int MaxChunkSize = 256 << 20;
+
+    private const uint Final = 0x1;
+
+#if DEDUBA_LINUX
+    private const string NativeLibraryName = "libOsCallsCommonShim.so";
+
+#endif
+#if DEDUBA_WINDOWS
+    private const string NativeLibraryName = "OsCallsCommonShim";
+#endif
+
+    private readonly Params _params;
+
+    /// <summary>
+    ///     Initializes a new instance of the <see cref="ContentChunker" /> class.
+    /// </summary>
+    /// <param name="minSize">Bytes at the start of a chunk that are never cut; at least 64.</param>
+    /// <param name="avgSize">Target mean chunk size; above <paramref name="minSize" />.</param>
+    /// <param name="maxSize">
+    ///     Size at which a chunk is cut at the latest; above <paramref name="avgSize" />, at most
+    ///     <see cref="MaxChunkSize" />.
+    /// </param>
+    /// <exception cref="ArgumentOutOfRangeException">The sizes are not ordered as required.</exception>
+    public ContentChunker(int minSize, int avgSize, int maxSize)
+    {
+        ArgumentOutOfRangeException.ThrowIfLessThan(minSize, 64);
+        ArgumentOutOfRangeException.ThrowIfLessThanOrEqual(avgSize, minSize);
+        ArgumentOutOfRangeException.ThrowIfLessThanOrEqual(maxSize, avgSize);
+        ArgumentOutOfRangeException.ThrowIfGreaterThan(maxSize, MaxChunkSize);
+        _params = new Params
+        {
+            MinSize = minSize,
+            AvgSize = avgSize,
+            MaxSize = maxSize,
+        };
+    }
+
+    /// <summary>Bytes at the start of a chunk that are never cut.</summary>
+    public int MinSize => _params.MinSize;
+
+    /// <summary>Target mean chunk size.</summary>
+    public int AvgSize => _params.AvgSize;
+
+    /// <summary>Largest chunk size.</summary>
+    public int MaxSize => _params.MaxSize;
+
+    /// <summary>
+    ///     Gets a value indicating whether boundaries are found with the AVX2 kernel (where the CPU has it and it
+    ///     measured faster than the scalar one) rather than the scalar one; both cut at the same offsets.
+    /// </summary>
+    public static bool VectorKernel => GetChunkerKernel() == 1;
+
+    /// <summary>
+    ///     Finds the ends of the chunks in <paramref name="data" />, which starts at a chunk boundary. Unless
+    ///     <paramref name="final" /> is set, the bytes after the last end found are an incomplete chunk, to be
+    ///     passed again at the start of the next call together with the content that follows. A buffer holding
+    ///     at least <see cref="MaxSize" /> bytes always yields a chunk.
+    /// </summary>
+    /// <param name="data">Content.</param>
+    /// <param name="final">Whether <paramref name="data" /> ends the content, so the last chunk may be short.</param>
+    /// <param name="cuts">
+    ///     Receives the chunk ends, relative to <paramref name="data" />; when it fills up, the next call starts at
+    ///     the last one.
+    /// </param>
+    /// <returns>Number of entries written to <paramref name="cuts" />.</returns>
+    public int FindBoundaries(ReadOnlySpan<byte> data, bool final, Span<long> cuts)
+    {
+        int count;
+        int error;
+        var @params = _params;
+        fixed (byte* d = data)
+        fixed (long* c = cuts)
+            error = FindChunkBoundaries(d, data.Length, &@params, final ? Final : 0, c, cuts.Length, &count);
+        // The sizes were checked by the constructor
+        if (error != 0)
+            throw new InvalidOperationException($"FindChunkBoundaries failed with errno {error}");
+        return count;
+    }
+
+    /// <summary>
+    ///     Returns the chunking specification this chunker is built from, <c>cdc:MIN:AVG:MAX</c>.
+    /// </summary>
+    public override string ToString()
+    {
+        return $"cdc:{MinSize}:{AvgSize}:{MaxSize}";
+    }
+
+    [LibraryImport(NativeLibraryName, EntryPoint = "FindChunkBoundaries")]
+    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static partial int FindChunkBoundaries(
+        byte* data,
+        long length,
+        Params* @params,
+        uint flags,
+        long* cuts,
+        int capacity,
+        int* count
+    );
+
+    [LibraryImport(NativeLibraryName, EntryPoint = "GetChunkerKernel")]
+    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static partial int GetChunkerKernel();
+
+    // Mirrors OsCalls::ChunkerParams
+    [StructLayout(LayoutKind.Sequential)]
+    private struct Params
+    {
+        public int MinSize;
+        public int AvgSize;
+        public int MaxSize;
+    }
+}
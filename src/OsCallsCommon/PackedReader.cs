@@ -0,0 +1,141 @@
+using System.Text;
+
+namespace OsCallsCommon;
+
+/// <summary>
+///     Wire type stored in the low three bits of a packed field tag. Mirrors <c>OsCalls::WireType</c> in Packed.h.
+/// </summary>
+public enum WireType
+{
+    /// <summary>Zigzag-encoded signed 64-bit varint (booleans are 0/1).</summary>
+    Varint = 0,
+
+    /// <summary>Length-prefixed raw bytes (strings are UTF-8 without terminator).</summary>
+    Bytes = 1,
+
+    /// <summary>Zigzag tv_sec varint followed by tv_nsec varint.</summary>
+    TimeSpec = 2,
+}
+
+/// <summary>
+///     Forward-only decoder for the packed result encoding produced by the native <c>*_packed</c> exports
+///     (see Packed.h for the wire format). Reads directly from a span over the native buffer; nothing is
+///     allocated except for strings the caller asks for.
+/// </summary>
+public ref struct PackedReader
+{
+    private readonly ReadOnlySpan<byte> _data;
+    private int _pos;
+
+    /// <summary>
+    ///     Starts decoding <paramref name="data" /> and reads the leading schema id.
+    /// </summary>
+    /// <param name="data">Complete packed buffer.</param>
+    public PackedReader(ReadOnlySpan<byte> data)
+    {
+        _data = data;
+        _pos = 0;
+        Schema = checked((uint)ReadVarint());
+    }
+
+    /// <summary>Schema id the buffer was encoded with.</summary>
+    public uint Schema { get; }
+
+    /// <summary>
+    ///     Reads the next field tag.
+    /// </summary>
+    /// <param name="id">Receives the field id.</param>
+    /// <param name="wire">Receives the wire type of the payload that follows.</param>
+    /// <returns>false at the end of the buffer.</returns>
+    public bool TryReadField(out uint id, out WireType wire)
+    {
+        if (_pos >= _data.Length)
+        {
+            id = 0;
+            wire = default;
+            return false;
+        }
+
+        var tag = ReadVarint();
+        id = checked((uint)(tag >> 3));
+        wire = (WireType)(tag & 7);
+        return true;
+    }
+
+    /// <summary>Reads a <see cref="WireType.Varint" /> payload.</summary>
+    public long ReadInt64()
+    {
+        var v = ReadVarint();
+        return (long)(v >> 1) ^ -(long)(v & 1);
+    }
+
+    /// <summary>Reads a <see cref="WireType.Varint" /> payload written from a bool.</summary>
+    public bool ReadBoolean()
+    {
+        return ReadInt64() != 0;
+    }
+
+    /// <summary>Reads a <see cref="WireType.Bytes" /> payload as a span into the buffer.</summary>
+    public ReadOnlySpan<byte> ReadBytes()
+    {
+        var len = checked((int)ReadVarint());
+        if (len > _data.Length - _pos)
+            throw new InvalidDataException($"Packed bytes field of {len} bytes overruns buffer at {_pos}");
+        var bytes = _data.Slice(_pos, len);
+        _pos += len;
+        return bytes;
+    }
+
+    /// <summary>Reads a <see cref="WireType.Bytes" /> payload as UTF-8 text.</summary>
+    public string ReadString()
+    {
+        return Encoding.UTF8.GetString(ReadBytes());
+    }
+
+    /// <summary>Reads a <see cref="WireType.TimeSpec" /> payload.</summary>
+    public ValXfer.TimeSpecT ReadTimeSpec()
+    {
+        var sec = ReadInt64();
+        var nsec = (long)ReadVarint();
+        return new ValXfer.TimeSpecT(sec, nsec);
+    }
+
+    /// <summary>
+    ///     Skips the payload of a field the caller does not know, so newer shims stay readable.
+    /// </summary>
+    /// <param name="wire">Wire type returned by <see cref="TryReadField" />.</param>
+    public void Skip(WireType wire)
+    {
+        switch (wire)
+        {
+            case WireType.Varint:
+                ReadVarint();
+                break;
+            case WireType.Bytes:
+                ReadBytes();
+                break;
+            case WireType.TimeSpec:
+                ReadVarint();
+                ReadVarint();
+                break;
+            default:
+                throw new InvalidDataException($"Unknown packed wire type {wire} at {_pos}");
+        }
+    }
+
+    private ulong ReadVarint()
+    {
+        ulong result = 0;
+        for (var shift = 0; shift < 64; shift += 7)
+        {
+            if (_pos >= _data.Length)
+                throw new InvalidDataException($"Truncated packed varint at {_pos}");
+            var b = _data[_pos++];
+            result |= (ulong)(b & 0x7f) << shift;
+            if (b < 0x80)
+                return result;
+        }
+
+        throw new InvalidDataException($"Overlong packed varint at {_pos}");
+    }
+}
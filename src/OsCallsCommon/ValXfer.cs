@@ -1,7 +1,9 @@
 using System.ComponentModel;
+using System.Diagnostics.CodeAnalysis;
 using System.Reflection;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
+using System.Text;
 using System.Text.Json.Nodes;
 using UtilitiesLibrary;
 
@@ -166,8 +168,22 @@ public static unsafe partial class ValXfer
 
         /// <summary>Current value is a boolean.</summary>
         IsBoolean,
+
+        /// <summary>Current value is a length-prefixed byte sequence (<see cref="ValueT.Length" /> bytes).</summary>
+        IsBytes,
     }
 
+    /// <summary>
+    ///     Callback receiving a borrowed view of native bytes. The span is only valid for the duration of the call.
+    /// </summary>
+    public delegate TResult BytesFunc<out TResult>(ReadOnlySpan<byte> bytes);
+
+    /// <summary>
+    ///     Callback decoding a packed native result. The reader borrows the native buffer, which is freed as soon
+    ///     as the call returns.
+    /// </summary>
+    public delegate TResult PackedFunc<out TResult>(ref PackedReader reader);
+
 #if DEDUBA_LINUX
     private const string NativeLibraryName = "libOsCallsCommonShim.so";
 
@@ -176,10 +192,258 @@ public static unsafe partial class ValXfer
     private const string NativeLibraryName = "OsCallsCommonShim";
 #endif
 
-    [LibraryImport(NativeLibraryName)]
+    [LibraryImport(NativeLibraryName, EntryPoint = "GetNextValue")]
     [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
     [return: MarshalAs(UnmanagedType.Bool)]
-    private static partial bool GetNextValue(ValueT* value);
+    private static partial bool GetNextValueImport(ValueT* value);
+
+    [LibraryImport(NativeLibraryName, EntryPoint = "ReleaseHandle")]
+    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static partial void ReleaseHandleImport(ValueT* value);
+
+    [LibraryImport(NativeLibraryName, EntryPoint = "FreeBuffer")]
+    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static partial void FreeBufferImport(void* buffer);
+
+    // Cursor functions taken from a platform shim's dispatch table; null until UseCursorFunctions is called.
+    private static delegate* unmanaged[Cdecl]<ValueT*, byte> _getNextValue;
+    private static delegate* unmanaged[Cdecl]<ValueT*, void> _releaseHandle;
+    private static delegate* unmanaged[Cdecl]<void*, void> _freeBuffer;
+
+    /// <summary>
+    ///     Routes cursor iteration and release through function pointers from a platform shim's dispatch table
+    ///     instead of P/Invokes into OsCallsCommonShim. The pointers must operate on the same cursor pool as the
+    ///     common shim (the platform shim links against it).
+    /// </summary>
+    /// <param name="getNextValue">Shim-local GetNextValue.</param>
+    /// <param name="releaseHandle">ReleaseHandle of the common shim.</param>
+    /// <param name="freeBuffer">FreeBuffer of the common shim.</param>
+    public static void UseCursorFunctions(
+        delegate* unmanaged[Cdecl]<ValueT*, byte> getNextValue,
+        delegate* unmanaged[Cdecl]<ValueT*, void> releaseHandle,
+        delegate* unmanaged[Cdecl]<void*, void> freeBuffer
+    )
+    {
+        _getNextValue = getNextValue;
+        _releaseHandle = releaseHandle;
+        _freeBuffer = freeBuffer;
+    }
+
+    private static bool GetNextValue(ValueT* value)
+    {
+        return _getNextValue != null ? _getNextValue(value) != 0 : GetNextValueImport(value);
+    }
+
+    private static void ReleaseHandle(ValueT* value)
+    {
+        if (_releaseHandle != null)
+            _releaseHandle(value);
+        else
+            ReleaseHandleImport(value);
+    }
+
+    private static void FreeBuffer(void* buffer)
+    {
+        if (_freeBuffer != null)
+            _freeBuffer(buffer);
+        else
+            FreeBufferImport(buffer);
+    }
+
+    [LibraryImport(NativeLibraryName, EntryPoint = "GetPoolStats")]
+    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static partial void GetPoolStatsNative(PoolStats* stats);
+
+    /// <summary>
+    ///     Reads the native cursor pool counters. <see cref="PoolStats.LiveHandles" /> must return to its previous
+    ///     value once every cursor handed out has been consumed by <see cref="ToNode" />.
+    /// </summary>
+    public static PoolStats GetPoolStats()
+    {
+        PoolStats stats;
+        GetPoolStatsNative(&stats);
+        return stats;
+    }
+
+    /// <summary>
+    ///     Reports a native errno exactly like <see cref="ToNode" /> does for an error cursor: logs it and throws
+    ///     a generic <see cref="Exception" /> whose InnerException is the <see cref="Win32Exception" />.
+    ///     Used by flat (cursor-free) native calls that return errno directly.
+    /// </summary>
+    /// <param name="errno">Native errno value.</param>
+    /// <param name="file">Logical file/resource for error reporting.</param>
+    /// <param name="op">Operation name (native API) for error reporting.</param>
+    [DoesNotReturn]
+    public static void ThrowNativeError(int errno, string file, string op)
+    {
+        var win32Exception = new Win32Exception(errno); //$"{nameof(ToNode)} found {op} caused error {errno}"
+        // Report the error via the utilities layer (which may log or rethrow depending on the test harness).
+        Logger!.Error(file, op, win32Exception);
+        // Always rethrow a generic Exception wrapper with the Win32Exception as InnerException so
+        // callers and tests consistently receive a System.Exception containing the native error.
+        throw new Exception($"{op} failed with error {win32Exception.Message}", win32Exception);
+    }
+
+    /// <summary>
+    ///     Passes the single <see cref="TypeT.IsBytes" /> value of a native cursor to <paramref name="func" /> as a
+    ///     span over the native buffer, without copying or decoding it. Errors are reported like
+    ///     <see cref="ToNode" />. Takes ownership of <paramref name="value" /> and releases it afterwards.
+    /// </summary>
+    /// <param name="value">Pointer to a value cursor initialized by native code.</param>
+    /// <param name="file">Logical file/resource for error reporting.</param>
+    /// <param name="op">Operation name (native API) for error reporting.</param>
+    /// <param name="func">Consumer of the bytes; must not keep the span.</param>
+    /// <returns>The result of <paramref name="func" />.</returns>
+    public static TResult WithBytes<TResult>(ValueT* value, string file, string op, BytesFunc<TResult> func)
+    {
+        if (value == null)
+            throw new ArgumentNullException(nameof(value));
+        try
+        {
+            var maybeError = (int)value->Number;
+            var wasOk = value->Type;
+            var more = GetNextValue(value);
+            if (wasOk == TypeT.IsError)
+                ThrowNativeError(maybeError, file, op);
+            if (!more || value->Type != TypeT.IsBytes)
+                throw new ArgumentException($"{op} expected {TypeT.IsBytes:G}, got {value->Type:G}", nameof(value));
+            return func(new ReadOnlySpan<byte>((void*)value->String, checked((int)value->Length)));
+        }
+        finally
+        {
+            ReleaseHandle(value);
+        }
+    }
+
+    /// <summary>
+    ///     Decodes the result of a packed native call (<c>int fn(..., uint8_t **data, int64_t *length)</c>) from a
+    ///     single span and frees the native buffer afterwards. A nonzero <paramref name="errno" /> is reported like
+    ///     <see cref="ToNode" /> reports an error cursor.
+    /// </summary>
+    /// <param name="errno">Return value of the native call.</param>
+    /// <param name="data">Buffer returned by the native call; owned by this method.</param>
+    /// <param name="length">Encoded length returned by the native call.</param>
+    /// <param name="file">Logical file/resource for error reporting.</param>
+    /// <param name="op">Operation name (native API) for error reporting.</param>
+    /// <param name="func">Decoder; must not keep spans obtained from the reader.</param>
+    /// <returns>The result of <paramref name="func" />.</returns>
+    public static TResult DecodePacked<TResult>(
+        int errno,
+        byte* data,
+        long length,
+        string file,
+        string op,
+        PackedFunc<TResult> func
+    )
+    {
+        try
+        {
+            if (errno != 0)
+                ThrowNativeError(errno, file, op);
+            var reader = new PackedReader(new ReadOnlySpan<byte>(data, checked((int)length)));
+            return func(ref reader);
+        }
+        finally
+        {
+            FreeBuffer(data);
+        }
+    }
+
+    /// <summary>
+    ///     Non-throwing counterpart of <see cref="ToNode" />: an error cursor is released and its errno returned,
+    ///     with nothing logged or thrown, so expected failures (ENOENT, ENODATA, ENOTSUP) cost no exception.
+    /// </summary>
+    /// <param name="value">Pointer to a value cursor initialized by native code; owned by this method.</param>
+    /// <param name="file">Logical file/resource for reporting malformed cursors.</param>
+    /// <param name="op">Operation name (native API) for reporting malformed cursors.</param>
+    /// <param name="node">Receives the converted result, or null on error.</param>
+    /// <returns>0 on success, otherwise the native error number.</returns>
+    public static int TryToNode(ValueT* value, string file, string op, out JsonNode? node)
+    {
+        if (TryTakeError(value, out var errno))
+        {
+            node = null;
+            return errno;
+        }
+
+        node = ToNode(value, file, op);
+        return 0;
+    }
+
+    /// <summary>
+    ///     Non-throwing counterpart of <see cref="WithBytes{TResult}" />; see <see cref="TryToNode" />.
+    /// </summary>
+    /// <param name="value">Pointer to a value cursor initialized by native code; owned by this method.</param>
+    /// <param name="file">Logical file/resource for reporting malformed cursors.</param>
+    /// <param name="op">Operation name (native API) for reporting malformed cursors.</param>
+    /// <param name="func">Consumer of the bytes; must not keep the span.</param>
+    /// <param name="result">Receives the result of <paramref name="func" />, or default on error.</param>
+    /// <returns>0 on success, otherwise the native error number.</returns>
+    public static int TryWithBytes<TResult>(
+        ValueT* value,
+        string file,
+        string op,
+        BytesFunc<TResult> func,
+        out TResult? result
+    )
+    {
+        if (TryTakeError(value, out var errno))
+        {
+            result = default;
+            return errno;
+        }
+
+        result = WithBytes(value, file, op, func);
+        return 0;
+    }
+
+    /// <summary>
+    ///     Non-throwing counterpart of <see cref="DecodePacked{TResult}" />: a nonzero <paramref name="errno" /> is
+    ///     returned as is, without logging or throwing. The buffer is freed in either case.
+    /// </summary>
+    /// <param name="errno">Return value of the native call.</param>
+    /// <param name="data">Buffer returned by the native call; owned by this method.</param>
+    /// <param name="length">Encoded length returned by the native call.</param>
+    /// <param name="func">Decoder; must not keep spans obtained from the reader.</param>
+    /// <param name="result">Receives the result of <paramref name="func" />, or default on error.</param>
+    /// <returns><paramref name="errno" />.</returns>
+    public static int TryDecodePacked<TResult>(
+        int errno,
+        byte* data,
+        long length,
+        PackedFunc<TResult> func,
+        out TResult? result
+    )
+    {
+        if (errno != 0)
+        {
+            FreeBuffer(data);
+            result = default;
+            return errno;
+        }
+
+        result = DecodePacked(0, data, length, "", "", func);
+        return 0;
+    }
+
+    // Releases an error cursor and yields its errno. Cursors that are not errors, and error cursors without an
+    // errno (which the throwing path reports as malformed), are left to the caller.
+    private static bool TryTakeError(ValueT* value, out int errno)
+    {
+        if (value == null)
+            throw new ArgumentNullException(nameof(value));
+        errno = (int)value->Number;
+        if (value->Type != TypeT.IsError || errno == 0)
+            return false;
+        ReleaseHandle(value);
+        return true;
+    }
+
+    // IsBytes values surface in JSON as UTF-8 text, matching the former NUL-terminated string values.
+    private static string BytesToString(ValueT* value)
+    {
+        return Encoding.UTF8.GetString((byte*)value->String, checked((int)value->Length));
+    }
 
     /// <summary>
     ///     Converts a native <see cref="ValueT" /> stream into a <see cref="JsonNode" />.
@@ -189,23 +453,32 @@ public static unsafe partial class ValXfer
     /// <param name="op">Operation name (native API) for error reporting.</param>
     /// <returns>A populated JsonArray or JsonObject depending on the native sequence.</returns>
     /// <exception cref="Win32Exception">If the native layer signaled an error.</exception>
+    /// <remarks>
+    ///     Takes ownership of <paramref name="value" />: the cursor is released via the native ReleaseHandle when
+    ///     conversion finishes, including when it ends early with an exception.
+    /// </remarks>
     public static JsonNode ToNode(ValueT* value, string file, string op)
     {
         if (value == null)
             throw new ArgumentNullException(nameof(value));
+        try
+        {
+            return ToNodeCore(value, file, op);
+        }
+        finally
+        {
+            ReleaseHandle(value);
+        }
+    }
+
+    private static JsonNode ToNodeCore(ValueT* value, string file, string op)
+    {
         ShowValue(value, "", op);
         var maybeError = (int)value->Number;
         var wasOk = value->Type;
         var more = GetNextValue(value);
         if (wasOk == TypeT.IsError)
-        {
-            var win32Exception = new Win32Exception(maybeError); //$"{nameof(ToNode)} found {op} caused error {maybeError}"
-            // Report the error via the utilities layer (which may log or rethrow depending on the test harness).
-            Logger!.Error(file, op, win32Exception);
-            // Always rethrow a generic Exception wrapper with the Win32Exception as InnerException so
-            // callers and tests consistently receive a System.Exception containing the native error.
-            throw new Exception($"{op} failed with error {win32Exception.Message}", win32Exception);
-        }
+            ThrowNativeError(maybeError, file, op);
 
         var name =
             Marshal.PtrToStringUTF8(value->Name)
@@ -233,6 +506,9 @@ public static unsafe partial class ValXfer
                     case TypeT.IsBoolean:
                         array.Add(value->Boolean);
                         break;
+                    case TypeT.IsBytes:
+                        array.Add(BytesToString(value));
+                        break;
                     default:
                         throw new ArgumentException(
                             $"{op} Invalid ValueT type {value->Type:G}.{value->Handle.index}",
@@ -267,6 +543,9 @@ public static unsafe partial class ValXfer
                 case TypeT.IsBoolean:
                     obj[name] = value->Boolean;
                     break;
+                case TypeT.IsBytes:
+                    obj[name] = BytesToString(value);
+                    break;
                 default:
                     throw new ArgumentException(
                         $"{op} Invalid ValueT type {value->Type:G}.{value->Handle.index}",
@@ -336,6 +615,9 @@ public static unsafe partial class ValXfer
         /// <summary>Boolean value when <see cref="Type" /> is <see cref="TypeT.IsBoolean" />.</summary>
         public bool Boolean { get; init; }
 
+        /// <summary>Byte count when <see cref="Type" /> is <see cref="TypeT.IsBytes" />.</summary>
+        public long Length { get; init; }
+
         /// <summary>Nested structure (optional, see <see cref="ToObject(ValueT*, int)" />).</summary>
         public ValueObject? Complex { get; set; }
 
@@ -352,6 +634,7 @@ public static unsafe partial class ValXfer
                 TypeT.IsNumber => $"[{Handle}] {Name}: {Number}",
                 TypeT.IsString => $"[{Handle}] {Name}: \"{String}\"",
                 TypeT.IsBoolean => $"[{Handle}] {Name}: {Boolean}",
+                TypeT.IsBytes => $"[{Handle}] {Name}: [{Length} bytes]",
                 TypeT.IsTimeSpec => $"[{Handle}] {Name}: {TvSec}.{TvNsec:D9}s",
                 TypeT.IsComplex => $"[{Handle}] {Name}: [{Complex}]",
                 TypeT.IsError => $"[{Handle}] {Name}: [Error {Number}]",
@@ -407,7 +690,11 @@ public static unsafe partial class ValXfer
             TvNsec = value->TimeSpec.TvNsec,
             Number = value->Number,
             Name = value->Name != IntPtr.Zero ? Marshal.PtrToStringUTF8(value->Name) : null,
-            String = value->String != IntPtr.Zero ? Marshal.PtrToStringUTF8(value->String) : null,
+            String =
+                value->Type == TypeT.IsBytes ? BytesToString(value)
+                : value->String != IntPtr.Zero ? Marshal.PtrToStringUTF8(value->String)
+                : null,
+            Length = value->Length,
             Boolean = value->Boolean,
             Type = value->Type,
             Complex = null,
@@ -435,6 +722,24 @@ public static unsafe partial class ValXfer
 
         /// <summary>Current iteration index (incremented by GetNextValue).</summary>
         public Int64 index;
+
+        private readonly void* release;
+    }
+
+    /// <summary>
+    ///     Managed mirror of the native <c>OsCalls::PoolStats</c> counters (see ValuePool.h).
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public readonly struct PoolStats
+    {
+        /// <summary>Cursors allocated and not yet released.</summary>
+        public readonly long LiveHandles;
+
+        /// <summary>Scratch buffers allocated and not yet freed.</summary>
+        public readonly long LiveBuffers;
+
+        /// <summary>Allocations that could not be served from a free list.</summary>
+        public readonly long HeapAllocs;
     }
 
     /// <summary>
@@ -443,6 +748,13 @@ public static unsafe partial class ValXfer
     [StructLayout(LayoutKind.Sequential, Pack = 8)]
     public readonly struct TimeSpecT
     {
+        /// <summary>Creates a timespec from its two components.</summary>
+        public TimeSpecT(long tvSec, long tvNsec)
+        {
+            TvSec = tvSec;
+            TvNsec = tvNsec;
+        }
+
         /// <summary>Seconds since epoch.</summary>
         public readonly long TvSec;
 
@@ -482,5 +794,8 @@ public static unsafe partial class ValXfer
         /// <summary>Boolean value when Type == IsBoolean.</summary>
         [MarshalAs(UnmanagedType.I1)]
         public readonly bool Boolean;
+
+        /// <summary>Byte count at <see cref="String" /> when Type == IsBytes.</summary>
+        public readonly Int64 Length;
     }
 }
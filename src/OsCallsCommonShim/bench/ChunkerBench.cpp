@@ -0,0 +1,130 @@
+/**
+ * @file ChunkerBench.cpp
+ * @brief Benchmark of the content-defined chunker: speed and deduplication.
+ *
+ * Speed: FindChunkBoundaries over a buffer of pseudo-random data with the
+ * scalar kernel, the vector one (AVX2 where available) and the default choice
+ * between them, single-threaded, in GB/s per core. All must cut at the same
+ * offsets.
+ *
+ * Deduplication: three versions of a file are stored as fixed-size chunks
+ * (AvgSize bytes) and as content-defined chunks: the original, a copy with
+ * one byte inserted near the start, and that copy with 64 small insertions
+ * and deletions spread over it. Reported is the logical size over the size of
+ * the distinct chunks, as in an archive holding all three.
+ *
+ * Build with -DOSCALLS_BUILD_BENCH=ON and run
+ * OsCallsChunkerBench [MiB] [min avg max].
+ */
+#include "Platform.h"
+// Platform.h must come first
+#include "Chunker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+using namespace OsCalls;
+
+namespace {
+std::vector<int64_t> boundaries(const std::vector<uint8_t> &data, const ChunkerParams &params, uint32_t flags) {
+    std::vector<int64_t> cuts(data.size() / size_t(params.MinSize) + 2);
+    int32_t              count = 0;
+    if (FindChunkBoundaries(data.data(), int64_t(data.size()), &params, flags | CHUNKER_FINAL, cuts.data(),
+                            int32_t(cuts.size()), &count) != 0) {
+        std::fprintf(stderr, "FindChunkBoundaries rejected min %d avg %d max %d\n", params.MinSize, params.AvgSize,
+                     params.MaxSize);
+        std::exit(2);
+    }
+    cuts.resize(size_t(count));
+    return cuts;
+}
+
+double gbps(const std::vector<uint8_t> &data, const ChunkerParams &params, uint32_t flags,
+            std::vector<int64_t> *cuts) {
+    auto best = 1e30;
+    for (auto round = 0; round < 3; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        *cuts = boundaries(data, params, flags);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return double(data.size()) / best / 1e9;
+}
+
+// Adds the chunks of @p data to @p seen; returns the bytes not seen before
+size_t store(const std::vector<uint8_t> &data, const std::vector<int64_t> &cuts,
+             std::unordered_set<std::string_view> &seen) {
+    size_t  added = 0;
+    int64_t start = 0;
+    for (auto cut : cuts) {
+        std::string_view chunk(reinterpret_cast<const char *>(data.data()) + start, size_t(cut - start));
+        if (seen.insert(chunk).second)
+            added += chunk.size();
+        start = cut;
+    }
+    return added;
+}
+
+std::vector<int64_t> fixed(size_t size, int32_t chunk) {
+    std::vector<int64_t> cuts;
+    for (size_t end = size_t(chunk); end < size + size_t(chunk); end += size_t(chunk))
+        cuts.push_back(int64_t(std::min(end, size)));
+    return cuts;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    auto         mib = argc > 1 ? std::atoi(argv[1]) : 256;
+    ChunkerParams params{256 << 10, 1 << 20, 4 << 20};
+    if (argc > 4)
+        params = {std::atoi(argv[2]), std::atoi(argv[3]), std::atoi(argv[4])};
+
+    std::mt19937_64      random(42);
+    std::vector<uint8_t> data(size_t(mib) << 20);
+    for (auto &b : data)
+        b = uint8_t(random());
+
+    std::printf("kernel %s, %d MiB, min %d avg %d max %d\n", GetChunkerKernel() == 1 ? "avx2" : "scalar", mib,
+                params.MinSize, params.AvgSize, params.MaxSize);
+    std::vector<int64_t> scalarCuts, vectorCuts, cuts;
+    auto                 scalar = gbps(data, params, CHUNKER_SCALAR, &scalarCuts);
+    auto                 vector = gbps(data, params, CHUNKER_VECTOR, &vectorCuts);
+    auto                 chosen = gbps(data, params, 0, &cuts);
+    std::printf("%-8s %8.2f GB/s\n%-8s %8.2f GB/s\n%-8s %8.2f GB/s\n", "scalar", scalar, "vector", vector, "default",
+                chosen);
+    if (vectorCuts != scalarCuts || cuts != scalarCuts) {
+        std::printf("MISMATCH: kernels cut differently\n");
+        return 1;
+    }
+    std::printf("%zu chunks, mean %.0f bytes\n", cuts.size(), double(data.size()) / double(cuts.size()));
+
+    // Versions: original, one byte inserted, then scattered small edits
+    std::vector<std::vector<uint8_t>> versions{data};
+    auto                              shifted = data;
+    shifted.insert(shifted.begin() + 4096, uint8_t(0x5a));
+    versions.push_back(shifted);
+    for (auto edit = 0; edit < 64; ++edit) {
+        auto at = shifted.begin() + std::ptrdiff_t(random() % (shifted.size() - 64));
+        if (edit % 2 == 0)
+            shifted.insert(at, 16, uint8_t(edit));
+        else
+            shifted.erase(at, at + 16);
+    }
+    versions.push_back(shifted);
+
+    std::unordered_set<std::string_view> seenFixed, seenCdc;
+    size_t                               logical = 0, uniqueFixed = 0, uniqueCdc = 0;
+    for (const auto &version : versions) {
+        logical += version.size();
+        uniqueFixed += store(version, fixed(version.size(), params.AvgSize), seenFixed);
+        uniqueCdc += store(version, boundaries(version, params, 0), seenCdc);
+    }
+    std::printf("dedupe ratio over %zu versions: fixed %.2f, content-defined %.2f\n", versions.size(),
+                double(logical) / double(uniqueFixed), double(logical) / double(uniqueCdc));
+    return 0;
+}
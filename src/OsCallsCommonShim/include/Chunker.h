@@ -0,0 +1,79 @@
+/**
+ * @file Chunker.h
+ * @brief Content-defined chunking (FastCDC style) of file content.
+ *
+ * Fixed-size chunks shift with every insertion or deletion, so one inserted
+ * byte changes the hash of every later chunk. Content-defined boundaries move
+ * with the data instead: a boundary is placed after byte p when a rolling
+ * gear hash of the bytes up to p matches a mask, so an edit only changes the
+ * chunks around it.
+ *
+ * The gear fingerprint at p is sum(gear[d[p - k]] << k, k = 0..63) modulo
+ * 2^64 (the iterated fp = (fp << 1) + gear[d[p]] over at least 64 bytes): it
+ * depends on the last 64 bytes only, never on where the chunk started. That
+ * lets the AVX2 kernel hash four stretches of the buffer in parallel and
+ * still cut exactly where the scalar loop does. As in FastCDC, the first
+ * MinSize bytes of a chunk are not hashed, a stricter mask applies below
+ * AvgSize and a looser one above it (normalized chunking, level 1), and a
+ * chunk is cut at MaxSize at the latest. The masks' bits are spread over
+ * bits 63..16 of the fingerprint, which depend on at least 17 bytes.
+ *
+ * Boundaries are a pure function of the content and the three sizes, so an
+ * archive must keep its chunking parameters to keep deduplicating against
+ * itself; the kernel in use does not matter.
+ */
+#ifndef CHUNKER_H
+#define CHUNKER_H
+
+#include "Platform.h"
+#include <cstdint>
+
+namespace OsCalls {
+/** @brief FindChunkBoundaries flag: @p data ends the content, the last chunk may be short. */
+#define CHUNKER_FINAL 0x1u
+/** @brief FindChunkBoundaries flag: use the scalar kernel even if a vector one is available. */
+#define CHUNKER_SCALAR 0x2u
+/** @brief FindChunkBoundaries flag: use the vector kernel where the CPU has it, even if it is slower. */
+#define CHUNKER_VECTOR 0x4u
+
+/**
+ * @brief Chunk size limits; 64 <= MinSize < AvgSize < MaxSize.
+ *
+ * A chunk is MinSize + 1 to MaxSize bytes long, except the last one of the
+ * content, which may be shorter.
+ */
+struct ChunkerParams {
+    int32_t MinSize;
+    int32_t AvgSize;
+    int32_t MaxSize;
+};
+}  // namespace OsCalls
+
+extern "C" {
+/**
+ * @brief Finds the chunk boundaries in @p data, which starts at a boundary.
+ *
+ * Without CHUNKER_FINAL the bytes after the last boundary reported are an
+ * incomplete chunk: pass them again, followed by more content, with the next
+ * call. With it, the last chunk ends at @p length.
+ *
+ * @param data Content.
+ * @param length Bytes in @p data.
+ * @param params Chunk size limits.
+ * @param flags CHUNKER_FINAL, CHUNKER_SCALAR, CHUNKER_VECTOR.
+ * @param cuts Receives the end offset (relative to @p data) of each chunk.
+ * @param capacity Entries available in @p cuts; the call stops when they are
+ *        used up, and the next call starts at the last one.
+ * @param count Receives the number of entries written.
+ * @return 0 on success, EINVAL for invalid parameters.
+ */
+DLL_EXPORT int32_t FindChunkBoundaries(const uint8_t *data, int64_t length, const OsCalls::ChunkerParams *params,
+                                       uint32_t flags, int64_t *cuts, int32_t capacity, int32_t *count);
+/**
+ * Which gear hash kernel FindChunkBoundaries uses: 1 AVX2, 0 scalar. AVX2 is
+ * used where the CPU has it and a timing on first use shows it faster.
+ */
+DLL_EXPORT int32_t GetChunkerKernel();
+}
+
+#endif  // CHUNKER_H
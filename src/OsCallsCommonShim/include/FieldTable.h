@@ -0,0 +1,147 @@
+/**
+ * @file FieldTable.h
+ * @brief Declarative field tables driving both result transports.
+ *
+ * A shim result record (struct stat, passwd, group, ...) is described once
+ * by a constexpr array of FieldDesc entries: cursor key, packed field id,
+ * kind and an accessor. handle_table() walks such a table to implement the
+ * ValueT cursor protocol, and encode_table() walks the same table to produce
+ * the packed encoding from Packed.h, so both transports always agree on
+ * field order, names and types.
+ */
+#ifndef FIELDTABLE_H
+#define FIELDTABLE_H
+
+#include "Packed.h"
+#include <cstddef>
+#include <type_traits>
+
+namespace OsCalls {
+/**
+ * @brief Value category of a table field.
+ */
+enum class FieldKind : uint8_t {
+    Number,      ///< int64 (cursor IsNumber, packed Varint)
+    String,      ///< NUL-terminated string (cursor IsString, packed Bytes)
+    TimeSpec,    ///< TimeSpec64 (cursor IsTimeSpec, packed TimeSpec)
+    Boolean,     ///< bool (cursor IsBoolean, packed Varint 0/1)
+    StringList,  ///< nullptr-terminated char* array (cursor nested "[]", packed repeated Bytes)
+};
+
+/**
+ * @brief Scratch slot an accessor fills; only the member matching the kind is read.
+ */
+struct FieldValue {
+    int64_t      number;
+    TimeSpec64   timespec;
+    const char  *string;
+    char *const *list;
+    bool         boolean;
+};
+
+/**
+ * @brief One field of a result record.
+ * @tparam Rec Record type the accessor reads from.
+ */
+template <typename Rec> struct FieldDesc {
+    using Record = Rec;
+
+    uint32_t    id;                           ///< Packed field id (stable, never reused)
+    const char *name;                         ///< Cursor key
+    FieldKind   kind;                         ///< Value category
+    void (*get)(const Rec &, FieldValue &);  ///< Accessor
+};
+
+/**
+ * @brief Cursor handler for nullptr-terminated string arrays.
+ *
+ * Yields each element as an IsString "[]" value. The strings are borrowed
+ * from the parent record, so this cursor has no payload of its own.
+ *
+ * @param value Cursor with Handle.data1 pointing at the char* array.
+ * @return true while elements remain.
+ */
+inline bool handle_string_list(ValueT *value) {
+    auto list = static_cast<char *const *>(value->Handle.data1);
+    if (list == nullptr || list[value->Handle.index] == nullptr)
+        return false;
+    set_val(String, "[]", list[value->Handle.index]);
+    return true;
+}
+
+/**
+ * @brief Generic cursor handler yielding the fields of @p Table in order.
+ *
+ * Handle.data1 must point at the table's record type. As with hand-written
+ * handlers, index 0 only yields when the cursor was marked IsOk.
+ *
+ * @tparam Table constexpr FieldDesc array.
+ * @param value Cursor to advance.
+ * @return true if a field was yielded.
+ */
+template <const auto &Table> bool handle_table(ValueT *value) {
+    using Desc = std::remove_cv_t<std::remove_reference_t<decltype(Table[0])>>;
+    using Rec = typename Desc::Record;
+    constexpr auto count = std::extent_v<std::remove_reference_t<decltype(Table)>>;
+
+    auto index = value->Handle.index;
+    if ((index == 0 && value->Type != TypeT::IsOk) || index >= int64_t(count))
+        return false;
+    const auto &field = Table[index];
+    FieldValue  fv{};
+    field.get(*static_cast<const Rec *>(value->Handle.data1), fv);
+    switch (field.kind) {
+    case FieldKind::Number:
+        set_val(Number, field.name, fv.number);
+        break;
+    case FieldKind::String:
+        set_val(String, field.name, fv.string);
+        break;
+    case FieldKind::TimeSpec:
+        set_val(TimeSpec, field.name, fv.timespec);
+        break;
+    case FieldKind::Boolean:
+        set_val(Boolean, field.name, fv.boolean);
+        break;
+    case FieldKind::StringList:
+        set_val(Complex, field.name, NewHandle(handle_string_list, nullptr, const_cast<char **>(fv.list), nullptr));
+        value->Complex->Type = TypeT::IsOk;
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief Append every field of @p Table for @p rec to a packed buffer.
+ *
+ * @tparam Table constexpr FieldDesc array.
+ * @param w Writer that already holds the schema id.
+ * @param rec Record to encode.
+ */
+template <const auto &Table, typename Rec> void encode_table(PackedWriter &w, const Rec &rec) {
+    for (const auto &field : Table) {
+        FieldValue fv{};
+        field.get(rec, fv);
+        switch (field.kind) {
+        case FieldKind::Number:
+            w.put_int(field.id, fv.number);
+            break;
+        case FieldKind::String:
+            w.put_string(field.id, fv.string);
+            break;
+        case FieldKind::TimeSpec:
+            w.put_timespec(field.id, fv.timespec);
+            break;
+        case FieldKind::Boolean:
+            w.put_int(field.id, fv.boolean ? 1 : 0);
+            break;
+        case FieldKind::StringList:
+            for (auto p = fv.list; p != nullptr && *p != nullptr; ++p)
+                w.put_string(field.id, *p);
+            break;
+        }
+    }
+}
+}  // namespace OsCalls
+
+#endif  // FIELDTABLE_H
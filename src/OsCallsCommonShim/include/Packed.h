@@ -0,0 +1,154 @@
+/**
+ * @file Packed.h
+ * @brief Compact, schema-tagged binary encoding for whole shim results.
+ *
+ * Alternative transport to the ValueT cursor: a native call serializes its
+ * complete result once into a single pooled buffer which managed code decodes
+ * from one span (OsCallsCommon.PackedReader), without a P/Invoke per field.
+ *
+ * Wire format (all integers are LEB128 varints):
+ * @code
+ *   buffer := schema field*
+ *   field  := tag payload            tag = field_id << 3 | wire_type
+ *   wire 0 (Varint)   : zigzag-encoded signed 64-bit value (booleans are 0/1)
+ *   wire 1 (Bytes)    : length, then that many raw bytes
+ *   wire 2 (TimeSpec) : zigzag tv_sec, then tv_nsec
+ * @endcode
+ * Repeated fields (lists) repeat the same tag. A field that is absent means
+ * "null"; decoders must skip unknown field ids so schemas can grow.
+ */
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "ValuePool.h"
+#include <cstring>
+
+namespace OsCalls {
+/**
+ * @brief Wire type stored in the low three bits of a field tag.
+ */
+enum class WireType : uint8_t {
+    Varint = 0,
+    Bytes = 1,
+    TimeSpec = 2,
+};
+
+/**
+ * @brief Growable encoder writing into a pooled buffer.
+ *
+ * The buffer comes from AllocBuffer and grows by doubling. After an
+ * allocation failure the writer stops writing and ok() reports false.
+ * Ownership of the finished buffer passes to the caller via release(); the
+ * receiver frees it with FreeBuffer.
+ */
+class PackedWriter {
+  public:
+    /**
+     * @brief Start a buffer for @p schema.
+     * @param schema Schema id written as the first varint.
+     * @param reserve Initial capacity in bytes.
+     */
+    explicit PackedWriter(uint32_t schema, size_t reserve = 256) {
+        buf_ = static_cast<uint8_t *>(AllocBuffer(reserve));
+        cap_ = buf_ != nullptr ? reserve : 0;
+        if (this->reserve(kMaxVarint))
+            put_varint(schema);
+    }
+
+    ~PackedWriter() { FreeBuffer(buf_); }
+
+    PackedWriter(const PackedWriter &) = delete;
+    PackedWriter &operator=(const PackedWriter &) = delete;
+
+    /** @brief Append a signed integer field. */
+    void put_int(uint32_t id, int64_t v) {
+        if (!reserve(2 * kMaxVarint))
+            return;
+        put_tag(id, WireType::Varint);
+        put_varint(zigzag(v));
+    }
+
+    /** @brief Append a length-prefixed byte field. */
+    void put_bytes(uint32_t id, const void *data, size_t len) {
+        if (!reserve(2 * kMaxVarint + len))
+            return;
+        put_tag(id, WireType::Bytes);
+        put_varint(len);
+        std::memcpy(buf_ + len_, data, len);
+        len_ += len;
+    }
+
+    /** @brief Append a NUL-terminated string as a byte field; nullptr is omitted. */
+    void put_string(uint32_t id, const char *s) {
+        if (s != nullptr)
+            put_bytes(id, s, std::strlen(s));
+    }
+
+    /** @brief Append a timespec field. */
+    void put_timespec(uint32_t id, TimeSpec64 ts) {
+        if (!reserve(3 * kMaxVarint))
+            return;
+        put_tag(id, WireType::TimeSpec);
+        put_varint(zigzag(ts.tv_sec));
+        put_varint(uint64_t(ts.tv_nsec));
+    }
+
+    /** @brief False once an allocation failed; the buffer is then incomplete. */
+    bool ok() const { return !failed_; }
+
+    /**
+     * @brief Hand the encoded buffer to the caller.
+     * @param length Receives the encoded length.
+     * @return Buffer to be freed with FreeBuffer.
+     */
+    uint8_t *release(int64_t *length) {
+        auto buf = buf_;
+        *length = int64_t(len_);
+        buf_ = nullptr;
+        cap_ = len_ = 0;
+        return buf;
+    }
+
+  private:
+    static constexpr size_t kMaxVarint = 10;
+
+    static uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+
+    // The put_* helpers below assume the caller already reserved room.
+    void put_tag(uint32_t id, WireType wire) { put_varint((uint64_t(id) << 3) | uint64_t(wire)); }
+
+    void put_varint(uint64_t v) {
+        while (v >= 0x80) {
+            buf_[len_++] = uint8_t(v) | 0x80;
+            v >>= 7;
+        }
+        buf_[len_++] = uint8_t(v);
+    }
+
+    bool reserve(size_t more) {
+        if (failed_)
+            return false;
+        if (len_ + more <= cap_)
+            return true;
+        auto cap = cap_ * 2 > len_ + more ? cap_ * 2 : len_ + more;
+        auto buf = static_cast<uint8_t *>(AllocBuffer(cap));
+        if (buf == nullptr) {
+            failed_ = true;
+            return false;
+        }
+        if (len_ > 0)
+            std::memcpy(buf, buf_, len_);
+        FreeBuffer(buf_);
+        buf_ = buf;
+        cap_ = cap;
+        return true;
+    }
+
+    uint8_t *buf_ = nullptr;
+    size_t   cap_ = 0;
+    size_t   len_ = 0;
+    bool     failed_ = false;
+};
+}  // namespace OsCalls
+
+#endif  // PACKED_H
@@ -6,7 +6,8 @@
  * The shim exposes a cursor-like interface. Managed code initializes a ValueT
  * instance via CreateHandle and then repeatedly calls GetNextValue to iterate
  * over a sequence of values forming either an array or an object (key/value
- * pairs).
+ * pairs). The caller owns the cursor and frees it with ReleaseHandle (see
+ * ValuePool.h).
  */
 #ifndef VALXFER_H
 #define VALXFER_H
@@ -46,6 +47,16 @@ struct TimeSpec64 {
  */
 typedef bool HandlerT(ValueT *value);
 
+/**
+ * @brief Function pointer type for cursor payload cleanup.
+ *
+ * Called once by ReleaseHandle to free whatever the cursor's data1/data2
+ * point to. It must not free the ValueT itself.
+ *
+ * @param value Cursor being released.
+ */
+typedef void ReleaseT(ValueT *value);
+
 // Define the THandle struct
 /**
  * @brief Iterator state passed between native calls for streaming values.
@@ -55,6 +66,7 @@ struct HandleT {
     void     *data1;
     void     *data2;
     int64_t   index;
+    ReleaseT *release;
 };
 
 // Define the TType enum
@@ -69,11 +81,15 @@ enum class TypeT {
     IsComplex,
     IsTimeSpec,
     IsBoolean,
+    IsBytes,
 };
 
 // Define the TValue struct
 /**
  * @brief Native representation of a value in the iteration stream.
+ *
+ * For TypeT::IsBytes, String points to Length raw bytes that are not
+ * NUL-terminated and may contain embedded NULs.
  */
 struct ValueT {
     HandleT     Handle;
@@ -84,6 +100,7 @@ struct ValueT {
     const char *String;
     ValueT     *Complex;
     bool        Boolean;
+    int64_t     Length;
 };
 
 /**
@@ -106,6 +123,23 @@ struct ValueT {
         value->typ = val;                                                                                              \
     } while (0)
 
+/**
+ * @brief Convenience macro for yielding a length-prefixed byte value.
+ *
+ * @param name C-string for the Name field.
+ * @param ptr Pointer to the first byte (stored in the String field).
+ * @param len Number of bytes at @p ptr.
+ *
+ * Example: set_bytes("value", buffer, buflen);
+ */
+#define set_bytes(name, ptr, len)                                                                                      \
+    do {                                                                                                               \
+        value->Type = TypeT::IsBytes;                                                                                  \
+        value->Name = name;                                                                                            \
+        value->String = ptr;                                                                                           \
+        value->Length = len;                                                                                           \
+    } while (0)
+
 /**
  * @name Cursor operations
  * Functions exported with C linkage for consumption via P/Invoke.
@@ -122,6 +156,21 @@ DLL_EXPORT void CreateHandle(OsCalls::ValueT *value, OsCalls::HandlerT *handler,
 
 namespace OsCalls {
 /** @} */
+
+/**
+ * @brief Cursor step shared by GetNextValue and shim-local copies of it.
+ *
+ * Other shims compile this into their own dispatch tables so that iterating
+ * a cursor does not have to cross into OsCallsCommonShim for every value.
+ *
+ * @param value Cursor to advance.
+ * @return true if a value was yielded.
+ */
+inline bool next_value(ValueT *value) {
+    auto ret = value->Handle.handler(value);
+    value->Handle.index++;
+    return ret;
+}
 }  // namespace OsCalls
 
 // Restore default packing
@@ -0,0 +1,80 @@
+/**
+ * @file ValuePool.h
+ * @brief Pooled allocation of ValueT cursors and their scratch buffers.
+ *
+ * Every native call that returns a cursor needs one ValueT plus (usually) a
+ * payload buffer. Allocating both with new/malloc for every file made the
+ * allocator the dominant cost of a metadata scan. This pool keeps per-thread
+ * free lists of ValueT records and of power-of-two sized scratch buffers, so
+ * that in steady state a cursor round trip does not touch the heap at all.
+ *
+ * Ownership rules:
+ * - A cursor returned to managed code is owned by the caller and must be
+ *   released exactly once with ReleaseHandle, whether or not it was iterated
+ *   to the end. Handlers never free the ValueT themselves.
+ * - ReleaseHandle first calls the cursor's ReleaseT (if any) to free the
+ *   payload, then recycles the ValueT.
+ * - A nested cursor handed out through ValueT::Complex is owned by the
+ *   consumer as well and released independently. It may borrow memory from
+ *   its parent, so it must be released before the parent.
+ */
+#ifndef VALUEPOOL_H
+#define VALUEPOOL_H
+
+#include "ValXfer.h"
+#include <cstddef>
+
+namespace OsCalls {
+/**
+ * @brief Snapshot of the pool counters, filled by GetPoolStats.
+ *
+ * LiveHandles and LiveBuffers count allocations not yet returned; they must
+ * stay flat across a run if every cursor is released. HeapAllocs counts
+ * requests that could not be served from a free list.
+ */
+struct PoolStats {
+    int64_t LiveHandles;
+    int64_t LiveBuffers;
+    int64_t HeapAllocs;
+};
+}  // namespace OsCalls
+
+extern "C" {
+/** Take a zeroed ValueT from the calling thread's pool. */
+DLL_EXPORT OsCalls::ValueT *AllocValue();
+/** Release a cursor: run its ReleaseT, then return the ValueT to the pool. Null is ignored. */
+DLL_EXPORT void ReleaseHandle(OsCalls::ValueT *value);
+/** Take a scratch buffer of at least @p size bytes from the pool. */
+DLL_EXPORT void *AllocBuffer(size_t size);
+/** Return a buffer obtained from AllocBuffer. Null is ignored. */
+DLL_EXPORT void FreeBuffer(void *buffer);
+/** Copy the current pool counters into @p stats. */
+DLL_EXPORT void GetPoolStats(OsCalls::PoolStats *stats);
+}
+
+namespace OsCalls {
+/**
+ * @brief Allocate and initialize a pooled cursor in one step.
+ *
+ * @param handler Function that yields the values.
+ * @param release Function that frees data1/data2 on ReleaseHandle, or nullptr.
+ * @param data1 First user data pointer.
+ * @param data2 Second user data pointer.
+ * @return Cursor in the error state with errno 0; callers set Type/Number.
+ */
+inline ValueT *NewHandle(HandlerT *handler, ReleaseT *release, void *data1, void *data2) {
+    auto v = AllocValue();
+    CreateHandle(v, handler, data1, data2);
+    v->Handle.release = release;
+    return v;
+}
+
+/**
+ * @brief ReleaseT for cursors whose data1 is a single AllocBuffer block.
+ */
+inline void ReleaseBuffer(ValueT *value) {
+    FreeBuffer(value->Handle.data1);
+}
+}  // namespace OsCalls
+
+#endif  // VALUEPOOL_H
@@ -0,0 +1,234 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "Chunker.h"
+#include <array>
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CHUNKER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace OsCalls {
+namespace {
+// splitmix64 from a fixed seed: the table is part of the chunk boundary
+// definition and must never change
+constexpr std::array<uint64_t, 256> make_gear() {
+    std::array<uint64_t, 256> gear{};
+    uint64_t                  state = 0x4465447542614344ull;
+    for (auto &g : gear) {
+        auto z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        g = z ^ (z >> 31);
+    }
+    return gear;
+}
+
+constexpr auto kGear = make_gear();
+
+// Fingerprint bits that must be zero for a boundary: @p bits of them, spread
+// over bits 63..16
+uint64_t make_mask(int bits) {
+    uint64_t mask = 0;
+    for (auto j = 0; j < bits; ++j)
+        mask |= uint64_t(1) << (63 - j * 48 / bits);
+    return mask;
+}
+
+int log2_round(int32_t value) {
+    auto bits = 0;
+    while ((int64_t(1) << (bits + 1)) <= value)
+        ++bits;
+    // Round to the nearer power of two
+    return (int64_t(3) << bits) / 2 < value ? bits + 1 : bits;
+}
+
+struct Masks {
+    uint64_t small;  // below AvgSize: harder to match
+    uint64_t large;  // from AvgSize on: easier to match
+};
+
+// First p in [lo, hi) whose fingerprint has no bit of @p mask set, or hi.
+// Needs 64 bytes before lo (lo >= 64).
+size_t scan_scalar(const uint8_t *d, size_t lo, size_t hi, uint64_t mask) {
+    uint64_t fp = 0;
+    for (auto p = lo - 64; p < lo; ++p)
+        fp = (fp << 1) + kGear[d[p]];
+    for (auto p = lo; p < hi; ++p) {
+        fp = (fp << 1) + kGear[d[p]];
+        if ((fp & mask) == 0)
+            return p;
+    }
+    return hi;
+}
+
+#ifdef CHUNKER_AVX2
+// Positions each of the four lanes hashes per round
+constexpr size_t kLane = 1024;
+
+// Four lanes hash four consecutive stretches of kLane positions, each warmed
+// up over the 64 bytes before its stretch, with one gather of the four gear
+// values per step. After each step all four fingerprints are tested, so every
+// position is checked; a lane keeps its first match only, and the round stops
+// once lane 0 has one. The first lane with a match has the earliest one. Only
+// the tail shorter than a round goes to the scalar loop.
+__attribute__((target("avx2"))) size_t scan_avx2(const uint8_t *d, size_t lo, size_t hi, uint64_t mask) {
+    const auto masks = _mm256_set1_epi64x(int64_t(mask));
+    const auto low = _mm256_set1_epi64x(0xff);
+    const auto zero = _mm256_setzero_si256();
+    const auto gear = reinterpret_cast<const long long *>(kGear.data());
+    auto       p = lo;
+    for (; hi - p >= 4 * kLane; p += 4 * kLane) {
+        auto   fp = zero;
+        size_t hit[4];
+        auto   found = 0;
+        // Eight bytes of each lane per load; offsets below 0 are the warm-up
+        for (auto t = -64; t < int(kLane) && (found & 1) == 0; t += 8) {
+            auto at = [&](size_t lane) {
+                uint64_t w;
+                std::memcpy(&w, d + p + lane * kLane + t, sizeof w);
+                return int64_t(w);
+            };
+            auto words = _mm256_set_epi64x(at(3), at(2), at(1), at(0));
+            for (auto k = 0; k < 8; ++k) {
+                auto index = _mm256_and_si256(_mm256_srli_epi64(words, 8 * k), low);
+                fp = _mm256_add_epi64(_mm256_slli_epi64(fp, 1), _mm256_i64gather_epi64(gear, index, 8));
+                if (t < 0)
+                    continue;
+                auto match = _mm256_movemask_pd(_mm256_castsi256_pd(
+                                 _mm256_cmpeq_epi64(_mm256_and_si256(fp, masks), zero))) &
+                             ~found;
+                for (; match != 0; match &= match - 1) {
+                    auto lane = __builtin_ctz(unsigned(match));
+                    hit[lane] = p + size_t(lane) * kLane + size_t(t + k);
+                    found |= 1 << lane;
+                }
+            }
+        }
+        for (auto lane = 0; lane < 4; ++lane)
+            if ((found & 1 << lane) != 0)
+                return hit[lane];
+    }
+    return scan_scalar(d, p, hi, mask);
+}
+
+// Nanoseconds the faster of three scans of @p d takes with @p kernel
+template <typename Kernel> int64_t time_scan(const std::vector<uint8_t> &d, Kernel kernel) {
+    auto best = INT64_MAX;
+    for (auto round = 0; round < 3; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        // An all-ones mask never matches, so the whole buffer is hashed
+        volatile auto end = kernel(d.data(), 64, d.size(), ~uint64_t(0));
+        (void)end;
+        auto took = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        best = std::min<int64_t>(best, took.count());
+    }
+    return best;
+}
+
+// Whether the AVX2 kernel is available and faster than the scalar one. Gathers
+// are slow on some CPUs (and under some microcode mitigations), so rather than
+// trusting the CPUID bit the first call times both kernels on 1 MiB.
+bool use_avx2() {
+    static const bool use = [] {
+        if (!__builtin_cpu_supports("avx2"))
+            return false;
+        std::vector<uint8_t> d(size_t(1) << 20);
+        uint64_t             state = 1;
+        for (auto &b : d)
+            b = uint8_t((state = state * 6364136223846793005ull + 1442695040888963407ull) >> 56);
+        return time_scan(d, scan_avx2) < time_scan(d, scan_scalar);
+    }();
+    return use;
+}
+#endif
+
+enum class Kernel { Default, Scalar, Vector };
+
+size_t scan(const uint8_t *d, size_t lo, size_t hi, uint64_t mask, Kernel kernel) {
+#ifdef CHUNKER_AVX2
+    if (kernel == Kernel::Vector ? __builtin_cpu_supports("avx2") : kernel == Kernel::Default && use_avx2())
+        return scan_avx2(d, lo, hi, mask);
+#else
+    (void)kernel;
+#endif
+    return scan_scalar(d, lo, hi, mask);
+}
+
+// End of the chunk starting at @p s in d[0, e); false if it may extend past e
+bool next_cut(const uint8_t *d, size_t s, size_t e, const ChunkerParams &params, const Masks &masks, bool final,
+              Kernel kernel, size_t *cut) {
+    auto minEnd = s + size_t(params.MinSize);
+    auto avgEnd = s + size_t(params.AvgSize);
+    auto maxEnd = s + size_t(params.MaxSize);
+    *cut = e;
+    if (e <= minEnd)
+        return final;
+    auto limit = avgEnd < e ? avgEnd : e;
+    auto p = scan(d, minEnd, limit, masks.small, kernel);
+    if (p < limit) {
+        *cut = p + 1;
+        return true;
+    }
+    limit = maxEnd < e ? maxEnd : e;
+    if (avgEnd < limit) {
+        p = scan(d, avgEnd, limit, masks.large, kernel);
+        if (p < limit) {
+            *cut = p + 1;
+            return true;
+        }
+    }
+    if (maxEnd <= e) {
+        *cut = maxEnd;
+        return true;
+    }
+    return final;
+}
+}  // namespace
+}  // namespace OsCalls
+
+extern "C" {
+/**
+ * @brief Content-defined chunk boundaries of a buffer; see Chunker.h.
+ */
+DLL_EXPORT int32_t FindChunkBoundaries(const uint8_t *data, int64_t length, const OsCalls::ChunkerParams *params,
+                                       uint32_t flags, int64_t *cuts, int32_t capacity, int32_t *count) {
+    using namespace OsCalls;
+    *count = 0;
+    if (length < 0 || capacity < 0 || params->MinSize < 64 || params->AvgSize <= params->MinSize ||
+        params->MaxSize <= params->AvgSize)
+        return EINVAL;
+    auto  bits = log2_round(params->AvgSize);
+    Masks masks{make_mask(bits + 1), make_mask(bits - 1)};
+    auto  final = (flags & CHUNKER_FINAL) != 0;
+    auto  kernel = (flags & CHUNKER_SCALAR) != 0   ? Kernel::Scalar
+                   : (flags & CHUNKER_VECTOR) != 0 ? Kernel::Vector
+                                                   : Kernel::Default;
+
+    size_t start = 0;
+    size_t cut;
+    while (start < size_t(length) && *count < capacity &&
+           next_cut(data, start, size_t(length), *params, masks, final, kernel, &cut)) {
+        cuts[(*count)++] = int64_t(cut);
+        start = cut;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reports the gear hash kernel in use; see Chunker.h.
+ */
+DLL_EXPORT int32_t GetChunkerKernel() {
+#ifdef CHUNKER_AVX2
+    return OsCalls::use_avx2() ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+}
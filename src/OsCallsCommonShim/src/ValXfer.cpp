@@ -9,15 +9,14 @@ extern "C" {
  *
  * Calls the handler function stored in the ValueT's Handle and increments
  * the index counter. The handler populates the ValueT fields with the next
- * value's metadata and data.
+ * value's metadata and data. The cursor stays valid after the handler
+ * signals the end; it is freed only by ReleaseHandle.
  *
  * @param value Pointer to ValueT structure with initialized Handle.
  * @return true if more values remain, false if iteration is complete.
  */
 DLL_EXPORT bool GetNextValue(OsCalls::ValueT *value) {
-    auto ret = value->Handle.handler(value);
-    value->Handle.index++;
-    return ret;
+    return OsCalls::next_value(value);
 };
 
 /**
@@ -36,10 +35,12 @@ DLL_EXPORT void CreateHandle(OsCalls::ValueT *value, OsCalls::HandlerT *handler,
     value->Handle.data1 = data1;
     value->Handle.data2 = data2;
     value->Handle.index = 0;
+    value->Handle.release = nullptr;
     value->Type = OsCalls::TypeT::IsError;
     value->Name = "errno";
     value->Number = 0;
     value->String = nullptr;
+    value->Length = 0;
     value->Complex = nullptr;
     value->TimeSpec = {0, 0};
 };
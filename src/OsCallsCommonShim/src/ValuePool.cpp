@@ -0,0 +1,192 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "ValuePool.h"
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+using OsCalls::ValueT;
+
+// Pooled buffer classes are powers of two from 64 B to 1 MiB; larger
+// requests bypass the free lists. The classes above 64 KiB hold large packed
+// results (long gr_mem lists, directory listings), which malloc would
+// otherwise map and unmap, page faults included, on every call.
+constexpr unsigned kMinShift = 6;
+constexpr unsigned kMaxShift = 20;
+constexpr unsigned kClassCount = kMaxShift - kMinShift + 1;
+constexpr unsigned kUnpooled = kClassCount;
+
+// Per-thread cache limits, so an idle thread never pins more than a few MiB.
+constexpr size_t kMaxCachedValues = 256;
+constexpr size_t kMaxCachedBytesPerClass = size_t(1) << 20;
+
+// Prefix in front of every buffer; 16 bytes keeps the payload suitably aligned.
+struct alignas(16) BufferHeader {
+    BufferHeader *next;
+    unsigned      cls;
+};
+
+std::atomic<int64_t> g_liveHandles{0};
+std::atomic<int64_t> g_liveBuffers{0};
+std::atomic<int64_t> g_heapAllocs{0};
+
+size_t class_size(unsigned cls) {
+    return size_t(1) << (cls + kMinShift);
+}
+
+unsigned class_for(size_t size) {
+    unsigned cls = 0;
+    while (cls < kClassCount && class_size(cls) < size)
+        ++cls;
+    return cls;
+}
+
+// Free lists owned by one thread. ValueT records are chained through
+// Handle.data1 while they sit in the cache.
+struct ThreadCache {
+    ValueT       *values = nullptr;
+    size_t        valueCount = 0;
+    BufferHeader *buffers[kClassCount] = {};
+    size_t        bufferCount[kClassCount] = {};
+
+    ~ThreadCache() {
+        while (values != nullptr) {
+            auto next = static_cast<ValueT *>(values->Handle.data1);
+            delete values;
+            values = next;
+        }
+        for (auto &head : buffers) {
+            while (head != nullptr) {
+                auto next = head->next;
+                std::free(head);
+                head = next;
+            }
+        }
+    }
+};
+
+thread_local ThreadCache t_cache;
+}  // namespace
+
+extern "C" {
+/**
+ * @brief Takes a zeroed ValueT from the calling thread's free list.
+ *
+ * Falls back to the heap when the list is empty. Every value returned here
+ * must eventually be passed to ReleaseHandle.
+ *
+ * @return Zero-initialized ValueT.
+ */
+DLL_EXPORT OsCalls::ValueT *AllocValue() {
+    auto   &cache = t_cache;
+    ValueT *v = cache.values;
+    if (v != nullptr) {
+        cache.values = static_cast<ValueT *>(v->Handle.data1);
+        --cache.valueCount;
+        *v = ValueT{};
+    } else {
+        v = new ValueT();
+        g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_liveHandles.fetch_add(1, std::memory_order_relaxed);
+    return v;
+}
+
+/**
+ * @brief Releases a cursor and everything it owns.
+ *
+ * Calls the cursor's ReleaseT (if set) to free the payload, then returns the
+ * ValueT to the calling thread's free list. Safe to call at any point of the
+ * iteration, including before the first GetNextValue.
+ *
+ * @param value Cursor to release; nullptr is ignored.
+ */
+DLL_EXPORT void ReleaseHandle(OsCalls::ValueT *value) {
+    if (value == nullptr)
+        return;
+    if (value->Handle.release != nullptr)
+        value->Handle.release(value);
+    g_liveHandles.fetch_sub(1, std::memory_order_relaxed);
+    auto &cache = t_cache;
+    if (cache.valueCount >= kMaxCachedValues) {
+        delete value;
+        return;
+    }
+    value->Handle.data1 = cache.values;
+    cache.values = value;
+    ++cache.valueCount;
+}
+
+/**
+ * @brief Takes a scratch buffer from the pool.
+ *
+ * Requests are rounded up to the next power-of-two class; requests above the
+ * largest class are served directly by malloc.
+ *
+ * @param size Minimum usable size in bytes.
+ * @return Buffer of at least @p size bytes, or nullptr if out of memory.
+ */
+DLL_EXPORT void *AllocBuffer(size_t size) {
+    auto          cls = class_for(size);
+    BufferHeader *hdr = nullptr;
+    if (cls == kUnpooled) {
+        hdr = static_cast<BufferHeader *>(std::malloc(sizeof(BufferHeader) + size));
+        g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        auto &cache = t_cache;
+        hdr = cache.buffers[cls];
+        if (hdr != nullptr) {
+            cache.buffers[cls] = hdr->next;
+            --cache.bufferCount[cls];
+        } else {
+            hdr = static_cast<BufferHeader *>(std::malloc(sizeof(BufferHeader) + class_size(cls)));
+            g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (hdr == nullptr)
+        return nullptr;
+    hdr->next = nullptr;
+    hdr->cls = cls;
+    g_liveBuffers.fetch_add(1, std::memory_order_relaxed);
+    return hdr + 1;
+}
+
+/**
+ * @brief Returns a buffer obtained from AllocBuffer to the pool.
+ *
+ * May be called from a different thread than the one that allocated it; the
+ * buffer then joins the releasing thread's free list.
+ *
+ * @param buffer Buffer to free; nullptr is ignored.
+ */
+DLL_EXPORT void FreeBuffer(void *buffer) {
+    if (buffer == nullptr)
+        return;
+    auto hdr = static_cast<BufferHeader *>(buffer) - 1;
+    g_liveBuffers.fetch_sub(1, std::memory_order_relaxed);
+    auto cls = hdr->cls;
+    if (cls == kUnpooled) {
+        std::free(hdr);
+        return;
+    }
+    auto &cache = t_cache;
+    if (cache.bufferCount[cls] * class_size(cls) >= kMaxCachedBytesPerClass) {
+        std::free(hdr);
+        return;
+    }
+    hdr->next = cache.buffers[cls];
+    cache.buffers[cls] = hdr;
+    ++cache.bufferCount[cls];
+}
+
+/**
+ * @brief Reads the pool counters.
+ *
+ * @param stats Receives live handle/buffer counts and heap allocation count.
+ */
+DLL_EXPORT void GetPoolStats(OsCalls::PoolStats *stats) {
+    stats->LiveHandles = g_liveHandles.load(std::memory_order_relaxed);
+    stats->LiveBuffers = g_liveBuffers.load(std::memory_order_relaxed);
+    stats->HeapAllocs = g_heapAllocs.load(std::memory_order_relaxed);
+}
+}  // extern "C"
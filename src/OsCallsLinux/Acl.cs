@@ -1,5 +1,5 @@
-using System.Runtime.CompilerServices;
-using System.Runtime.InteropServices;
+using System.Buffers.Binary;
+using System.Text;
 using System.Text.Json.Nodes;
 using OsCallsCommon;
 
@@ -9,29 +9,10 @@ namespace OsCallsLinux;
 ///     Wrapper for native ACL (Access Control List) reading functions.
 ///     Provides methods to read POSIX ACLs in short text format.
 /// </summary>
-public static unsafe partial class Acl
+public static unsafe class Acl
 {
-    private const string NativeLibraryName = "libOsCallsLinuxShim.so";
-
-    private static readonly ShimAclDelegate? _linux_acl_get_file_access;
-    private static readonly ShimAclDelegate? _linux_acl_get_file_default;
-
-    static Acl()
-    {
-        try
-        {
-            var full = FindNative();
-            if (!string.IsNullOrWhiteSpace(full))
-            {
-                var handle = NativeLibrary.Load(full);
-                if (NativeLibrary.TryGetExport(handle, "linux_acl_get_file_access", out var p))
-                    _linux_acl_get_file_access = Marshal.GetDelegateForFunctionPointer<ShimAclDelegate>(p);
-                if (NativeLibrary.TryGetExport(handle, "linux_acl_get_file_default", out p))
-                    _linux_acl_get_file_default = Marshal.GetDelegateForFunctionPointer<ShimAclDelegate>(p);
-            }
-        }
-        catch { }
-    }
+    // Minimal ACL text per permission bits (0..511), built on first use
+    private static readonly string?[] ModeTexts = new string?[512];
 
     /// <summary>
     ///     Reads the access ACL from the specified filesystem path.
@@ -49,13 +30,8 @@ public static unsafe partial class Acl
     /// </summary>
     public static JsonNode LinuxGetFileAccess(string path)
     {
-        if (_linux_acl_get_file_access is not null)
-        {
-            var ptr = _linux_acl_get_file_access(path);
-            return ValXfer.ToNode((ValXfer.ValueT*)ptr, path, "linux_acl_get_file_access");
-        }
-
-        return ValXfer.ToNode(acl_get_file_access(path), path, nameof(acl_get_file_access));
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ValXfer.ToNode(LinuxShim.Api.AclGetFileAccess(arg.Pointer), path, "linux_acl_get_file_access");
     }
 
     /// <summary>
@@ -74,35 +50,193 @@ public static unsafe partial class Acl
     /// </summary>
     public static JsonNode LinuxGetFileDefault(string path)
     {
-        if (_linux_acl_get_file_default is not null)
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ValXfer.ToNode(LinuxShim.Api.AclGetFileDefault(arg.Pointer), path, "linux_acl_get_file_default");
+    }
+
+    /// <summary>
+    ///     Reads the access ACL in short text form without raising errors: ENOTSUP (filesystem without ACL
+    ///     support), ENOENT and the like are returned as errno, nothing is allocated, logged or thrown for them.
+    /// </summary>
+    /// <param name="path">Filesystem path to read ACL from.</param>
+    /// <param name="text">Receives the ACL text on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetFileAccess(string path, out string? text)
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.AclGetFileAccessPacked(arg.Pointer, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeAclText, out text);
+    }
+
+    /// <summary>
+    ///     Reads the default ACL of a directory in short text form without raising errors; see
+    ///     <see cref="TryGetFileAccess" />. An empty text means the directory has no default ACL.
+    /// </summary>
+    /// <param name="path">Filesystem path (must be a directory).</param>
+    /// <param name="text">Receives the ACL text on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetFileDefault(string path, out string? text)
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.AclGetFileDefaultPacked(arg.Pointer, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeAclText, out text);
+    }
+
+    /// <summary>
+    ///     <see cref="TryGetFileAccess" /> for an entry addressed relative to a directory handle.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="FileSystem.TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />; symlinks are followed.</param>
+    /// <param name="text">Receives the ACL text on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetFileAccessAt(FileSystemHandle directory, string name, out string? text)
+    {
+        byte* data = null;
+        long length = 0;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.AclGetAccessAtPacked(dir.Value, arg.Pointer, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeAclText, out text);
+    }
+
+    /// <summary>
+    ///     <see cref="TryGetFileDefault" /> for an entry addressed relative to a directory handle.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="FileSystem.TryOpenDirectory" />.</param>
+    /// <param name="name">Directory name within <paramref name="directory" />.</param>
+    /// <param name="text">Receives the ACL text on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetFileDefaultAt(FileSystemHandle directory, string name, out string? text)
+    {
+        byte* data = null;
+        long length = 0;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.AclGetDefaultAtPacked(dir.Value, arg.Pointer, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeAclText, out text);
+    }
+
+    /// <summary>
+    ///     The access ACL of an entry without extended ACL entries, as libacl synthesizes it from the mode bits
+    ///     (e.g. "u::rw-,g::r--,o::r--" for 0644), in the same short text form.
+    /// </summary>
+    /// <param name="mode">st_mode of the entry; only the permission bits are used.</param>
+    /// <returns>The ACL short text.</returns>
+    public static string MinimalText(long mode)
+    {
+        var bits = (int)(mode & 0x1FF);
+        return ModeTexts[bits] ??= $"u::{Perms(bits >> 6)},g::{Perms(bits >> 3)},o::{Perms(bits)}";
+
+        static string Perms(int rwx) =>
+            new([(rwx & 4) != 0 ? 'r' : '-', (rwx & 2) != 0 ? 'w' : '-', (rwx & 1) != 0 ? 'x' : '-']);
+    }
+
+    /// <summary>
+    ///     Parses a raw <c>system.posix_acl_access</c> / <c>_default</c> value (posix_acl_xattr_header version 2
+    ///     followed by 8-byte entries, little endian), as <see cref="FileSystem.CollectParts.AclRaw" /> returns it.
+    /// </summary>
+    /// <param name="raw">The xattr value.</param>
+    /// <returns>The entries in stored order.</returns>
+    /// <exception cref="InvalidDataException">Unknown version or truncated value.</exception>
+    public static AclEntry[] ParseRaw(ReadOnlySpan<byte> raw)
+    {
+        if (raw.Length < 4 || (raw.Length - 4) % 8 != 0 || BinaryPrimitives.ReadUInt32LittleEndian(raw) != 2)
+            throw new InvalidDataException($"Not a version 2 POSIX ACL xattr ({raw.Length} bytes)");
+        var entries = new AclEntry[(raw.Length - 4) / 8];
+        for (var i = 0; i < entries.Length; i++)
         {
-            var ptr = _linux_acl_get_file_default(path);
-            return ValXfer.ToNode((ValXfer.ValueT*)ptr, path, "linux_acl_get_file_default");
+            var entry = raw.Slice(4 + i * 8, 8);
+            entries[i] = new AclEntry(
+                (AclTag)BinaryPrimitives.ReadUInt16LittleEndian(entry),
+                BinaryPrimitives.ReadUInt16LittleEndian(entry[2..]),
+                BinaryPrimitives.ReadUInt32LittleEndian(entry[4..])
+            );
         }
 
-        return ValXfer.ToNode(acl_get_file_default(path), path, nameof(acl_get_file_default));
+        return entries;
     }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValXfer.ValueT* acl_get_file_access(string path);
-
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValXfer.ValueT* acl_get_file_default(string path);
+    /// <summary>
+    ///     Renders a raw ACL value like <see cref="FormatText" />, with the numeric uid / gid as qualifier of named
+    ///     entries (libacl's TEXT_NUMERIC_IDS, e.g. "u::rw-,u:1000:rwx,g::r--,m::rwx,o::r--"). Makes no NSS lookup.
+    /// </summary>
+    /// <param name="raw">The xattr value, see <see cref="ParseRaw" />.</param>
+    /// <returns>The ACL short text.</returns>
+    public static string FormatNumericText(ReadOnlySpan<byte> raw)
+    {
+        return FormatText(raw, _ => null, _ => null);
+    }
 
-    private static string? FindNative()
+    /// <summary>
+    ///     Renders a raw ACL value in the short text form libacl produces (<c>acl_to_any_text</c> with
+    ///     TEXT_ABBREVIATE, e.g. "u::rw-,u:daemon:rwx,g::r--,m::rwx,o::r--"). Qualifiers are named through
+    ///     <paramref name="userName" /> / <paramref name="groupName" />, falling back to the numeric id like
+    ///     libacl; the caller decides how (and how often) those consult NSS.
+    /// </summary>
+    /// <param name="raw">The xattr value, see <see cref="ParseRaw" />.</param>
+    /// <param name="userName">Name of a uid, or null if unknown.</param>
+    /// <param name="groupName">Name of a gid, or null if unknown.</param>
+    /// <returns>The ACL short text.</returns>
+    public static string FormatText(ReadOnlySpan<byte> raw, Func<long, string?> userName, Func<long, string?> groupName)
     {
-        var baseDir = AppContext.BaseDirectory;
-        var candidateDebug = Path.Combine(baseDir, "OsCallsLinuxShim", "bin", "Debug", "net8.0", NativeLibraryName);
-        var candidateRelease = Path.Combine(baseDir, "OsCallsLinuxShim", "bin", "Release", "net8.0", NativeLibraryName);
-        if (File.Exists(candidateDebug))
-            return candidateDebug;
-        if (File.Exists(candidateRelease))
-            return candidateRelease;
-        return null;
+        var text = new StringBuilder();
+        foreach (var entry in ParseRaw(raw))
+        {
+            if (text.Length > 0)
+                text.Append(',');
+            text.Append(
+                entry.Tag switch
+                {
+                    AclTag.UserObj => "u::",
+                    AclTag.User => $"u:{userName(entry.Id) ?? entry.Id.ToString()}:",
+                    AclTag.GroupObj => "g::",
+                    AclTag.Group => $"g:{groupName(entry.Id) ?? entry.Id.ToString()}:",
+                    AclTag.Mask => "m::",
+                    AclTag.Other => "o::",
+                    _ => throw new InvalidDataException($"Unknown ACL entry tag {(ushort)entry.Tag:x}"),
+                }
+            );
+            text.Append((entry.Perm & 4) != 0 ? 'r' : '-');
+            text.Append((entry.Perm & 2) != 0 ? 'w' : '-');
+            text.Append((entry.Perm & 1) != 0 ? 'x' : '-');
+        }
+
+        return text.ToString();
     }
+}
+
+/// <summary>
+///     Tag of a POSIX ACL entry (ACL_USER_OBJ and so on, linux/posix_acl.h).
+/// </summary>
+public enum AclTag : ushort
+{
+    /// <summary>The owning user (u::).</summary>
+    UserObj = 0x01,
+
+    /// <summary>A named user (u:id:).</summary>
+    User = 0x02,
+
+    /// <summary>The owning group (g::).</summary>
+    GroupObj = 0x04,
+
+    /// <summary>A named group (g:id:).</summary>
+    Group = 0x08,
 
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    private delegate IntPtr ShimAclDelegate([MarshalAs(UnmanagedType.LPUTF8Str)] string path);
+    /// <summary>The mask of named entries and the owning group (m::).</summary>
+    Mask = 0x10,
+
+    /// <summary>Everyone else (o::).</summary>
+    Other = 0x20,
 }
+
+/// <summary>
+///     One entry of a raw POSIX ACL, see <see cref="Acl.ParseRaw" />.
+/// </summary>
+/// <param name="Tag">Entry type.</param>
+/// <param name="Perm">Permission bits: 4 read, 2 write, 1 execute.</param>
+/// <param name="Id">uid or gid of a <see cref="AclTag.User" /> / <see cref="AclTag.Group" /> entry.</param>
+public readonly record struct AclEntry(AclTag Tag, int Perm, long Id);
@@ -0,0 +1,176 @@
+using System.ComponentModel;
+using ArchiveDataHandler;
+using Microsoft.Win32.SafeHandles;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     Read stream over a file opened with <see cref="FileSystem.TryOpenContent" />: reads go through
+///     <see cref="FileSystem.TryReadContent" />, so by default the pages a backup pulls into the page cache are
+///     dropped again behind it, while pages other processes had cached stay. Seeking back (to read a chunk a
+///     second time) keeps what earlier reads brought in marked as the reader's own. Owns and closes the handle.
+///     <see cref="OpenRange" /> gives further readers of the same file, e.g. one per chunk of a large file, and
+///     <see cref="TryFindData" /> tells where a sparse file has data.
+/// </summary>
+public sealed class ContentStream : Stream, IRangeReadable, ISparseReadable
+{
+    private const int ENXIO = 6;
+
+    private readonly bool _dropBehind;
+    private readonly long _end = long.MaxValue;
+    private readonly SafeFileHandle _file;
+    private readonly bool _ownsFile = true;
+    private long _owned;
+    private long _position;
+
+    /// <summary>
+    ///     Initializes a new instance of the <see cref="ContentStream" /> class.
+    /// </summary>
+    /// <param name="file">Readable file handle; disposed with the stream.</param>
+    /// <param name="dropBehind">Drop the pages read from the page cache unless they were cached before.</param>
+    public ContentStream(SafeFileHandle file, bool dropBehind = true)
+    {
+        _file = file;
+        _dropBehind = dropBehind;
+    }
+
+    // A range of the file, reading through a handle owned by another stream
+    private ContentStream(SafeFileHandle file, bool dropBehind, long offset, long length)
+        : this(file, dropBehind)
+    {
+        _position = offset;
+        _end = offset + length;
+        _ownsFile = false;
+    }
+
+    /// <inheritdoc />
+    public override bool CanRead => !_file.IsClosed;
+
+    /// <inheritdoc />
+    public override bool CanSeek => !_file.IsClosed;
+
+    /// <inheritdoc />
+    public override bool CanWrite => false;
+
+    /// <inheritdoc />
+    /// <summary>Gets the file length, or the end of the range for a stream from <see cref="OpenRange" />.</summary>
+    public override long Length => Math.Min(RandomAccess.GetLength(_file), _end);
+
+    /// <summary>Gets or sets the file offset of the next read (also for a stream from <see cref="OpenRange" />).</summary>
+    public override long Position
+    {
+        get => _position;
+        set
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(value);
+            _position = value;
+        }
+    }
+
+    /// <summary>
+    ///     Opens <paramref name="name" /> in <paramref name="directory" /> (or <paramref name="name" /> as a path
+    ///     without one) with <see cref="FileSystem.TryOpenContent" />.
+    /// </summary>
+    /// <param name="directory">Directory handle, or null to open <paramref name="name" /> as a path.</param>
+    /// <param name="name">Entry name or path.</param>
+    /// <returns>The stream.</returns>
+    /// <exception cref="Win32Exception">The file cannot be opened.</exception>
+    public static ContentStream Open(FileSystemHandle? directory, string name)
+    {
+        var rc = directory is null
+            ? FileSystem.TryOpenContent(name, out var file)
+            : FileSystem.TryOpenContentAt(directory, name, out file);
+        if (rc != 0)
+            throw new Win32Exception(rc);
+        return new ContentStream(file!);
+    }
+
+    /// <summary>
+    ///     Opens a stream over a range of the same file. It reads the file independently of this stream, dropping
+    ///     the pages it brings in (if this stream does) with its own bookkeeping, and does not close the handle,
+    ///     which must stay open as long as the range is read.
+    /// </summary>
+    /// <param name="offset">File offset the range starts at.</param>
+    /// <param name="length">Length of the range.</param>
+    /// <returns>The range stream.</returns>
+    public Stream OpenRange(long offset, long length)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(offset);
+        ArgumentOutOfRangeException.ThrowIfNegative(length);
+        return new ContentStream(_file, _dropBehind, offset, length);
+    }
+
+    /// <inheritdoc />
+    public bool TryFindData(long offset, out long start, out long end)
+    {
+        var rc = FileSystem.TryFindData(_file, offset, out start, out end);
+        if (rc == ENXIO)
+            return false;
+        if (rc != 0)
+        {
+            // Holes unknown: all data
+            start = offset;
+            end = long.MaxValue;
+        }
+
+        end = Math.Min(end, _end);
+        return start < _end;
+    }
+
+    /// <inheritdoc />
+    public override int Read(Span<byte> buffer)
+    {
+        if (_position >= _end)
+            return 0;
+        if (buffer.Length > _end - _position)
+            buffer = buffer[..(int)(_end - _position)];
+        var rc = FileSystem.TryReadContent(_file, buffer, _position, _dropBehind, ref _owned, out var count);
+        if (rc != 0)
+            throw new IOException($"read failed: {new Win32Exception(rc).Message}", new Win32Exception(rc));
+        _position += count;
+        return count;
+    }
+
+    /// <inheritdoc />
+    public override int Read(byte[] buffer, int offset, int count)
+    {
+        ValidateBufferArguments(buffer, offset, count);
+        return Read(buffer.AsSpan(offset, count));
+    }
+
+    /// <inheritdoc />
+    public override void Flush() { }
+
+    /// <inheritdoc />
+    public override long Seek(long offset, SeekOrigin origin)
+    {
+        Position = origin switch
+        {
+            SeekOrigin.Begin => offset,
+            SeekOrigin.Current => _position + offset,
+            SeekOrigin.End => Length + offset,
+            _ => throw new ArgumentOutOfRangeException(nameof(origin)),
+        };
+        return _position;
+    }
+
+    /// <inheritdoc />
+    public override void SetLength(long value)
+    {
+        throw new NotSupportedException();
+    }
+
+    /// <inheritdoc />
+    public override void Write(byte[] buffer, int offset, int count)
+    {
+        throw new NotSupportedException();
+    }
+
+    /// <inheritdoc />
+    protected override void Dispose(bool disposing)
+    {
+        if (disposing && _ownsFile)
+            _file.Dispose();
+        base.Dispose(disposing);
+    }
+}
@@ -0,0 +1,110 @@
+using System.Runtime.InteropServices;
+using static OsCallsCommon.ValXfer;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     Native parallel directory prefetcher (<c>linux_walk_open</c>, see Walker.h). Worker threads list the trees
+///     below the roots ahead of a sequential traversal; <see cref="TryTake" /> hands over the listing of each
+///     directory the traversal reaches, in the traversal's own order. Closed through <c>linux_walk_close</c>, which
+///     stops the threads.
+/// </summary>
+public sealed class DirectoryWalker : SafeHandle
+{
+    /// <summary>Creates an invalid handle.</summary>
+    public DirectoryWalker()
+        : base(0, true) { }
+
+    private DirectoryWalker(long handle)
+        : base(0, true)
+    {
+        SetHandle((nint)handle);
+    }
+
+    /// <inheritdoc />
+    public override bool IsInvalid => handle == 0;
+
+    /// <summary>
+    ///     Starts prefetching the directory trees below <paramref name="roots" />.
+    /// </summary>
+    /// <param name="roots">Directories to scan; other entries are ignored. Only their devices are scanned.</param>
+    /// <param name="excluded">Paths whose subtrees are not scanned (e.g. the archive).</param>
+    /// <param name="threads">Worker threads; 0 uses one per online CPU.</param>
+    /// <param name="maxBuffered">Byte budget of listings not taken yet; 0 uses the native default.</param>
+    /// <param name="walker">Receives the walker on success, null otherwise. Dispose it when done.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static unsafe int TryOpen(
+        IReadOnlyList<string> roots,
+        IReadOnlyList<string> excluded,
+        int threads,
+        long maxBuffered,
+        out DirectoryWalker? walker
+    )
+    {
+        var strings = new nint[roots.Count + excluded.Count];
+        try
+        {
+            for (var i = 0; i < roots.Count; i++)
+                strings[i] = Marshal.StringToCoTaskMemUTF8(roots[i]);
+            for (var i = 0; i < excluded.Count; i++)
+                strings[roots.Count + i] = Marshal.StringToCoTaskMemUTF8(excluded[i]);
+
+            long handle = 0;
+            int rc;
+            fixed (nint* p = strings)
+            {
+                rc = LinuxShim.Api.WalkOpen(
+                    (byte**)p,
+                    roots.Count,
+                    (byte**)(p + roots.Count),
+                    excluded.Count,
+                    threads,
+                    maxBuffered,
+                    &handle
+                );
+            }
+
+            walker = rc == 0 ? new DirectoryWalker(handle) : null;
+            return rc;
+        }
+        finally
+        {
+            foreach (var s in strings)
+                Marshal.FreeCoTaskMem(s);
+        }
+    }
+
+    /// <summary>
+    ///     Takes the listing of one directory, as <see cref="FileSystem.TryReadDirectory" /> with stat would return
+    ///     it: prefetched if a worker got there first, otherwise read now.
+    /// </summary>
+    /// <param name="path">Directory path, read directly if it was not prefetched.</param>
+    /// <param name="dev">Device of the directory (st_dev).</param>
+    /// <param name="ino">Inode of the directory (st_ino).</param>
+    /// <param name="entries">Receives the entries in inode order, null on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value of reading <paramref name="path" />.</returns>
+    public unsafe int TryTake(string path, long dev, long ino, out List<DirectoryEntry>? entries)
+    {
+        var added = false;
+        try
+        {
+            DangerousAddRef(ref added);
+            byte* data = null;
+            long length = 0;
+            using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+            var rc = LinuxShim.Api.WalkTake(handle, arg.Pointer, dev, ino, &data, &length);
+            return TryDecodePacked(rc, data, length, PackedDecoders.DecodeDirectory, out entries);
+        }
+        finally
+        {
+            if (added)
+                DangerousRelease();
+        }
+    }
+
+    /// <inheritdoc />
+    protected override unsafe bool ReleaseHandle()
+    {
+        return LinuxShim.Api.WalkClose(handle) == 0;
+    }
+}
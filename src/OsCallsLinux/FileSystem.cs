@@ -1,7 +1,6 @@
-using System.Reflection;
-using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Text.Json.Nodes;
+using Microsoft.Win32.SafeHandles;
 using OsCallsCommon;
 using UtilitiesLibrary;
 using static OsCallsCommon.ValXfer;
@@ -9,261 +8,739 @@ using static OsCallsCommon.ValXfer;
 namespace OsCallsLinux;
 
 /// <summary>
-///     Thin P/Invoke wrapper around native POSIX filesystem calls exposed by libOsCallsLinuxShim.so.
+///     Thin wrapper around native POSIX filesystem calls exposed by libOsCallsLinuxShim.so, called through the
+///     <see cref="LinuxShim" /> dispatch table.
 ///     Converts native iterator-style ValueT streams into JSON nodes via <see cref="ValXfer.ToNode" />.
 /// </summary>
-public static unsafe partial class FileSystem
+public static unsafe class FileSystem
 {
-    private const string NativeLibraryName = "libOsCallsLinuxShim.so";
+    // READ_DIRECTORY_STAT in FileSystem.h.
+    private const uint ReadDirectoryStat = 1;
 
-    private static readonly ShimFnDelegate? _linux_lstat_fn;
-    private static readonly ShimFnDelegate? _linux_readlink_fn;
-    private static readonly ShimFnDelegate? _linux_cfn_fn;
+    // AT_FDCWD (fcntl.h): resolve a path relative to the working directory.
+    private const long AtFdCwd = -100;
 
-    static FileSystem()
+    // CONTENT_DROP_BEHIND (ContentReader.h)
+    private const uint ContentDropBehind = 0x1;
+
+    /// <summary>
+    ///     Instance logger for this module. Replaceable for tests; defaults to adapter.
+    /// </summary>
+    public static ILogging? Logger { get; set; }
+
+    /// <summary>
+    ///     Gets file status for the supplied path (like POSIX lstat), without following symlinks.
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <returns>A JsonObject containing stat fields (st_dev, st_ino, st_mode, ...).</returns>
+    public static JsonNode LStat(string path)
     {
-        try
-        {
-            NativeLibrary.SetDllImportResolver(typeof(FileSystem).Assembly, Resolver);
-            if (Logger!.IsNativeDebugEnabled())
-                Logger!.ConWrite($"OsCallsLinux.FileSystem resolver registered: searching for '{NativeLibraryName}'");
-            // Proactively load native library so first P/Invoke succeeds even if environment vars were set too late.
-            _ = Resolver(NativeLibraryName, typeof(FileSystem).Assembly, null);
-            // Best-effort: try to bind linux_* exports if present and create delegates.
-            try
-            {
-                var full = FindNativeLibraryPath(NativeLibraryName);
-                if (!string.IsNullOrWhiteSpace(full))
-                {
-                    var handle = NativeLibrary.Load(full);
-                    if (NativeLibrary.TryGetExport(handle, "linux_lstat", out var ptr))
-                        _linux_lstat_fn = Marshal.GetDelegateForFunctionPointer<ShimFnDelegate>(ptr);
-                    if (NativeLibrary.TryGetExport(handle, "linux_readlink", out ptr))
-                        _linux_readlink_fn = Marshal.GetDelegateForFunctionPointer<ShimFnDelegate>(ptr);
-                    if (NativeLibrary.TryGetExport(handle, "linux_canonicalize_file_name", out ptr))
-                        _linux_cfn_fn = Marshal.GetDelegateForFunctionPointer<ShimFnDelegate>(ptr);
-                }
-            }
-            catch
-            {
-                // ignore — fallback to P/Invoke will be used
-            }
-        }
-        catch
+        return LinuxLStat(path);
+    }
+
+    /// <summary>
+    ///     Platform-prefixed wrapper for calling the LStat functionality: preferred naming for OS-specific wrappers.
+    ///     This mirrors <see cref="LStat(string)" /> and is intended for direct use by OS-prefixed API code.
+    /// </summary>
+    public static JsonNode LinuxLStat(string path)
+    {
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ToNode(LinuxShim.Api.LStat(arg.Pointer), path, "linux_lstat");
+    }
+
+    /// <summary>
+    ///     Flat lstat: fills a blittable <see cref="StatRecord" /> in a single native call, without building a
+    ///     ValueT cursor or JSON. Preferred over <see cref="LinuxLStat" /> on hot paths.
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <param name="record">Receives the stat fields on success; zeroed on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int LinuxLStatInto(string path, out StatRecord record)
+    {
+        record = default;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        fixed (StatRecord* p = &record)
         {
-            // Swallow; detailed errors surfaced when actual P/Invoke attempted.
+            return LinuxShim.Api.LStatInto(arg.Pointer, p);
         }
     }
 
     /// <summary>
-    ///     Instance logger for this module. Replaceable for tests; defaults to adapter.
+    ///     Non-throwing lstat for callers that expect failures such as ENOENT (entries vanishing during a
+    ///     walk). Same as <see cref="LinuxLStatInto" />, named like the other Try* calls.
     /// </summary>
-    public static ILogging? Logger { get; set; }
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <param name="record">Receives the stat fields on success; zeroed on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryLStat(string path, out StatRecord record)
+    {
+        return LinuxLStatInto(path, out record);
+    }
+
+    /// <summary>
+    ///     lstat through the packed transport: the native side encodes the whole result into one buffer which is
+    ///     decoded here from a single span (see <see cref="PackedDecoders.DecodeStat" />).
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <returns>The decoded stat fields.</returns>
+    /// <exception cref="Exception">If lstat fails (InnerException is the Win32Exception).</exception>
+    public static StatRecord LinuxLStatPacked(string path)
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.LStatPacked(arg.Pointer, &data, &length);
+        return DecodePacked(rc, data, length, path, "linux_lstat_packed", PackedDecoders.DecodeStat);
+    }
+
+    /// <summary>
+    ///     Reads the target of a symbolic link.
+    /// </summary>
+    /// <param name="path">Path of the symlink to read.</param>
+    /// <returns>A JsonNode with a <c>path</c> field set to the symlink target string.</returns>
+    public static JsonNode ReadLink(string path)
+    {
+        return LinuxReadLink(path);
+    }
+
+    /// <summary>
+    ///     Platform-prefixed wrapper for ReadLink.
+    /// </summary>
+    public static JsonNode LinuxReadLink(string path)
+    {
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ToNode(LinuxShim.Api.ReadLink(arg.Pointer), path, "linux_readlink");
+    }
+
+    /// <summary>
+    ///     Resolves a path to its canonical absolute form (resolving symlinks and relative segments).
+    /// </summary>
+    /// <param name="path">Original input path.</param>
+    /// <returns>A JsonNode with a <c>path</c> field set to the canonical path.</returns>
+    public static JsonNode Canonicalizefilename(string path)
+    {
+        return LinuxCanonicalizeFileName(path);
+    }
+
+    /// <summary>
+    ///     Platform-prefixed wrapper for canonicalize_file_name.
+    /// </summary>
+    public static JsonNode LinuxCanonicalizeFileName(string path)
+    {
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ToNode(LinuxShim.Api.CanonicalizeFileName(arg.Pointer), path, "linux_canonicalize_file_name");
+    }
 
-    private static nint Resolver(string libraryName, Assembly assembly, DllImportSearchPath? searchPath)
+    /// <summary>
+    ///     Opens a handle on a directory so that its entries can be addressed by name (the *At calls below):
+    ///     the kernel then resolves only the last component instead of re-walking the full path per syscall.
+    /// </summary>
+    /// <param name="path">Directory to open.</param>
+    /// <param name="directory">Receives the handle on success, null otherwise. Dispose it when done.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryOpenDirectory(string path, out FileSystemHandle? directory)
+    {
+        long handle = -1;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.OpenDirHandle(arg.Pointer, &handle);
+        directory = rc == 0 ? new FileSystemHandle(handle) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     Opens an O_PATH handle on a directory entry without following symlinks, for the handle-based xattr
+    ///     calls (<see cref="Xattr.TryListXattr(FileSystemHandle, out string[])" />).
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />.</param>
+    /// <param name="entry">Receives the handle on success, null otherwise. Dispose it when done.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryOpenAt(FileSystemHandle directory, string name, out FileSystemHandle? entry)
+    {
+        long handle = -1;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.OpenAtHandle(dir.Value, arg.Pointer, &handle);
+        entry = rc == 0 ? new FileSystemHandle(handle) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     Opens a directory entry for reading without following symlinks (openat with O_NOFOLLOW).
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />.</param>
+    /// <param name="file">Receives an owning file handle on success (usable with FileStream), null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryOpenReadAt(FileSystemHandle directory, string name, out SafeFileHandle? file)
     {
-        if (libraryName != NativeLibraryName)
-            return IntPtr.Zero;
+        var fd = -1;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.OpenAtRead(dir.Value, arg.Pointer, &fd);
+        file = rc == 0 ? new SafeFileHandle(fd, true) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     Opens a file for reading its content without updating its atime where the kernel allows that
+    ///     (O_NOATIME: owner or CAP_FOWNER; otherwise opened normally), advising sequential access. Does not follow
+    ///     a final symlink. Read it with <see cref="TryReadContent" /> or through <see cref="ContentStream" />.
+    /// </summary>
+    /// <param name="path">Filesystem path.</param>
+    /// <param name="file">Receives an owning file handle on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryOpenContent(string path, out SafeFileHandle? file)
+    {
+        var fd = -1;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.OpenContent(AtFdCwd, arg.Pointer, &fd);
+        file = rc == 0 ? new SafeFileHandle(fd, true) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     <see cref="TryOpenContent" /> of an entry addressed relative to a directory handle.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />.</param>
+    /// <param name="file">Receives an owning file handle on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryOpenContentAt(FileSystemHandle directory, string name, out SafeFileHandle? file)
+    {
+        var fd = -1;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.OpenContent(dir.Value, arg.Pointer, &fd);
+        file = rc == 0 ? new SafeFileHandle(fd, true) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     Reads file content at an offset until <paramref name="buffer" /> is full or the file ends.
+    /// </summary>
+    /// <param name="file">File handle, usually from <see cref="TryOpenContent" />.</param>
+    /// <param name="buffer">Destination.</param>
+    /// <param name="offset">File offset.</param>
+    /// <param name="dropBehind">
+    ///     Drop the pages this reader brought into the page cache again; pages that were cached before stay.
+    /// </param>
+    /// <param name="owned">
+    ///     With <paramref name="dropBehind" />: where this reader's own readahead ends. Start at 0 and pass the
+    ///     updated value to the next read of the same file.
+    /// </param>
+    /// <param name="count">Receives the number of bytes read; 0 at end of file.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryReadContent(
+        SafeFileHandle file,
+        Span<byte> buffer,
+        long offset,
+        bool dropBehind,
+        ref long owned,
+        out int count
+    )
+    {
+        var added = false;
         try
         {
-            if (Logger!.IsNativeDebugEnabled())
-                Logger!.ConWrite(
-                    $"Resolver: loading {libraryName} for assembly {assembly?.GetName()?.Name} searchPath={searchPath}"
+            file.DangerousAddRef(ref added);
+            long n = 0;
+            int rc;
+            fixed (byte* p = buffer)
+            fixed (long* o = &owned)
+            {
+                rc = LinuxShim.Api.ReadContent(
+                    (int)file.DangerousGetHandle(),
+                    p,
+                    buffer.Length,
+                    offset,
+                    dropBehind ? ContentDropBehind : 0,
+                    o,
+                    &n
                 );
+            }
+
+            count = (int)n;
+            return rc;
         }
-        catch
+        finally
         {
-            // ignore
+            if (added)
+                file.DangerousRelease();
         }
+    }
 
-        var full = FindNativeLibraryPath(NativeLibraryName);
-        if (full is null)
-            return IntPtr.Zero;
+    /// <summary>
+    ///     Finds the first data extent of a sparse file at or after an offset (SEEK_DATA, then SEEK_HOLE).
+    ///     Filesystems without hole tracking report the whole file as data.
+    /// </summary>
+    /// <param name="file">File handle, usually from <see cref="TryOpenContent" />.</param>
+    /// <param name="offset">File offset to search from.</param>
+    /// <param name="start">Receives the start of the data.</param>
+    /// <param name="end">Receives the end of the data: the next hole, or end of file.</param>
+    /// <returns>
+    ///     0 on success, ENXIO if only a hole follows <paramref name="offset" /> up to end of file, otherwise the
+    ///     native errno value.
+    /// </returns>
+    public static int TryFindData(SafeFileHandle file, long offset, out long start, out long end)
+    {
+        var added = false;
         try
         {
-            // Preload dependency libOsCallsCommonShim.so first if present
-            var libDir = new FileInfo(full).Directory; // Directory containing libOsCallsLinuxShim.so
-
-            // Check for libOsCallsCommonShim.so in same directory first (test scenario)
-            var colocated = Path.Combine(libDir!.FullName, "libOsCallsCommonShim.so");
-            if (File.Exists(colocated))
-                try
-                {
-                    NativeLibrary.Load(colocated);
-                    return NativeLibrary.Load(full);
-                }
-                catch
-                {
-                    /* fallback to walking up */
-                }
-
-            // Otherwise, walk up to solution root and find it in build output
-            var projectRoot = libDir?.Parent?.Parent?.Parent?.Parent; // ascend to solution root
-            if (projectRoot is not null)
-            {
-                var commonShimDebug = Path.Combine(
-                    projectRoot.FullName,
-                    "OsCallsCommonShim",
-                    "bin",
-                    "Debug",
-                    "net8.0",
-                    "libOsCallsCommonShim.so"
-                );
-                var commonShimRelease = Path.Combine(
-                    projectRoot.FullName,
-                    "OsCallsCommonShim",
-                    "bin",
-                    "Release",
-                    "net8.0",
-                    "libOsCallsCommonShim.so"
-                );
-                foreach (var dep in new[] { commonShimDebug, commonShimRelease })
-                    if (File.Exists(dep))
-                        try
-                        {
-                            NativeLibrary.Load(dep);
-                            break;
-                        }
-                        catch
-                        {
-                            /* ignore */
-                        }
-
-                // If still not resolved by dynamic loader, append common shim directory to LD_LIBRARY_PATH and retry.
-                var commonDir =
-                    File.Exists(commonShimDebug) ? Path.GetDirectoryName(commonShimDebug)!
-                    : File.Exists(commonShimRelease) ? Path.GetDirectoryName(commonShimRelease)!
-                    : null;
-                if (commonDir is not null)
-                {
-                    var ld = Environment.GetEnvironmentVariable("LD_LIBRARY_PATH") ?? string.Empty;
-                    if (!ld.Split(':').Contains(commonDir))
-                    {
-                        var newLd = string.IsNullOrWhiteSpace(ld) ? commonDir : commonDir + ":" + ld;
-                        Environment.SetEnvironmentVariable("LD_LIBRARY_PATH", newLd);
-                    }
-                }
-            }
-
-            return NativeLibrary.Load(full);
+            file.DangerousAddRef(ref added);
+            long s = 0;
+            long e = 0;
+            var rc = LinuxShim.Api.FindData((int)file.DangerousGetHandle(), offset, &s, &e);
+            start = s;
+            end = e;
+            return rc;
         }
-        catch
+        finally
         {
-            return IntPtr.Zero;
+            if (added)
+                file.DangerousRelease();
         }
     }
 
-    private static string? FindNativeLibraryPath(string fileName)
+    /// <summary>
+    ///     fstatat without following symlinks: same result as <see cref="TryLStat" /> on the joined path.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />; empty stats the handle itself.</param>
+    /// <param name="record">Receives the stat fields on success; zeroed on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryLStatAt(FileSystemHandle directory, string name, out StatRecord record)
     {
-        // First check if library was copied to same directory (e.g., during tests)
-        var baseDir = AppContext.BaseDirectory;
-        var colocated = Path.Combine(baseDir, fileName);
-        if (File.Exists(colocated))
-            return colocated;
-
-        // Start at base directory (bin/<config>/net8.0[/RID]) and walk up looking for project folder.
-        var dir = new DirectoryInfo(baseDir);
-        for (var i = 0; i < 8 && dir is not null; i++)
+        record = default;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        fixed (StatRecord* p = &record)
         {
-            var candidateDebug = Path.Combine(dir.FullName, "OsCallsLinuxShim", "bin", "Debug", "net8.0", fileName);
-            if (File.Exists(candidateDebug))
-                return candidateDebug;
-            var candidateRelease = Path.Combine(dir.FullName, "OsCallsLinuxShim", "bin", "Release", "net8.0", fileName);
-            if (File.Exists(candidateRelease))
-                return candidateRelease;
-            dir = dir.Parent;
+            return LinuxShim.Api.FStatAtInto(dir.Value, arg.Pointer, p);
         }
+    }
 
-        return null;
+    /// <summary>
+    ///     statx without following symlinks, asking only for the fields in <paramref name="mask" />. With
+    ///     <see cref="StatxSync.DontSync" /> network filesystems may answer from cached attributes.
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <param name="mask">Fields wanted; <see cref="StatxRecord.Mask" /> tells which were filled.</param>
+    /// <param name="sync">Attribute synchronization with the server, for network filesystems.</param>
+    /// <param name="record">Receives the fields on success; zeroed on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryStatx(string path, StatxMask mask, StatxSync sync, out StatxRecord record)
+    {
+        record = default;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        fixed (StatxRecord* p = &record)
+        {
+            return LinuxShim.Api.Statx(AtFdCwd, arg.Pointer, (uint)sync, (uint)mask, p);
+        }
     }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValueT* lstat(string path);
+    /// <summary>
+    ///     <see cref="TryStatx" /> of an entry addressed relative to a directory handle.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />; empty stats the handle itself.</param>
+    /// <param name="mask">Fields wanted; <see cref="StatxRecord.Mask" /> tells which were filled.</param>
+    /// <param name="sync">Attribute synchronization with the server, for network filesystems.</param>
+    /// <param name="record">Receives the fields on success; zeroed on failure.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryStatxAt(
+        FileSystemHandle directory,
+        string name,
+        StatxMask mask,
+        StatxSync sync,
+        out StatxRecord record
+    )
+    {
+        record = default;
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        fixed (StatxRecord* p = &record)
+        {
+            return LinuxShim.Api.Statx(dir.Value, arg.Pointer, (uint)sync, (uint)mask, p);
+        }
+    }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValueT* readlink(string path);
+    /// <summary>
+    ///     Tells whether a handle lives on a network filesystem (NFS, SMB/CIFS, Ceph, 9P, AFS), where a full
+    ///     stat may cost a round trip to the server.
+    /// </summary>
+    /// <param name="handle">Handle from <see cref="TryOpenDirectory" /> or <see cref="TryOpenAt" />.</param>
+    /// <param name="remote">Receives true for a network filesystem.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryIsRemote(FileSystemHandle handle, out bool remote)
+    {
+        var value = 0;
+        using var h = handle.Acquire();
+        var rc = LinuxShim.Api.FsIsRemote(h.Value, &value);
+        remote = rc == 0 && value != 0;
+        return rc;
+    }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValueT* canonicalize_file_name(string path);
+    /// <summary>
+    ///     Physical byte offsets of the first data extent of files in a directory (FIEMAP), for reading them in
+    ///     on-disk order.
+    /// </summary>
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="names">Entry names within <paramref name="directory" />.</param>
+    /// <param name="offsets">Receives one offset per name; -1 where unknown (no data, no FIEMAP, vanished).</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetDataOffsets(FileSystemHandle directory, IReadOnlyList<string> names, Span<long> offsets)
+    {
+        if (offsets.Length < names.Count)
+            throw new ArgumentException("One offset per name is required", nameof(offsets));
+        var strings = new nint[names.Count];
+        try
+        {
+            for (var i = 0; i < names.Count; i++)
+                strings[i] = Marshal.StringToCoTaskMemUTF8(names[i]);
+            using var dir = directory.Acquire();
+            fixed (nint* p = strings)
+            fixed (long* o = offsets)
+            {
+                return LinuxShim.Api.DataOffsets(dir.Value, (byte**)p, names.Count, o);
+            }
+        }
+        finally
+        {
+            foreach (var s in strings)
+                Marshal.FreeCoTaskMem(s);
+        }
+    }
 
     /// <summary>
-    ///     Gets file status for the supplied path (like POSIX lstat), without following symlinks.
+    ///     Collects the metadata of an entry (not following symlinks) in one native call: stat, and as requested
+    ///     owner names, ACLs, extended attributes and the link target. Parts the filesystem does not support are
+    ///     left out of <paramref name="metadata" />.
     /// </summary>
     /// <param name="path">Filesystem path to inspect.</param>
-    /// <returns>A JsonObject containing stat fields (st_dev, st_ino, st_mode, ...).</returns>
-    public static JsonNode LStat(string path)
+    /// <param name="parts">Parts wanted besides the stat.</param>
+    /// <param name="metadata">Receives the metadata on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value of opening or stating the entry.</returns>
+    public static int TryCollectInode(string path, CollectParts parts, out InodeMetadata? metadata)
     {
-        return LinuxLStat(path);
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.CollectInode(AtFdCwd, arg.Pointer, (uint)parts, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeInodeMetadata, out metadata);
     }
 
     /// <summary>
-    ///     Platform-prefixed wrapper for calling the LStat functionality: preferred naming for OS-specific wrappers.
-    ///     This mirrors <see cref="LStat(string)" /> and is intended for direct use by OS-prefixed API code.
+    ///     <see cref="TryCollectInode" /> of an entry addressed relative to a directory handle.
     /// </summary>
-    public static JsonNode LinuxLStat(string path)
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Entry name within <paramref name="directory" />.</param>
+    /// <param name="parts">Parts wanted besides the stat.</param>
+    /// <param name="metadata">Receives the metadata on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value of opening or stating the entry.</returns>
+    public static int TryCollectInodeAt(
+        FileSystemHandle directory,
+        string name,
+        CollectParts parts,
+        out InodeMetadata? metadata
+    )
     {
-        if (_linux_lstat_fn is not null)
+        byte* data = null;
+        long length = 0;
+        int rc;
+        using (var dir = directory.Acquire())
         {
-            var ptr = _linux_lstat_fn(path);
-            return ToNode((ValueT*)ptr, path, "linux_lstat");
+            using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+            rc = LinuxShim.Api.CollectInode(dir.Value, arg.Pointer, (uint)parts, &data, &length);
         }
 
-        return ToNode(lstat(path), path, nameof(lstat));
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeInodeMetadata, out metadata);
     }
 
     /// <summary>
-    ///     Reads the target of a symbolic link.
+    ///     Reads the target of a symlink addressed relative to a directory handle; same result as
+    ///     <see cref="ReadLink" />.
     /// </summary>
-    /// <param name="path">Path of the symlink to read.</param>
-    /// <returns>A JsonNode with a <c>path</c> field set to the symlink target string.</returns>
-    public static JsonNode ReadLink(string path)
+    /// <param name="directory">Directory handle from <see cref="TryOpenDirectory" />.</param>
+    /// <param name="name">Symlink name within <paramref name="directory" />.</param>
+    /// <returns>A JsonNode with a <c>path</c> field containing the link target.</returns>
+    public static JsonNode ReadLinkAt(FileSystemHandle directory, string name)
     {
-        return LinuxReadLink(path);
+        using var dir = directory.Acquire();
+        using var arg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ToNode(LinuxShim.Api.ReadLinkAt(dir.Value, arg.Pointer), name, "linux_readlinkat");
     }
 
     /// <summary>
-    ///     Platform-prefixed wrapper for ReadLink.
+    ///     Lists a directory in a single native call (getdents64 in large batches) and, with
+    ///     <paramref name="withStat" />, lstats every entry relative to the open directory in the same call. For
+    ///     large directories this replaces one managed enumeration step plus one lstat call per entry.
     /// </summary>
-    public static JsonNode LinuxReadLink(string path)
+    /// <param name="path">Directory to list.</param>
+    /// <param name="withStat">Also fill <see cref="DirectoryEntry.Stat" /> (or its StatError) for each entry.</param>
+    /// <param name="entries">
+    ///     Receives the entries (without "." and "..") in directory order, with <paramref name="withStat" /> in inode
+    ///     order; null on failure.
+    /// </param>
+    /// <returns>0 on success, otherwise the native errno value of opening or reading the directory.</returns>
+    public static int TryReadDirectory(string path, bool withStat, out List<DirectoryEntry>? entries)
     {
-        if (_linux_readlink_fn is not null)
-        {
-            var ptr = _linux_readlink_fn(path);
-            return ToNode((ValueT*)ptr, path, "linux_readlink");
-        }
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.ReadDirectory(arg.Pointer, withStat ? ReadDirectoryStat : 0, &data, &length);
+        return TryDecodePacked(rc, data, length, PackedDecoders.DecodeDirectory, out entries);
+    }
+
+    /// <summary>
+    ///     Managed mirror of the native <c>OsCalls::StatRecord</c> filled by <c>linux_lstat_into</c>.
+    ///     Field order and widths must match FileSystem.h exactly.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct StatRecord
+    {
+        /// <summary>Device ID containing the file (st_dev).</summary>
+        public long Dev;
+
+        /// <summary>Inode number (st_ino).</summary>
+        public long Ino;
+
+        /// <summary>File type and mode bits (st_mode).</summary>
+        public long Mode;
+
+        /// <summary>Number of hard links (st_nlink).</summary>
+        public long NLink;
+
+        /// <summary>Owner user ID (st_uid).</summary>
+        public long Uid;
+
+        /// <summary>Owner group ID (st_gid).</summary>
+        public long Gid;
 
-        return ToNode(readlink(path), path, nameof(readlink));
+        /// <summary>Device ID for special files (st_rdev).</summary>
+        public long RDev;
+
+        /// <summary>Size in bytes (st_size).</summary>
+        public long Size;
+
+        /// <summary>Preferred I/O block size (st_blksize).</summary>
+        public long BlkSize;
+
+        /// <summary>Number of 512-byte blocks allocated (st_blocks).</summary>
+        public long Blocks;
+
+        /// <summary>Last access time (st_atim).</summary>
+        public TimeSpecT ATim;
+
+        /// <summary>Last modification time (st_mtim).</summary>
+        public TimeSpecT MTim;
+
+        /// <summary>Last status change time (st_ctim).</summary>
+        public TimeSpecT CTim;
     }
 
     /// <summary>
-    ///     Resolves a path to its canonical absolute form (resolving symlinks and relative segments).
+    ///     Managed mirror of the native <c>OsCalls::StatxRecord</c> filled by <c>linux_statx</c>.
+    ///     Field order and widths must match FileSystem.h exactly.
     /// </summary>
-    /// <param name="path">Original input path.</param>
-    /// <returns>A JsonNode with a <c>path</c> field set to the canonical path.</returns>
-    public static JsonNode Canonicalizefilename(string path)
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct StatxRecord
     {
-        return LinuxCanonicalizeFileName(path);
+        /// <summary>Fields actually filled (stx_mask); others are zero.</summary>
+        public StatxMask Mask;
+
+        /// <summary>File attribute flags (stx_attributes).</summary>
+        public StatxAttributes Attributes;
+
+        /// <summary>Attribute flags the filesystem supports (stx_attributes_mask).</summary>
+        public StatxAttributes AttributesMask;
+
+        /// <summary>Device ID containing the file, comparable to st_dev.</summary>
+        public long Dev;
+
+        /// <summary>Inode number (stx_ino).</summary>
+        public long Ino;
+
+        /// <summary>File type and mode bits (stx_mode).</summary>
+        public long Mode;
+
+        /// <summary>Number of hard links (stx_nlink).</summary>
+        public long NLink;
+
+        /// <summary>Owner user ID (stx_uid).</summary>
+        public long Uid;
+
+        /// <summary>Owner group ID (stx_gid).</summary>
+        public long Gid;
+
+        /// <summary>Device ID for special files, comparable to st_rdev.</summary>
+        public long RDev;
+
+        /// <summary>Size in bytes (stx_size).</summary>
+        public long Size;
+
+        /// <summary>Preferred I/O block size (stx_blksize).</summary>
+        public long BlkSize;
+
+        /// <summary>Number of 512-byte blocks allocated (stx_blocks).</summary>
+        public long Blocks;
+
+        /// <summary>Mount ID of the mount containing the file (stx_mnt_id).</summary>
+        public long MntId;
+
+        /// <summary>Last access time (stx_atime).</summary>
+        public TimeSpecT ATime;
+
+        /// <summary>Creation time (stx_btime).</summary>
+        public TimeSpecT BTime;
+
+        /// <summary>Last status change time (stx_ctime).</summary>
+        public TimeSpecT CTime;
+
+        /// <summary>Last modification time (stx_mtime).</summary>
+        public TimeSpecT MTime;
     }
 
     /// <summary>
-    ///     Platform-prefixed wrapper for canonicalize_file_name.
+    ///     STATX_* field bits (linux/stat.h), requested from and reported by <c>linux_statx</c>.
     /// </summary>
-    public static JsonNode LinuxCanonicalizeFileName(string path)
+    [Flags]
+    public enum StatxMask : long
     {
-        if (_linux_cfn_fn is not null)
-        {
-            var ptr = _linux_cfn_fn(path);
-            return ToNode((ValueT*)ptr, path, "linux_canonicalize_file_name");
-        }
+        /// <summary>File type bits of the mode.</summary>
+        Type = 0x1,
+
+        /// <summary>Permission bits of the mode.</summary>
+        Mode = 0x2,
+
+        /// <summary>Hard link count.</summary>
+        NLink = 0x4,
+
+        /// <summary>Owner user ID.</summary>
+        Uid = 0x8,
+
+        /// <summary>Owner group ID.</summary>
+        Gid = 0x10,
+
+        /// <summary>Last access time.</summary>
+        ATime = 0x20,
+
+        /// <summary>Last modification time.</summary>
+        MTime = 0x40,
+
+        /// <summary>Last status change time.</summary>
+        CTime = 0x80,
 
-        return ToNode(canonicalize_file_name(path), path, nameof(canonicalize_file_name));
+        /// <summary>Inode number.</summary>
+        Ino = 0x100,
+
+        /// <summary>Size.</summary>
+        Size = 0x200,
+
+        /// <summary>Allocated block count.</summary>
+        Blocks = 0x400,
+
+        /// <summary>Everything lstat returns.</summary>
+        BasicStats = 0x7ff,
+
+        /// <summary>Creation time.</summary>
+        BTime = 0x800,
+
+        /// <summary>Mount ID.</summary>
+        MntId = 0x1000,
     }
 
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    private delegate IntPtr ShimFnDelegate([MarshalAs(UnmanagedType.LPUTF8Str)] string path);
+    /// <summary>
+    ///     AT_STATX_* synchronization modes: how far a network filesystem revalidates attributes with the server.
+    /// </summary>
+    public enum StatxSync : uint
+    {
+        /// <summary>Whatever stat() does on the filesystem.</summary>
+        AsStat = 0x0000,
+
+        /// <summary>Always fetch the attributes from the server.</summary>
+        ForceSync = 0x2000,
+
+        /// <summary>Use cached attributes where available, without a round trip.</summary>
+        DontSync = 0x4000,
+    }
+
+    /// <summary>
+    ///     STATX_ATTR_* file attribute flags (linux/stat.h).
+    /// </summary>
+    [Flags]
+    public enum StatxAttributes : long
+    {
+        /// <summary>No attributes.</summary>
+        None = 0,
+
+        /// <summary>File is compressed by the filesystem.</summary>
+        Compressed = 0x4,
+
+        /// <summary>File cannot be modified.</summary>
+        Immutable = 0x10,
+
+        /// <summary>File can only be appended to.</summary>
+        Append = 0x20,
+
+        /// <summary>File is not to be dumped (chattr +d).</summary>
+        NoDump = 0x40,
+
+        /// <summary>File content is encrypted.</summary>
+        Encrypted = 0x800,
+
+        /// <summary>Directory is an automount trigger.</summary>
+        Automount = 0x1000,
+
+        /// <summary>Root of a mount.</summary>
+        MountRoot = 0x2000,
+
+        /// <summary>Verity-protected file.</summary>
+        Verity = 0x100000,
+
+        /// <summary>File is in the DAX (direct access) state.</summary>
+        Dax = 0x200000,
+    }
+
+    /// <summary>
+    ///     COLLECT_* parts of <c>linux_collect_inode</c> (InodeCollector.h).
+    /// </summary>
+    [Flags]
+    public enum CollectParts : uint
+    {
+        /// <summary>Only the stat record.</summary>
+        None = 0,
+
+        /// <summary>User and group names.</summary>
+        Owner = 0x1,
+
+        /// <summary>Access ACL, plus the default ACL of directories; symlinks have none.</summary>
+        Acl = 0x2,
+
+        /// <summary>Target of a symlink.</summary>
+        Link = 0x4,
+
+        /// <summary>
+        ///     With <see cref="Acl" />: the raw system.posix_acl_* values (<see cref="InodeMetadata.AccessAclRaw" />)
+        ///     instead of text, without libacl and without resolving qualifiers through NSS.
+        /// </summary>
+        AclRaw = 0x8,
+
+        /// <summary>Extended attributes in the user. namespace.</summary>
+        XattrUser = 0x10,
+
+        /// <summary>Extended attributes in the trusted. namespace.</summary>
+        XattrTrusted = 0x20,
+
+        /// <summary>Extended attributes in the security. namespace.</summary>
+        XattrSecurity = 0x40,
+
+        /// <summary>Extended attributes in the system. namespace (including system.posix_acl_*).</summary>
+        XattrSystem = 0x80,
+
+        /// <summary>Extended attributes of every namespace.</summary>
+        Xattrs = 0xF0,
+    }
 
     // Inlined former convenience predicates (IsDir/IsReg/IsLnk) directly at call sites for minor perf/readability tweaks.
 }
@@ -0,0 +1,68 @@
+using System.Runtime.InteropServices;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     Opaque Linux shim handle: a directory opened with <see cref="FileSystem.TryOpenDirectory" />, or a single
+///     entry opened with <see cref="FileSystem.TryOpenAt" />. Closed through <c>linux_close_handle</c>.
+/// </summary>
+public sealed class FileSystemHandle : SafeHandle
+{
+    /// <summary>Creates an invalid handle.</summary>
+    public FileSystemHandle()
+        : base(-1, true) { }
+
+    internal FileSystemHandle(long handle)
+        : base(-1, true)
+    {
+        SetHandle((nint)handle);
+    }
+
+    /// <inheritdoc />
+    public override bool IsInvalid => handle == -1;
+
+    /// <summary>
+    ///     True when the handle is on a network filesystem, as reported by <see cref="FileSystem.TryIsRemote" />;
+    ///     set by whoever opened it and asked.
+    /// </summary>
+    public bool IsRemote { get; internal set; }
+
+    /// <inheritdoc />
+    protected override unsafe bool ReleaseHandle()
+    {
+        return LinuxShim.Api.CloseHandle(handle) == 0;
+    }
+
+    /// <summary>
+    ///     Keeps the handle referenced (and so open) for the duration of one native call.
+    /// </summary>
+    internal Use Acquire()
+    {
+        return new Use(this);
+    }
+
+    /// <summary>AddRef'd raw handle value; dispose right after the native call.</summary>
+    internal ref struct Use
+    {
+        private readonly FileSystemHandle _owner;
+        private bool _added;
+
+        public Use(FileSystemHandle owner)
+        {
+            _owner = owner;
+            _added = false;
+            owner.DangerousAddRef(ref _added);
+            Value = owner.DangerousGetHandle();
+        }
+
+        /// <summary>Native handle value.</summary>
+        public long Value { get; }
+
+        public void Dispose()
+        {
+            if (_added)
+                _owner.DangerousRelease();
+            _added = false;
+        }
+    }
+}
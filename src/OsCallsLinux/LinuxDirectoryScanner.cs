@@ -0,0 +1,24 @@
+using OsCallsCommon;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     <see cref="IDirectoryScanner" /> over the native prefetcher (<see cref="DirectoryWalker" />).
+/// </summary>
+internal sealed class LinuxDirectoryScanner(DirectoryWalker walker) : IDirectoryScanner
+{
+    /// <inheritdoc />
+    public DirectoryListingEntry[] ReadDirectory(string path, InodeData directory)
+    {
+        var rc = walker.TryTake(path, (long)directory.Device, (long)directory.FileIndex, out var entries);
+        if (rc != 0)
+            throw LinuxHighLevelOsApi.ListingError(path, rc);
+        return LinuxHighLevelOsApi.ToListing(path, entries!);
+    }
+
+    /// <inheritdoc />
+    public void Dispose()
+    {
+        walker.Dispose();
+    }
+}
@@ -1,3 +1,5 @@
+using System.ComponentModel;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Text.Json.Nodes;
 using ArchiveDataHandler;
@@ -18,6 +20,42 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
     /// </summary>
     public static IHighLevelOsApi Instance => _instance.Value;
 
+    // File type bits of st_mode (sys/stat.h).
+    private const int S_IFMT = 0xF000;
+    private const int S_IFSOCK = 0xC000;
+    private const int S_IFLNK = 0xA000;
+    private const int S_IFREG = 0x8000;
+    private const int S_IFBLK = 0x6000;
+    private const int S_IFDIR = 0x4000;
+    private const int S_IFCHR = 0x2000;
+    private const int S_IFIFO = 0x1000;
+
+    // Fields of an inode record: everything FromStat uses, so not atime or the block counts.
+    private const FileSystem.StatxMask InodeStatxMask =
+        FileSystem.StatxMask.Type
+        | FileSystem.StatxMask.Mode
+        | FileSystem.StatxMask.NLink
+        | FileSystem.StatxMask.Uid
+        | FileSystem.StatxMask.Gid
+        | FileSystem.StatxMask.Ino
+        | FileSystem.StatxMask.Size
+        | FileSystem.StatxMask.MTime
+        | FileSystem.StatxMask.CTime;
+
+    // Everything CompleteInodeDataFromPath stores besides the content. ACLs come raw: libacl would resolve
+    // every qualifier through NSS inside the native call.
+    private const FileSystem.CollectParts CollectedParts =
+        FileSystem.CollectParts.Owner
+        | FileSystem.CollectParts.Acl
+        | FileSystem.CollectParts.AclRaw
+        | FileSystem.CollectParts.Xattrs
+        | FileSystem.CollectParts.Link;
+
+    // errno values (asm-generic/errno-base.h).
+    private const int EPERM = 1;
+    private const int ENOENT = 2;
+    private const int EACCES = 13;
+
     /// <summary>
     ///     Creates a minimal InodeData object from a filesystem path containing only
     ///     stat information (no ACLs, xattrs, or content hashes).
@@ -27,41 +65,123 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
     /// <exception cref="OsException">Thrown on permission denied, not found, or I/O errors</exception>
     public InodeData CreateMinimalInodeDataFromPath(string path)
     {
-        var statBuf = FileSystem.LStat(path);
-        var flags = new HashSet<string>();
-        if (statBuf is JsonObject statObj)
-            foreach (var kvp in statObj)
-            {
-                var key = kvp.Key;
-                if (!key.StartsWith("S_IS") && !key.StartsWith("S_TYPEIS"))
-                    continue;
+        var rc = FileSystem.LinuxLStatInto(path, out var st);
+        if (rc != 0)
+            ValXfer.ThrowNativeError(rc, path, "linux_lstat_into");
+        return FromStat(st);
+    }
+
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(string path, out InodeData? data)
+    {
+        var rc = FileSystem.TryLStat(path, out var st);
+        data = rc == 0 ? FromStat(st) : null;
+        return rc;
+    }
 
-                if (kvp.Value?.GetValue<bool>() != true)
-                    continue;
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(SafeHandle? directory, string path, out InodeData? data)
+    {
+        var dir = AsDirectory(directory, path, out var name);
+        if (dir is { IsRemote: true })
+        {
+            // Only the fields of the record, from cached attributes: no revalidation round trip per entry
+            var statxRc = FileSystem.TryStatxAt(
+                dir,
+                name,
+                InodeStatxMask,
+                FileSystem.StatxSync.DontSync,
+                out var stx
+            );
+            data = statxRc == 0 ? FromStatx(stx) : null;
+            return statxRc;
+        }
 
-                var flagName = key.StartsWith("S_TYPEIS") ? key[8..].ToLowerInvariant() : key[4..].ToLowerInvariant();
-                flags.Add(flagName);
-            }
+        var rc = dir is null ? FileSystem.TryLStat(path, out var st) : FileSystem.TryLStatAt(dir, name, out st);
+        data = rc == 0 ? FromStat(st) : null;
+        return rc;
+    }
 
+    /// <summary>
+    ///     Builds the minimal <see cref="InodeData" /> from a statx record, like <see cref="FromStat" />.
+    /// </summary>
+    private static InodeData FromStatx(in FileSystem.StatxRecord stx)
+    {
         return new InodeData
         {
-            Device = statBuf["st_dev"]?.GetValue<long>() ?? 0,
-            FileIndex = statBuf["st_ino"]?.GetValue<long>() ?? 0,
-            Mode = statBuf["st_mode"]?.GetValue<long>() ?? 0,
-            Flags = flags,
-            NLink = statBuf["st_nlink"]?.GetValue<long>() ?? 0,
-            Uid = statBuf["st_uid"]?.GetValue<long>() ?? 0,
-            Gid = statBuf["st_gid"]?.GetValue<long>() ?? 0,
-            RDev = statBuf["st_rdev"]?.GetValue<long>() ?? 0,
-            Size = statBuf["st_size"]?.GetValue<long>() ?? 0,
-            MTime = statBuf["st_mtim"]?.GetValue<double>() ?? 0,
-            CTime = statBuf["st_ctim"]?.GetValue<double>() ?? 0,
+            Device = stx.Dev,
+            FileIndex = stx.Ino,
+            Mode = stx.Mode,
+            Flags = FlagsFromMode(stx.Mode),
+            NLink = stx.NLink,
+            Uid = stx.Uid,
+            Gid = stx.Gid,
+            RDev = stx.RDev,
+            Size = stx.Size,
+            MTime = ToSeconds(stx.MTime),
+            CTime = ToSeconds(stx.CTime),
             Acl = [],
             Xattr = [],
             Hashes = [],
         };
     }
 
+    /// <summary>
+    ///     Builds the minimal <see cref="InodeData" /> from a flat stat record.
+    /// </summary>
+    private static InodeData FromStat(in FileSystem.StatRecord st)
+    {
+        return new InodeData
+        {
+            Device = st.Dev,
+            FileIndex = st.Ino,
+            Mode = st.Mode,
+            Flags = FlagsFromMode(st.Mode),
+            NLink = st.NLink,
+            Uid = st.Uid,
+            Gid = st.Gid,
+            RDev = st.RDev,
+            Size = st.Size,
+            MTime = ToSeconds(st.MTim),
+            CTime = ToSeconds(st.CTim),
+            Acl = [],
+            Xattr = [],
+            Hashes = [],
+        };
+    }
+
+    /// <summary>
+    ///     Derives the file type flags ("reg", "dir", "lnk", ...) from st_mode, matching the lowercased
+    ///     S_IS* key names produced by <see cref="FileSystem.LStat" />.
+    /// </summary>
+    private static HashSet<string> FlagsFromMode(long mode)
+    {
+        var flags = new HashSet<string>();
+        var type = (int)mode & S_IFMT;
+        var flag = type switch
+        {
+            S_IFBLK => "blk",
+            S_IFCHR => "chr",
+            S_IFDIR => "dir",
+            S_IFIFO => "fifo",
+            S_IFLNK => "lnk",
+            S_IFREG => "reg",
+            S_IFSOCK => "sock",
+            _ => null,
+        };
+        if (flag is not null)
+            flags.Add(flag);
+        return flags;
+    }
+
+    /// <summary>
+    ///     Converts a native timespec into fractional seconds, as <see cref="ValXfer.ToNode" /> does.
+    /// </summary>
+    private static double ToSeconds(ValXfer.TimeSpecT ts)
+    {
+        return ts.TvSec + ts.TvNsec / (double)(1000 * 1000 * 1000);
+    }
+
     /// <summary>
     ///     Completes an existing <see cref="InodeData" /> instance with ACLs, xattrs, and content hashes for the specified
     ///     path.
@@ -73,89 +193,61 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
     /// <param name="archiveStore">Archive store used to save auxiliary data streams.</param>
     /// <returns>Completed <see cref="InodeData" /> instance.</returns>
     public InodeData CompleteInodeDataFromPath(string path, ref InodeData data, IArchiveStore archiveStore)
+    {
+        return CompleteInodeDataFromPath(null, path, ref data, archiveStore);
+    }
+
+    /// <inheritdoc />
+    public InodeData CompleteInodeDataFromPath(
+        SafeHandle? directory,
+        string path,
+        ref InodeData data,
+        IArchiveStore archiveStore
+    )
     {
         ArgumentNullException.ThrowIfNull(data);
+        var dir = AsDirectory(directory, path, out var name);
 
-        // Resolve user/group names based on pre-initialized uid/gid
-        data.UserName = UserGroupDatabase.GetPwUid(data.Uid)["pw_name"]?.ToString() ?? data.Uid.ToString();
-        data.GroupName = UserGroupDatabase.GetGrGid(data.Gid)["gr_name"]?.ToString() ?? data.Gid.ToString();
+        // Owner names, ACLs, xattrs and the link target in one native call. If the entry cannot be opened
+        // (typically it vanished), the names are still resolved and the content step below reports the error.
+        var rc = dir is null
+            ? FileSystem.TryCollectInode(path, CollectedParts, out var metadata)
+            : FileSystem.TryCollectInodeAt(dir, name, CollectedParts, out metadata);
+        var userName =
+            metadata?.Stat.Uid == data.Uid ? metadata.UserName : UserGroupDatabase.LinuxGetUserName(data.Uid);
+        var groupName =
+            metadata?.Stat.Gid == data.Gid ? metadata.GroupName : UserGroupDatabase.LinuxGetGroupName(data.Gid);
+        data.UserName = userName ?? data.Uid.ToString();
+        data.GroupName = groupName ?? data.Gid.ToString();
 
-        // Read ACLs
+        // ACLs the filesystem does not support are simply absent. Raw ACLs are rendered in libacl's text form
+        // with numeric qualifiers here, without any user or group lookup.
         string[] aclHashes = [];
         try
         {
-            var aclAccessResult = Acl.GetFileAccess(path);
-            if (aclAccessResult is JsonObject aclAccessObj && aclAccessObj.ContainsKey("acl_text"))
-            {
-                var aclText = aclAccessObj["acl_text"]?.ToString() ?? "";
-                if (!string.IsNullOrEmpty(aclText))
-                {
-                    var aclBytes = Encoding.UTF8.GetBytes(aclText);
-                    var aclMem = new MemoryStream(aclBytes);
-                    aclHashes = [.. archiveStore.SaveStream(aclMem, aclBytes.Length, $"{path} $acl", _ => { })];
-                }
-            }
-
-            // For directories, also read default ACL
-            if (data.Flags.Contains("dir"))
-            {
-                var aclDefaultResult = Acl.GetFileDefault(path);
-                if (aclDefaultResult is JsonObject aclDefaultObj && aclDefaultObj.ContainsKey("acl_text"))
-                {
-                    var aclDefaultText = aclDefaultObj["acl_text"]?.ToString() ?? "";
-                    if (!string.IsNullOrEmpty(aclDefaultText))
-                    {
-                        var aclDefaultBytes = Encoding.UTF8.GetBytes(aclDefaultText);
-                        var aclDefaultMem = new MemoryStream(aclDefaultBytes);
-                        var defaultHashes = archiveStore
-                            .SaveStream(aclDefaultMem, aclDefaultBytes.Length, $"{path} $acl_default", _ => { })
-                            .ToArray();
-                        aclHashes = [.. aclHashes, .. defaultHashes];
-                    }
-                }
-            }
+            var accessAcl = metadata?.AccessAclRaw is { } accessRaw ? AclText(accessRaw) : metadata?.AccessAcl;
+            var defaultAcl = metadata?.DefaultAclRaw is { } defaultRaw ? AclText(defaultRaw) : metadata?.DefaultAcl;
+            if (!string.IsNullOrEmpty(accessAcl))
+                aclHashes = SaveText(archiveStore, accessAcl, $"{path} $acl");
+            if (data.Flags.Contains("dir") && !string.IsNullOrEmpty(defaultAcl))
+                aclHashes = [.. aclHashes, .. SaveText(archiveStore, defaultAcl, $"{path} $acl_default")];
         }
         catch (Exception)
         {
-            // ACL reading may fail - not fatal, continue with empty ACLs
+            // Saving ACLs may fail - not fatal, continue with empty ACLs
         }
 
-        // Read extended attributes
+        // Extended attribute values, binary-safe
         Dictionary<string, IEnumerable<string>> xattrHashes = [];
-        try
-        {
-            var xattrListResult = Xattr.ListXattr(path);
-            if (xattrListResult is JsonArray xattrArray)
-                foreach (var xattrNameNode in xattrArray)
-                {
-                    var xattrName = xattrNameNode?.ToString();
-                    if (string.IsNullOrEmpty(xattrName))
-                        continue;
-
-                    try
-                    {
-                        var xattrValueResult = Xattr.GetXattr(path, xattrName);
-                        if (xattrValueResult is JsonObject xattrValueObj && xattrValueObj.ContainsKey("value"))
-                        {
-                            var xattrValue = xattrValueObj["value"]?.ToString() ?? "";
-                            var xattrBytes = Encoding.UTF8.GetBytes(xattrValue);
-                            var xattrMem = new MemoryStream(xattrBytes);
-                            var xattrHashList = archiveStore
-                                .SaveStream(xattrMem, xattrBytes.Length, $"{path} $xattr:{xattrName}", _ => { })
-                                .ToArray();
-                            xattrHashes[xattrName] = xattrHashList;
-                        }
-                    }
-                    catch (Exception)
-                    {
-                        // Individual xattr reading may fail - continue
-                    }
-                }
-        }
-        catch (Exception)
-        {
-            // Xattr listing may fail - not fatal, continue with empty xattrs
-        }
+        foreach (var (xattrName, value) in metadata?.Xattrs ?? [])
+            try
+            {
+                xattrHashes[xattrName] = archiveStore.SaveValue(value, $"{path} $xattr:{xattrName}").ToArray();
+            }
+            catch (Exception)
+            {
+                // Saving an individual xattr may fail - continue
+            }
 
         data.Acl = aclHashes;
         data.Xattr = xattrHashes;
@@ -168,7 +260,8 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
             if (data.Size != 0)
                 try
                 {
-                    using var fileStream = File.OpenRead(path);
+                    // No atime update, and the pages read are dropped from the page cache behind us
+                    using var fileStream = ContentStream.Open(dir, dir is null ? path : name);
                     hashes = [.. archiveStore.SaveStream(fileStream, data.Size, path, _ => { })];
                 }
                 catch (Exception ex)
@@ -178,19 +271,18 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
         }
         else if (data.Flags.Contains("lnk"))
         {
-            // Symlink - read target
-            try
-            {
-                var linkNode = FileSystem.ReadLink(path);
-                var linkTarget = linkNode?["path"]?.GetValue<string>() ?? string.Empty;
-                var linkBytes = Encoding.UTF8.GetBytes(linkTarget);
-                var linkMem = new MemoryStream(linkBytes);
-                hashes = [.. archiveStore.SaveStream(linkMem, linkBytes.Length, $"{path} $data readlink", _ => { })];
-            }
-            catch (Exception ex)
-            {
-                throw new OsException($"Failed to read symlink {path}", ErrorKind.IOError, ex);
-            }
+            // Symlink - the target as read with its exact length
+            var target = metadata?.LinkTarget;
+            if (target is null)
+                throw new OsException(
+                    $"Failed to read symlink {path}",
+                    ErrorKind.IOError,
+                    new Win32Exception(rc != 0 ? rc : metadata!.LinkError)
+                );
+            hashes =
+            [
+                .. archiveStore.SaveStream(new MemoryStream(target), target.Length, $"{path} $data readlink", _ => { }),
+            ];
         }
         else if (data.Flags.Contains("dir"))
         {
@@ -203,31 +295,142 @@ public class LinuxHighLevelOsApi : IHighLevelOsApi
         return data;
     }
 
+    /// <inheritdoc />
+    public SafeHandle? OpenDirectoryHandle(string path)
+    {
+        if (FileSystem.TryOpenDirectory(path, out var directory) != 0)
+            return null;
+        directory!.IsRemote = FileSystem.TryIsRemote(directory, out var remote) == 0 && remote;
+        return directory;
+    }
+
+    /// <summary>
+    ///     Returns <paramref name="directory" /> if it is a usable handle of this platform and
+    ///     <paramref name="path" /> names an entry in it; null means "use the path".
+    /// </summary>
+    private static FileSystemHandle? AsDirectory(SafeHandle? directory, string path, out string name)
+    {
+        name = Path.GetFileName(path);
+        return directory is FileSystemHandle { IsInvalid: false, IsClosed: false } dir && name.Length > 0 ? dir : null;
+    }
+
+    /// <summary>
+    ///     Renders a raw POSIX ACL xattr value as libacl short text with numeric qualifiers ("u:1000:rwx"), so no
+    ///     user or group lookup is made per inode.
+    /// </summary>
+    private static string AclText(byte[] raw)
+    {
+        return Acl.FormatNumericText(raw);
+    }
+
+    /// <summary>
+    ///     Stores a metadata text (ACL) as UTF-8; same chunks as saving it through a stream.
+    /// </summary>
+    private static string[] SaveText(IArchiveStore archiveStore, string text, string name)
+    {
+        var bytes = Encoding.UTF8.GetBytes(text);
+        return [.. archiveStore.SaveValue(bytes, name)];
+    }
+
     /// <summary>
     ///     List the directory entries for <paramref name="path" /> ordered by
-    ///     ordinal string comparison. Wraps <see cref="Directory.GetFileSystemEntries(string)" />
-    ///     and maps system exceptions to <see cref="OsException" />.
+    ///     ordinal string comparison. Reads the directory in one native call
+    ///     (<see cref="FileSystem.TryReadDirectory" />) and maps errors to <see cref="OsException" />.
     /// </summary>
     /// <param name="path">Directory to list.</param>
     /// <returns>Ordered array of filesystem entries (files and directories).</returns>
     public string[] ListDirectory(string path)
     {
-        try
-        {
-            return [.. Directory.GetFileSystemEntries(path).OrderBy(e => e, StringComparer.Ordinal)];
-        }
-        catch (UnauthorizedAccessException ex)
+        var entries = ReadEntries(path, false);
+        var paths = new string[entries.Count];
+        for (var i = 0; i < paths.Length; i++)
+            paths[i] = Path.Join(path, entries[i].Name);
+        Array.Sort(paths, StringComparer.Ordinal);
+        return paths;
+    }
+
+    /// <inheritdoc />
+    public DirectoryListingEntry[] ReadDirectory(string path)
+    {
+        return ToListing(path, ReadEntries(path, true));
+    }
+
+    /// <inheritdoc />
+    public IDirectoryScanner? OpenDirectoryScanner(
+        IReadOnlyList<string> roots,
+        IReadOnlyList<string> excluded,
+        int threads
+    )
+    {
+        return DirectoryWalker.TryOpen(roots, excluded, threads, 0, out var walker) == 0
+            ? new LinuxDirectoryScanner(walker!)
+            : null;
+    }
+
+    /// <inheritdoc />
+    public long[]? GetDataOffsets(string directory, IReadOnlyList<string> names)
+    {
+        if (FileSystem.TryOpenDirectory(directory, out var handle) != 0)
+            return null;
+        using (handle)
         {
-            throw new OsException($"Permission denied listing directory {path}", ErrorKind.PermissionDenied, ex);
+            var offsets = new long[names.Count];
+            return FileSystem.TryGetDataOffsets(handle!, names, offsets) == 0 ? offsets : null;
         }
-        catch (DirectoryNotFoundException ex)
+    }
+
+    /// <inheritdoc />
+    public int PreloadOwnerNames()
+    {
+        return UserGroupDatabase.PreloadNameCache(out var users, out var groups) == 0 ? users + groups : 0;
+    }
+
+    /// <summary>
+    ///     Converts native entries of <paramref name="path" /> into the sorted listing of
+    ///     <see cref="IHighLevelOsApi.ReadDirectory" />.
+    /// </summary>
+    internal static DirectoryListingEntry[] ToListing(string path, List<DirectoryEntry> entries)
+    {
+        var result = new DirectoryListingEntry[entries.Count];
+        for (var i = 0; i < result.Length; i++)
         {
-            throw new OsException($"Directory not found {path}", ErrorKind.NotFound, ex);
+            var entry = entries[i];
+            var data = entry.Stat is { } st ? FromStat(st) : null;
+            result[i] = new DirectoryListingEntry(Path.Join(path, entry.Name), data);
         }
-        catch (Exception ex)
+
+        Array.Sort(result, (a, b) => StringComparer.Ordinal.Compare(a.Path, b.Path));
+        return result;
+    }
+
+    /// <summary>
+    ///     Reads all entries of <paramref name="path" /> in one native call; errno is mapped like the
+    ///     exceptions of <see cref="Directory.GetFileSystemEntries(string)" /> used to be.
+    /// </summary>
+    private static List<DirectoryEntry> ReadEntries(string path, bool withStat)
+    {
+        var rc = FileSystem.TryReadDirectory(path, withStat, out var entries);
+        if (rc != 0)
+            throw ListingError(path, rc);
+        return entries!;
+    }
+
+    /// <summary>
+    ///     Maps the errno of a failed directory listing to an <see cref="OsException" />.
+    /// </summary>
+    internal static OsException ListingError(string path, int rc)
+    {
+        var ex = new Win32Exception(rc);
+        return rc switch
         {
-            throw new OsException($"Failed to list directory {path}", ErrorKind.IOError, ex);
-        }
+            EACCES or EPERM => new OsException(
+                $"Permission denied listing directory {path}",
+                ErrorKind.PermissionDenied,
+                ex
+            ),
+            ENOENT => new OsException($"Directory not found {path}", ErrorKind.NotFound, ex),
+            _ => new OsException($"Failed to list directory {path}", ErrorKind.IOError, ex),
+        };
     }
 
     /// <summary>
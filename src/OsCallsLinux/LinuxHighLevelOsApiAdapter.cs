@@ -1,3 +1,4 @@
+using System.Runtime.InteropServices;
 using System.Text.Json.Nodes;
 using ArchiveDataHandler;
 using OsCallsCommon;
@@ -30,18 +31,75 @@ public class LinuxHighLevelOsApiAdapter : IHighLevelOsApi
         return _inner.CreateMinimalInodeDataFromPath(path);
     }
 
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(string path, out InodeData? data)
+    {
+        return _inner.TryCreateMinimalInodeDataFromPath(path, out data);
+    }
+
+    /// <inheritdoc />
+    public SafeHandle? OpenDirectoryHandle(string path)
+    {
+        return _inner.OpenDirectoryHandle(path);
+    }
+
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(SafeHandle? directory, string path, out InodeData? data)
+    {
+        return _inner.TryCreateMinimalInodeDataFromPath(directory, path, out data);
+    }
+
     /// <inheritdoc />
     public InodeData CompleteInodeDataFromPath(string path, ref InodeData data, IArchiveStore archiveStore)
     {
         return _inner.CompleteInodeDataFromPath(path, ref data, archiveStore);
     }
 
+    /// <inheritdoc />
+    public InodeData CompleteInodeDataFromPath(
+        SafeHandle? directory,
+        string path,
+        ref InodeData data,
+        IArchiveStore archiveStore
+    )
+    {
+        return _inner.CompleteInodeDataFromPath(directory, path, ref data, archiveStore);
+    }
+
     /// <inheritdoc />
     public string[] ListDirectory(string path)
     {
         return _inner.ListDirectory(path);
     }
 
+    /// <inheritdoc />
+    public DirectoryListingEntry[] ReadDirectory(string path)
+    {
+        return _inner.ReadDirectory(path);
+    }
+
+    /// <inheritdoc />
+    public IDirectoryScanner? OpenDirectoryScanner(
+        IReadOnlyList<string> roots,
+        IReadOnlyList<string> excluded,
+        int threads
+    )
+    {
+        return _inner.OpenDirectoryScanner(roots, excluded, threads);
+    }
+
+    /// <inheritdoc />
+    public long[]? GetDataOffsets(string directory, IReadOnlyList<string> names)
+    {
+        return _inner.GetDataOffsets(directory, names);
+    }
+
+    /// <inheritdoc />
+    public int PreloadOwnerNames()
+    {
+        return _inner.PreloadOwnerNames();
+    }
+
     /// <inheritdoc />
     public JsonNode Canonicalizefilename(string path)
     {
@@ -0,0 +1,197 @@
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Runtime.InteropServices.Marshalling;
+using OsCallsCommon;
+using static OsCallsCommon.ValXfer;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     Shared loader for libOsCallsLinuxShim.so. Loads the library once, fetches the versioned dispatch table
+///     through <c>linux_shim_get_api</c> (see ShimApi.h) and exposes it as <see cref="Api" />. All Linux wrappers
+///     call native code through these unmanaged function pointers rather than per-export delegates or P/Invokes.
+/// </summary>
+internal static unsafe class LinuxShim
+{
+    internal const string NativeLibraryName = "libOsCallsLinuxShim.so";
+    private const string CommonLibraryName = "libOsCallsCommonShim.so";
+
+    // Must match LINUX_SHIM_API_VERSION in ShimApi.h.
+    private const uint ApiVersion = 1;
+
+    /// <summary>The shim's entry points. Initialized once; never changes afterwards.</summary>
+    internal static readonly ApiTable Api;
+
+    static LinuxShim()
+    {
+        var handle = Load();
+        var getApi = (delegate* unmanaged[Cdecl]<uint, ApiTable*, int>)
+            NativeLibrary.GetExport(handle, "linux_shim_get_api");
+        var table = new ApiTable { Size = (uint)sizeof(ApiTable) };
+        var rc = getApi(ApiVersion, &table);
+        if (rc != 0)
+            ThrowNativeError(rc, NativeLibraryName, "linux_shim_get_api");
+        if (table.Size < sizeof(ApiTable))
+            throw new EntryPointNotFoundException(
+                $"{NativeLibraryName} provides a {table.Size} byte API table, {sizeof(ApiTable)} bytes required"
+            );
+        Api = table;
+        // Iterate cursors through the shim's own GetNextValue copy
+        UseCursorFunctions(table.GetNextValue, table.ReleaseHandle, table.FreeBuffer);
+    }
+
+    private static nint Load()
+    {
+        var full = FindNativeLibraryPath(NativeLibraryName);
+        if (Logger!.IsNativeDebugEnabled())
+            Logger!.ConWrite($"LinuxShim: loading {NativeLibraryName} from {full ?? "(default search path)"}");
+        if (full is null)
+            return NativeLibrary.Load(NativeLibraryName, typeof(LinuxShim).Assembly, null);
+
+        // Preload libOsCallsCommonShim.so so the shim's dependency resolves to the same copy that
+        // OsCallsCommon binds to: either next to the shim, or in the sibling project's build output.
+        var libDir = Path.GetDirectoryName(full)!;
+        var projectRoot = new DirectoryInfo(libDir).Parent?.Parent?.Parent?.Parent;
+        string?[] candidates =
+        [
+            Path.Combine(libDir, CommonLibraryName),
+            projectRoot is null
+                ? null
+                : Path.Combine(projectRoot.FullName, "OsCallsCommonShim", "bin", "Debug", "net8.0", CommonLibraryName),
+            projectRoot is null
+                ? null
+                : Path.Combine(projectRoot.FullName, "OsCallsCommonShim", "bin", "Release", "net8.0", CommonLibraryName),
+        ];
+        foreach (var dep in candidates)
+            if (dep is not null && File.Exists(dep) && NativeLibrary.TryLoad(dep, out _))
+                break;
+
+        return NativeLibrary.Load(full);
+    }
+
+    private static string? FindNativeLibraryPath(string fileName)
+    {
+        // First check if library was copied to same directory (e.g., during tests)
+        var baseDir = AppContext.BaseDirectory;
+        var colocated = Path.Combine(baseDir, fileName);
+        if (File.Exists(colocated))
+            return colocated;
+
+        // Start at base directory (bin/<config>/net8.0[/RID]) and walk up looking for project folder.
+        var dir = new DirectoryInfo(baseDir);
+        for (var i = 0; i < 8 && dir is not null; i++)
+        {
+            var candidateDebug = Path.Combine(dir.FullName, "OsCallsLinuxShim", "bin", "Debug", "net8.0", fileName);
+            if (File.Exists(candidateDebug))
+                return candidateDebug;
+            var candidateRelease = Path.Combine(dir.FullName, "OsCallsLinuxShim", "bin", "Release", "net8.0", fileName);
+            if (File.Exists(candidateRelease))
+                return candidateRelease;
+            dir = dir.Parent;
+        }
+
+        return null;
+    }
+
+    /// <summary>
+    ///     Managed mirror of <c>OsCalls::LinuxShimApi</c>. Field order must match ShimApi.h exactly; new entries
+    ///     are appended at the end.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct ApiTable
+    {
+        public uint Size;
+        public uint Version;
+
+        public delegate* unmanaged[Cdecl]<ValueT*, byte> GetNextValue;
+        public delegate* unmanaged[Cdecl]<ValueT*, void> ReleaseHandle;
+        public delegate* unmanaged[Cdecl]<void*, void> FreeBuffer;
+
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> LStat;
+        public delegate* unmanaged[Cdecl]<byte*, FileSystem.StatRecord*, int> LStatInto;
+        public delegate* unmanaged[Cdecl]<byte*, byte**, long*, int> LStatPacked;
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> ReadLink;
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> CanonicalizeFileName;
+
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> LListXattr;
+        public delegate* unmanaged[Cdecl]<byte*, byte**, long*, int> LListXattrPacked;
+        public delegate* unmanaged[Cdecl]<byte*, byte*, ValueT*> LGetXattr;
+
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> AclGetFileAccess;
+        public delegate* unmanaged[Cdecl]<byte*, ValueT*> AclGetFileDefault;
+
+        public delegate* unmanaged[Cdecl]<long, ValueT*> GetPwUid;
+        public delegate* unmanaged[Cdecl]<long, byte**, long*, int> GetPwUidPacked;
+        public delegate* unmanaged[Cdecl]<long, ValueT*> GetGrGid;
+        public delegate* unmanaged[Cdecl]<long, byte**, long*, int> GetGrGidPacked;
+
+        public delegate* unmanaged[Cdecl]<byte*, byte**, long*, int> AclGetFileAccessPacked;
+        public delegate* unmanaged[Cdecl]<byte*, byte**, long*, int> AclGetFileDefaultPacked;
+
+        public delegate* unmanaged[Cdecl]<byte*, long*, int> OpenDirHandle;
+        public delegate* unmanaged[Cdecl]<long, byte*, long*, int> OpenAtHandle;
+        public delegate* unmanaged[Cdecl]<long, byte*, int*, int> OpenAtRead;
+        public delegate* unmanaged[Cdecl]<long, int> CloseHandle;
+        public delegate* unmanaged[Cdecl]<long, byte*, FileSystem.StatRecord*, int> FStatAtInto;
+        public delegate* unmanaged[Cdecl]<long, byte*, ValueT*> ReadLinkAt;
+        public delegate* unmanaged[Cdecl]<long, byte**, long*, int> FListXattrPacked;
+        public delegate* unmanaged[Cdecl]<long, byte*, ValueT*> FGetXattr;
+        public delegate* unmanaged[Cdecl]<long, byte*, byte**, long*, int> AclGetAccessAtPacked;
+        public delegate* unmanaged[Cdecl]<long, byte*, byte**, long*, int> AclGetDefaultAtPacked;
+
+        public delegate* unmanaged[Cdecl]<byte*, uint, byte**, long*, int> ReadDirectory;
+
+        public delegate* unmanaged[Cdecl]<byte**, int, byte**, int, int, long, long*, int> WalkOpen;
+        public delegate* unmanaged[Cdecl]<long, byte*, long, long, byte**, long*, int> WalkTake;
+        public delegate* unmanaged[Cdecl]<long, int> WalkClose;
+
+        public delegate* unmanaged[Cdecl]<long, byte*, uint, uint, FileSystem.StatxRecord*, int> Statx;
+        public delegate* unmanaged[Cdecl]<long, int*, int> FsIsRemote;
+
+        public delegate* unmanaged[Cdecl]<long, byte**, int, long*, int> DataOffsets;
+
+        public delegate* unmanaged[Cdecl]<long, byte*, uint, byte**, long*, int> CollectInode;
+
+        public delegate* unmanaged[Cdecl]<byte*, uint, byte**, long*, int> LGetXattrsPacked;
+        public delegate* unmanaged[Cdecl]<long, uint, byte**, long*, int> FGetXattrsPacked;
+
+        public delegate* unmanaged[Cdecl]<long, byte**, long*, int> UserNamePacked;
+        public delegate* unmanaged[Cdecl]<long, byte**, long*, int> GroupNamePacked;
+        public delegate* unmanaged[Cdecl]<long, long, int> NameCacheConfigure;
+        public delegate* unmanaged[Cdecl]<int*, int*, int> NameCachePreload;
+
+        public delegate* unmanaged[Cdecl]<long, byte*, int*, int> OpenContent;
+        public delegate* unmanaged[Cdecl]<int, byte*, long, long, uint, long*, long*, int> ReadContent;
+
+        public delegate* unmanaged[Cdecl]<int, long, long*, long*, int> FindData;
+    }
+
+    /// <summary>
+    ///     NUL-terminated UTF-8 copy of a string argument, built in a caller-provided stack buffer when it fits
+    ///     (as the LibraryImport generator does) and in native memory otherwise. Dispose after the native call.
+    /// </summary>
+    internal ref struct Utf8Arg
+    {
+        /// <summary>Stack buffer size covering typical paths.</summary>
+        public const int BufferSize = 0x100;
+
+        private Utf8StringMarshaller.ManagedToUnmanagedIn _marshaller;
+
+        public Utf8Arg(string value, Span<byte> buffer)
+        {
+            _marshaller = new Utf8StringMarshaller.ManagedToUnmanagedIn();
+            _marshaller.FromManaged(value, buffer);
+        }
+
+        public byte* Pointer
+        {
+            [MethodImpl(MethodImplOptions.AggressiveInlining)]
+            get => _marshaller.ToUnmanaged();
+        }
+
+        public void Dispose()
+        {
+            _marshaller.Free();
+        }
+    }
+}
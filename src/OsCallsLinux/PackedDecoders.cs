@@ -0,0 +1,409 @@
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using OsCallsCommon;
+using static OsCallsLinux.FileSystem;
+
+namespace OsCallsLinux;
+
+/// <summary>
+///     Entry of the passwd database as decoded from <c>linux_getpwuid_packed</c>. Fields the native record did not
+///     provide stay null (for an unknown uid, all of them).
+/// </summary>
+public sealed class PasswdEntry
+{
+    /// <summary>Login name (pw_name).</summary>
+    public string? Name { get; set; }
+
+    /// <summary>Password field (pw_passwd).</summary>
+    public string? Passwd { get; set; }
+
+    /// <summary>User ID (pw_uid).</summary>
+    public long? Uid { get; set; }
+
+    /// <summary>Primary group ID (pw_gid).</summary>
+    public long? Gid { get; set; }
+
+    /// <summary>User information (pw_gecos).</summary>
+    public string? Gecos { get; set; }
+
+    /// <summary>Home directory (pw_dir).</summary>
+    public string? Dir { get; set; }
+
+    /// <summary>Login shell (pw_shell).</summary>
+    public string? Shell { get; set; }
+}
+
+/// <summary>
+///     Entry of the group database as decoded from <c>linux_getgrgid_packed</c>. For an unknown gid
+///     <see cref="Name" /> and <see cref="Gid" /> stay null.
+/// </summary>
+public sealed class GroupEntry
+{
+    /// <summary>Group name (gr_name).</summary>
+    public string? Name { get; set; }
+
+    /// <summary>Group ID (gr_gid).</summary>
+    public long? Gid { get; set; }
+
+    /// <summary>Member login names (gr_mem).</summary>
+    public List<string> Members { get; } = [];
+}
+
+/// <summary>
+///     Entry of a directory listing as decoded from <c>linux_read_directory</c>.
+/// </summary>
+public sealed class DirectoryEntry
+{
+    /// <summary>Entry name within the directory (d_name).</summary>
+    public string Name { get; set; } = "";
+
+    /// <summary>File type reported by the directory (d_type, DT_*); 0 (DT_UNKNOWN) if not reported.</summary>
+    public byte Type { get; set; }
+
+    /// <summary>Inode number reported by the directory (d_ino).</summary>
+    public long Ino { get; set; }
+
+    /// <summary>lstat of the entry, if it was requested and succeeded.</summary>
+    public StatRecord? Stat { get; set; }
+
+    /// <summary>errno of the entry's stat if it failed (e.g. ENOENT for an entry removed meanwhile), else 0.</summary>
+    public int StatError { get; set; }
+}
+
+/// <summary>
+///     Metadata of one inode as decoded from <c>linux_collect_inode</c>. Parts that were not requested or are not
+///     available stay null (or empty).
+/// </summary>
+public sealed class InodeMetadata
+{
+    /// <summary>lstat of the entry.</summary>
+    public StatRecord Stat { get; set; }
+
+    /// <summary>Owner user name, null for an unknown uid.</summary>
+    public string? UserName { get; set; }
+
+    /// <summary>Owner group name, null for an unknown gid.</summary>
+    public string? GroupName { get; set; }
+
+    /// <summary>Access ACL in short text form.</summary>
+    public string? AccessAcl { get; set; }
+
+    /// <summary>
+    ///     The entry has no extended ACL: <see cref="AccessAcl" /> was derived from the mode bits without
+    ///     calling libacl.
+    /// </summary>
+    public bool AccessAclFromMode { get; set; }
+
+    /// <summary>Default ACL of a directory in short text form.</summary>
+    public string? DefaultAcl { get; set; }
+
+    /// <summary>Raw system.posix_acl_access value (<see cref="FileSystem.CollectParts.AclRaw" />).</summary>
+    public byte[]? AccessAclRaw { get; set; }
+
+    /// <summary>Raw system.posix_acl_default value of a directory.</summary>
+    public byte[]? DefaultAclRaw { get; set; }
+
+    /// <summary>Extended attributes with their exact values, in listing order.</summary>
+    public List<KeyValuePair<string, byte[]>> Xattrs { get; } = [];
+
+    /// <summary>Raw bytes of a symlink's target.</summary>
+    public byte[]? LinkTarget { get; set; }
+
+    /// <summary>errno of reading a symlink's target if it failed, else 0.</summary>
+    public int LinkError { get; set; }
+}
+
+/// <summary>
+///     Decoders for the packed schemas of the Linux shim. Field ids mirror the constexpr tables in Schemas.h;
+///     unknown ids are skipped so an older managed layer can read a newer shim.
+/// </summary>
+public static class PackedDecoders
+{
+    // Schema ids, see OsCalls::Schema in Schemas.h.
+    private const uint SchemaStat = 1;
+    private const uint SchemaPasswd = 2;
+    private const uint SchemaGroup = 3;
+    private const uint SchemaXattrList = 4;
+    private const uint SchemaAclText = 5;
+    private const uint SchemaDirEntries = 6;
+    private const uint SchemaInodeMetadata = 7;
+    private const uint SchemaXattrValues = 8;
+
+    /// <summary>Decodes schema Stat into a <see cref="StatRecord" />.</summary>
+    public static StatRecord DecodeStat(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaStat);
+        var record = default(StatRecord);
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    record.Dev = reader.ReadInt64();
+                    break;
+                case 2:
+                    record.Ino = reader.ReadInt64();
+                    break;
+                case 3:
+                    record.Mode = reader.ReadInt64();
+                    break;
+                case 15:
+                    record.NLink = reader.ReadInt64();
+                    break;
+                case 16:
+                    record.Uid = reader.ReadInt64();
+                    break;
+                case 17:
+                    record.Gid = reader.ReadInt64();
+                    break;
+                case 18:
+                    record.RDev = reader.ReadInt64();
+                    break;
+                case 19:
+                    record.Size = reader.ReadInt64();
+                    break;
+                case 20:
+                    record.ATim = reader.ReadTimeSpec();
+                    break;
+                case 21:
+                    record.MTim = reader.ReadTimeSpec();
+                    break;
+                case 22:
+                    record.CTim = reader.ReadTimeSpec();
+                    break;
+                case 23:
+                    record.BlkSize = reader.ReadInt64();
+                    break;
+                case 24:
+                    record.Blocks = reader.ReadInt64();
+                    break;
+                default:
+                    // 4-14 are the S_IS* flags, which are derived from Mode on this side.
+                    reader.Skip(wire);
+                    break;
+            }
+
+        return record;
+    }
+
+    /// <summary>Decodes schema Passwd into a <see cref="PasswdEntry" />.</summary>
+    public static PasswdEntry DecodePasswd(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaPasswd);
+        var entry = new PasswdEntry();
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    entry.Name = reader.ReadString();
+                    break;
+                case 2:
+                    entry.Passwd = reader.ReadString();
+                    break;
+                case 3:
+                    entry.Uid = reader.ReadInt64();
+                    break;
+                case 4:
+                    entry.Gid = reader.ReadInt64();
+                    break;
+                case 5:
+                    entry.Gecos = reader.ReadString();
+                    break;
+                case 6:
+                    entry.Dir = reader.ReadString();
+                    break;
+                case 7:
+                    entry.Shell = reader.ReadString();
+                    break;
+                default:
+                    reader.Skip(wire);
+                    break;
+            }
+
+        return entry;
+    }
+
+    /// <summary>Decodes schema Group into a <see cref="GroupEntry" />.</summary>
+    public static GroupEntry DecodeGroup(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaGroup);
+        var entry = new GroupEntry();
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    entry.Name = reader.ReadString();
+                    break;
+                case 2:
+                    entry.Gid = reader.ReadInt64();
+                    break;
+                case 3:
+                    entry.Members.Add(reader.ReadString());
+                    break;
+                default:
+                    reader.Skip(wire);
+                    break;
+            }
+
+        return entry;
+    }
+
+    /// <summary>Decodes schema XattrList into the attribute names, in listing order.</summary>
+    public static string[] DecodeXattrList(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaXattrList);
+        var names = new List<string>();
+        while (reader.TryReadField(out var id, out var wire))
+            if (id == 1)
+                names.Add(reader.ReadString());
+            else
+                reader.Skip(wire);
+        return [.. names];
+    }
+
+    /// <summary>Decodes schema AclText into the ACL short text (empty if the field is absent).</summary>
+    public static string DecodeAclText(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaAclText);
+        var text = "";
+        while (reader.TryReadField(out var id, out var wire))
+            if (id == 1)
+                text = reader.ReadString();
+            else
+                reader.Skip(wire);
+        return text;
+    }
+
+    /// <summary>
+    ///     Decodes schema DirEntries into the entries, in encoded order. Field 1 (the name) starts each entry;
+    ///     the stat, when present, is the raw native StatRecord.
+    /// </summary>
+    public static List<DirectoryEntry> DecodeDirectory(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaDirEntries);
+        var entries = new List<DirectoryEntry>();
+        DirectoryEntry? entry = null;
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    entry = new DirectoryEntry { Name = reader.ReadString() };
+                    entries.Add(entry);
+                    break;
+                case 2 when entry is not null:
+                    entry.Type = (byte)reader.ReadInt64();
+                    break;
+                case 3 when entry is not null:
+                    entry.Ino = reader.ReadInt64();
+                    break;
+                case 4 when entry is not null:
+                    var bytes = reader.ReadBytes();
+                    if (bytes.Length != Unsafe.SizeOf<StatRecord>())
+                        throw new InvalidDataException($"Stat record of {bytes.Length} bytes in directory listing");
+                    entry.Stat = MemoryMarshal.Read<StatRecord>(bytes);
+                    break;
+                case 5 when entry is not null:
+                    entry.StatError = (int)reader.ReadInt64();
+                    break;
+                default:
+                    reader.Skip(wire);
+                    break;
+            }
+
+        return entries;
+    }
+
+    /// <summary>
+    ///     Decodes schema InodeMetadata. Field 6 (an xattr name) is followed by field 7, its value. For field 10
+    ///     (no extended ACL) the access ACL text is derived from the mode bits, as libacl would.
+    /// </summary>
+    public static InodeMetadata DecodeInodeMetadata(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaInodeMetadata);
+        var metadata = new InodeMetadata();
+        string? xattrName = null;
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    var bytes = reader.ReadBytes();
+                    if (bytes.Length != Unsafe.SizeOf<StatRecord>())
+                        throw new InvalidDataException($"Stat record of {bytes.Length} bytes in inode metadata");
+                    metadata.Stat = MemoryMarshal.Read<StatRecord>(bytes);
+                    break;
+                case 2:
+                    metadata.UserName = reader.ReadString();
+                    break;
+                case 3:
+                    metadata.GroupName = reader.ReadString();
+                    break;
+                case 4:
+                    metadata.AccessAcl = reader.ReadString();
+                    break;
+                case 5:
+                    metadata.DefaultAcl = reader.ReadString();
+                    break;
+                case 6:
+                    xattrName = reader.ReadString();
+                    break;
+                case 7 when xattrName is not null:
+                    metadata.Xattrs.Add(new KeyValuePair<string, byte[]>(xattrName, reader.ReadBytes().ToArray()));
+                    xattrName = null;
+                    break;
+                case 8:
+                    metadata.LinkTarget = reader.ReadBytes().ToArray();
+                    break;
+                case 9:
+                    metadata.LinkError = (int)reader.ReadInt64();
+                    break;
+                case 10:
+                    metadata.AccessAclFromMode = reader.ReadBoolean();
+                    break;
+                case 11:
+                    metadata.AccessAclRaw = reader.ReadBytes().ToArray();
+                    break;
+                case 12:
+                    metadata.DefaultAclRaw = reader.ReadBytes().ToArray();
+                    break;
+                default:
+                    reader.Skip(wire);
+                    break;
+            }
+
+        if (metadata.AccessAclFromMode)
+            metadata.AccessAcl ??= Acl.MinimalText(metadata.Stat.Mode);
+        return metadata;
+    }
+
+    /// <summary>
+    ///     Decodes schema XattrValues into name/value pairs, in listing order. Field 1 (a name) is followed by
+    ///     field 2, its value.
+    /// </summary>
+    public static List<KeyValuePair<string, byte[]>> DecodeXattrValues(ref PackedReader reader)
+    {
+        ExpectSchema(ref reader, SchemaXattrValues);
+        var xattrs = new List<KeyValuePair<string, byte[]>>();
+        string? name = null;
+        while (reader.TryReadField(out var id, out var wire))
+            switch (id)
+            {
+                case 1:
+                    name = reader.ReadString();
+                    break;
+                case 2 when name is not null:
+                    xattrs.Add(new KeyValuePair<string, byte[]>(name, reader.ReadBytes().ToArray()));
+                    name = null;
+                    break;
+                default:
+                    reader.Skip(wire);
+                    break;
+            }
+
+        return xattrs;
+    }
+
+    private static void ExpectSchema(ref PackedReader reader, uint schema)
+    {
+        if (reader.Schema != schema)
+            throw new InvalidDataException($"Packed buffer has schema {reader.Schema}, expected {schema}");
+    }
+}
@@ -1,5 +1,3 @@
-using System.Runtime.CompilerServices;
-using System.Runtime.InteropServices;
 using System.Text.Json.Nodes;
 using OsCallsCommon;
 using static OsCallsCommon.ValXfer;
@@ -10,51 +8,8 @@ namespace OsCallsLinux;
 ///     Access to system user/group databases via native libc calls (getpwuid/getgrgid).
 ///     Returned values are mapped into JSON using the <see cref="ValXfer" /> bridge.
 /// </summary>
-public static unsafe partial class UserGroupDatabase
+public static unsafe class UserGroupDatabase
 {
-    private const string NativeLibraryName = "libOsCallsLinuxShim.so";
-
-    private static readonly ShimPwUidDelegate? _linux_getpwuid;
-    private static readonly ShimGrGidDelegate? _linux_getgrgid;
-
-    static UserGroupDatabase()
-    {
-        try
-        {
-            var baseDir = AppContext.BaseDirectory;
-            var candidateDebug = Path.Combine(baseDir, "OsCallsLinuxShim", "bin", "Debug", "net8.0", NativeLibraryName);
-            var candidateRelease = Path.Combine(
-                baseDir,
-                "OsCallsLinuxShim",
-                "bin",
-                "Release",
-                "net8.0",
-                NativeLibraryName
-            );
-            var full =
-                File.Exists(candidateDebug) ? candidateDebug
-                : File.Exists(candidateRelease) ? candidateRelease
-                : null;
-            if (!string.IsNullOrWhiteSpace(full))
-            {
-                var handle = NativeLibrary.Load(full);
-                if (NativeLibrary.TryGetExport(handle, "linux_getpwuid", out var ptr))
-                    _linux_getpwuid = Marshal.GetDelegateForFunctionPointer<ShimPwUidDelegate>(ptr);
-                if (NativeLibrary.TryGetExport(handle, "linux_getgrgid", out ptr))
-                    _linux_getgrgid = Marshal.GetDelegateForFunctionPointer<ShimGrGidDelegate>(ptr);
-            }
-        }
-        catch { }
-    }
-
-    [LibraryImport(NativeLibraryName)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValueT* getpwuid(long uid);
-
-    [LibraryImport(NativeLibraryName)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValueT* getgrgid(long gid);
-
     /// <summary>
     ///     Retrieves passwd database entry for a user id.
     /// </summary>
@@ -70,13 +25,7 @@ public static unsafe partial class UserGroupDatabase
     /// </summary>
     public static JsonNode LinuxGetPwUid(long uid)
     {
-        if (_linux_getpwuid is not null)
-        {
-            var ptr = _linux_getpwuid(uid);
-            return ToNode((ValueT*)ptr, $"user {uid}", "linux_getpwuid");
-        }
-
-        return ToNode(getpwuid(uid), $"user {uid}", nameof(getpwuid));
+        return ToNode(LinuxShim.Api.GetPwUid(uid), $"user {uid}", "linux_getpwuid");
     }
 
     /// <summary>
@@ -94,18 +43,90 @@ public static unsafe partial class UserGroupDatabase
     /// </summary>
     public static JsonNode LinuxGetGrGid(long gid)
     {
-        if (_linux_getgrgid is not null)
-        {
-            var ptr = _linux_getgrgid(gid);
-            return ToNode((ValueT*)ptr, $"group {gid}", "linux_getgrgid");
-        }
+        return ToNode(LinuxShim.Api.GetGrGid(gid), $"group {gid}", "linux_getgrgid");
+    }
 
-        return ToNode(getgrgid(gid), $"group {gid}", nameof(getgrgid));
+    /// <summary>
+    ///     Retrieves a passwd entry through the packed transport, without building JSON.
+    /// </summary>
+    /// <param name="uid">Numeric user id.</param>
+    /// <returns>The decoded entry; all fields are null if the uid is unknown.</returns>
+    public static PasswdEntry LinuxGetPwUidPacked(long uid)
+    {
+        byte* data = null;
+        long length = 0;
+        var rc = LinuxShim.Api.GetPwUidPacked(uid, &data, &length);
+        return DecodePacked(rc, data, length, $"user {uid}", "linux_getpwuid_packed", PackedDecoders.DecodePasswd);
     }
 
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    private delegate IntPtr ShimPwUidDelegate(long uid);
+    /// <summary>
+    ///     Retrieves a group entry through the packed transport, without building JSON.
+    /// </summary>
+    /// <param name="gid">Numeric group id.</param>
+    /// <returns>The decoded entry; name and gid are null if the gid is unknown.</returns>
+    public static GroupEntry LinuxGetGrGidPacked(long gid)
+    {
+        byte* data = null;
+        long length = 0;
+        var rc = LinuxShim.Api.GetGrGidPacked(gid, &data, &length);
+        return DecodePacked(rc, data, length, $"group {gid}", "linux_getgrgid_packed", PackedDecoders.DecodeGroup);
+    }
 
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    private delegate IntPtr ShimGrGidDelegate(long gid);
+    /// <summary>
+    ///     User name of a uid through the shim's name cache (see <see cref="ConfigureNameCache" />); only the name
+    ///     is read out of the passwd entry.
+    /// </summary>
+    /// <param name="uid">Numeric user id.</param>
+    /// <returns>The login name, or null if the uid is unknown.</returns>
+    public static string? LinuxGetUserName(long uid)
+    {
+        byte* data = null;
+        long length = 0;
+        var rc = LinuxShim.Api.UserNamePacked(uid, &data, &length);
+        return DecodePacked(rc, data, length, $"user {uid}", "linux_user_name_packed", PackedDecoders.DecodePasswd)
+            .Name;
+    }
+
+    /// <summary>
+    ///     Group name of a gid through the shim's name cache; the member list (gr_mem) is never transferred.
+    /// </summary>
+    /// <param name="gid">Numeric group id.</param>
+    /// <returns>The group name, or null if the gid is unknown.</returns>
+    public static string? LinuxGetGroupName(long gid)
+    {
+        byte* data = null;
+        long length = 0;
+        var rc = LinuxShim.Api.GroupNamePacked(gid, &data, &length);
+        return DecodePacked(rc, data, length, $"group {gid}", "linux_group_name_packed", PackedDecoders.DecodeGroup)
+            .Name;
+    }
+
+    /// <summary>
+    ///     Sets how long the name cache keeps names and unknown ids (zero: not at all) and empties it. The
+    ///     defaults are 10 minutes and 1 minute.
+    /// </summary>
+    /// <param name="ttl">Lifetime of a cached name.</param>
+    /// <param name="negativeTtl">Lifetime of a cached "unknown id".</param>
+    /// <returns>0 on success, otherwise the native errno value (EINVAL for a negative time).</returns>
+    public static int ConfigureNameCache(TimeSpan ttl, TimeSpan negativeTtl)
+    {
+        return LinuxShim.Api.NameCacheConfigure((long)ttl.TotalSeconds, (long)negativeTtl.TotalSeconds);
+    }
+
+    /// <summary>
+    ///     Fills the name cache with every user and group the system enumerates (getpwent / getgrent), so the
+    ///     backup itself does not wait on the directory service for them.
+    /// </summary>
+    /// <param name="users">Receives the number of users cached.</param>
+    /// <param name="groups">Receives the number of groups cached.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int PreloadNameCache(out int users, out int groups)
+    {
+        int u = 0,
+            g = 0;
+        var rc = LinuxShim.Api.NameCachePreload(&u, &g);
+        users = u;
+        groups = g;
+        return rc;
+    }
 }
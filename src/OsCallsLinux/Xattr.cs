@@ -1,5 +1,3 @@
-using System.Runtime.CompilerServices;
-using System.Runtime.InteropServices;
 using System.Text.Json.Nodes;
 using OsCallsCommon;
 
@@ -9,33 +7,8 @@ namespace OsCallsLinux;
 ///     Wrapper for native extended attributes (xattr) reading functions.
 ///     Provides methods to list and read extended attributes from filesystem paths.
 /// </summary>
-public static unsafe partial class Xattr
+public static unsafe class Xattr
 {
-    private const string NativeLibraryName = "libOsCallsLinuxShim.so";
-
-    private static readonly ShimListXattrDelegate? _linux_llistxattr;
-    private static readonly ShimGetXattrDelegate? _linux_lgetxattr;
-
-    static Xattr()
-    {
-        try
-        {
-            var full = FindNative();
-            if (!string.IsNullOrWhiteSpace(full))
-            {
-                var handle = NativeLibrary.Load(full);
-                if (NativeLibrary.TryGetExport(handle, "linux_llistxattr", out var p))
-                    _linux_llistxattr = Marshal.GetDelegateForFunctionPointer<ShimListXattrDelegate>(p);
-                if (NativeLibrary.TryGetExport(handle, "linux_lgetxattr", out p))
-                    _linux_lgetxattr = Marshal.GetDelegateForFunctionPointer<ShimGetXattrDelegate>(p);
-            }
-        }
-        catch
-        {
-            // ignore - fallback to P/Invoke
-        }
-    }
-
     /// <summary>
     ///     Lists all extended attribute names for the specified path (not following symlinks).
     /// </summary>
@@ -51,13 +24,39 @@ public static unsafe partial class Xattr
     /// </summary>
     public static JsonNode LinuxListXattr(string path)
     {
-        if (_linux_llistxattr is not null)
-        {
-            var ptr = _linux_llistxattr(path);
-            return ValXfer.ToNode((ValXfer.ValueT*)ptr, path, "linux_llistxattr");
-        }
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return ValXfer.ToNode(LinuxShim.Api.LListXattr(arg.Pointer), path, "linux_llistxattr");
+    }
+
+    /// <summary>
+    ///     Lists extended attribute names (not following symlinks) through the packed transport, without
+    ///     building JSON.
+    /// </summary>
+    /// <param name="path">Filesystem path to read xattrs from.</param>
+    /// <returns>The attribute names, in listing order.</returns>
+    public static string[] LinuxListXattrPacked(string path)
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.LListXattrPacked(arg.Pointer, &data, &length);
+        return ValXfer.DecodePacked(rc, data, length, path, "linux_llistxattr_packed", PackedDecoders.DecodeXattrList);
+    }
 
-        return ValXfer.ToNode(llistxattr(path), path, nameof(llistxattr));
+    /// <summary>
+    ///     Non-throwing variant of <see cref="LinuxListXattrPacked" />: failures such as ENOTSUP (no xattr
+    ///     support) or ENOENT are returned as errno, nothing is logged or thrown.
+    /// </summary>
+    /// <param name="path">Filesystem path to read xattrs from.</param>
+    /// <param name="names">Receives the attribute names on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryListXattr(string path, out string[]? names)
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.LListXattrPacked(arg.Pointer, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeXattrList, out names);
     }
 
     /// <summary>
@@ -76,40 +75,152 @@ public static unsafe partial class Xattr
     /// </summary>
     public static JsonNode LinuxGetXattr(string path, string name)
     {
-        if (_linux_lgetxattr is not null)
+        return ValXfer.ToNode(LGetXattr(path, name), path, "linux_lgetxattr");
+    }
+
+    /// <summary>
+    ///     Reads an extended attribute (not following symlinks) and hands its exact bytes to
+    ///     <paramref name="func" /> as a span over the native buffer, with no string round trip.
+    ///     Binary values are passed through unmodified.
+    /// </summary>
+    /// <param name="path">Filesystem path to read xattr from.</param>
+    /// <param name="name">Name of the extended attribute to retrieve.</param>
+    /// <param name="func">Consumer of the value; the span is only valid during the call.</param>
+    /// <returns>The result of <paramref name="func" />.</returns>
+    public static TResult LinuxGetXattrBytes<TResult>(string path, string name, ValXfer.BytesFunc<TResult> func)
+    {
+        return ValXfer.WithBytes(LGetXattr(path, name), path, "linux_lgetxattr", func);
+    }
+
+    /// <summary>
+    ///     Non-throwing variant of <see cref="LinuxGetXattrBytes{TResult}" />: ENODATA (attribute removed since
+    ///     it was listed) and other failures are returned as errno, nothing is logged or thrown.
+    /// </summary>
+    /// <param name="path">Filesystem path to read xattr from.</param>
+    /// <param name="name">Name of the extended attribute to retrieve.</param>
+    /// <param name="func">Consumer of the value; the span is only valid during the call.</param>
+    /// <param name="result">Receives the result of <paramref name="func" />, or default on error.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetXattrBytes<TResult>(
+        string path,
+        string name,
+        ValXfer.BytesFunc<TResult> func,
+        out TResult? result
+    )
+    {
+        return ValXfer.TryWithBytes(LGetXattr(path, name), path, "linux_lgetxattr", func, out result);
+    }
+
+    /// <summary>
+    ///     Lists extended attribute names of an entry handle (<see cref="FileSystem.TryOpenAt" />) without
+    ///     raising errors; same result as <see cref="TryListXattr(string, out string[])" /> on its path.
+    /// </summary>
+    /// <param name="entry">O_PATH handle on the entry.</param>
+    /// <param name="names">Receives the attribute names on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryListXattr(FileSystemHandle entry, out string[]? names)
+    {
+        byte* data = null;
+        long length = 0;
+        using var handle = entry.Acquire();
+        var rc = LinuxShim.Api.FListXattrPacked(handle.Value, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeXattrList, out names);
+    }
+
+    /// <summary>
+    ///     Reads an extended attribute of an entry handle (<see cref="FileSystem.TryOpenAt" />) without raising
+    ///     errors; the handle counterpart of the path-based TryGetXattrBytes.
+    /// </summary>
+    /// <param name="entry">O_PATH handle on the entry.</param>
+    /// <param name="name">Name of the extended attribute to retrieve.</param>
+    /// <param name="func">Consumer of the value; the span is only valid during the call.</param>
+    /// <param name="result">Receives the result of <paramref name="func" />, or default on error.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetXattrBytes<TResult>(
+        FileSystemHandle entry,
+        string name,
+        ValXfer.BytesFunc<TResult> func,
+        out TResult? result
+    )
+    {
+        ValXfer.ValueT* value;
+        using (var handle = entry.Acquire())
         {
-            var ptr = _linux_lgetxattr(path, name);
-            return ValXfer.ToNode((ValXfer.ValueT*)ptr, path, "linux_lgetxattr");
+            using var nameArg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+            value = LinuxShim.Api.FGetXattr(handle.Value, nameArg.Pointer);
         }
 
-        return ValXfer.ToNode(lgetxattr(path, name), path, nameof(lgetxattr));
+        return ValXfer.TryWithBytes(value, name, "linux_fgetxattr", func, out result);
     }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValXfer.ValueT* llistxattr(string path);
+    /// <summary>
+    ///     Reads every extended attribute in <paramref name="namespaces" /> with its value (not following
+    ///     symlinks) in one native call, without raising errors. Attributes removed while reading are left out.
+    /// </summary>
+    /// <param name="path">Filesystem path to read xattrs from.</param>
+    /// <param name="namespaces">Namespaces to include.</param>
+    /// <param name="xattrs">Receives the name/value pairs in listing order on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetXattrValues(
+        string path,
+        XattrNamespaces namespaces,
+        out List<KeyValuePair<string, byte[]>>? xattrs
+    )
+    {
+        byte* data = null;
+        long length = 0;
+        using var arg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        var rc = LinuxShim.Api.LGetXattrsPacked(arg.Pointer, (uint)namespaces, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeXattrValues, out xattrs);
+    }
 
-    [LibraryImport(NativeLibraryName, StringMarshalling = StringMarshalling.Utf8)]
-    [UnmanagedCallConv(CallConvs = new[] { typeof(CallConvCdecl) })]
-    private static partial ValXfer.ValueT* lgetxattr(string path, string name);
+    /// <summary>
+    ///     Entry handle (<see cref="FileSystem.TryOpenAt" />) counterpart of
+    ///     <see cref="TryGetXattrValues(string, XattrNamespaces, out List{KeyValuePair{string, byte[]}})" />.
+    /// </summary>
+    /// <param name="entry">O_PATH handle on the entry.</param>
+    /// <param name="namespaces">Namespaces to include.</param>
+    /// <param name="xattrs">Receives the name/value pairs in listing order on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the native errno value.</returns>
+    public static int TryGetXattrValues(
+        FileSystemHandle entry,
+        XattrNamespaces namespaces,
+        out List<KeyValuePair<string, byte[]>>? xattrs
+    )
+    {
+        byte* data = null;
+        long length = 0;
+        using var handle = entry.Acquire();
+        var rc = LinuxShim.Api.FGetXattrsPacked(handle.Value, (uint)namespaces, &data, &length);
+        return ValXfer.TryDecodePacked(rc, data, length, PackedDecoders.DecodeXattrValues, out xattrs);
+    }
 
-    private static string? FindNative()
+    private static ValXfer.ValueT* LGetXattr(string path, string name)
     {
-        var baseDir = AppContext.BaseDirectory;
-        var candidateDebug = Path.Combine(baseDir, "OsCallsLinuxShim", "bin", "Debug", "net8.0", NativeLibraryName);
-        var candidateRelease = Path.Combine(baseDir, "OsCallsLinuxShim", "bin", "Release", "net8.0", NativeLibraryName);
-        if (File.Exists(candidateDebug))
-            return candidateDebug;
-        if (File.Exists(candidateRelease))
-            return candidateRelease;
-        return null;
+        using var pathArg = new LinuxShim.Utf8Arg(path, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        using var nameArg = new LinuxShim.Utf8Arg(name, stackalloc byte[LinuxShim.Utf8Arg.BufferSize]);
+        return LinuxShim.Api.LGetXattr(pathArg.Pointer, nameArg.Pointer);
     }
 
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    private delegate IntPtr ShimListXattrDelegate([MarshalAs(UnmanagedType.LPUTF8Str)] string path);
+    /// <summary>
+    ///     XATTR_NS_* namespaces of <c>linux_*getxattrs_packed</c> (Xattr.h).
+    /// </summary>
+    [Flags]
+    public enum XattrNamespaces : uint
+    {
+        /// <summary>user.</summary>
+        User = 0x1,
+
+        /// <summary>trusted. (readable by privileged processes only)</summary>
+        Trusted = 0x2,
 
-    private delegate IntPtr ShimGetXattrDelegate(
-        [MarshalAs(UnmanagedType.LPUTF8Str)] string path,
-        [MarshalAs(UnmanagedType.LPUTF8Str)] string name
-    );
+        /// <summary>security. (SELinux labels, capabilities)</summary>
+        Security = 0x4,
+
+        /// <summary>system. (including system.posix_acl_*)</summary>
+        System = 0x8,
+
+        /// <summary>Every namespace.</summary>
+        All = 0xF,
+    }
 }
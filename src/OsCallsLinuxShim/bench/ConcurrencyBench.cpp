@@ -0,0 +1,265 @@
+/**
+ * @file ConcurrencyBench.cpp
+ * @brief Stress test and benchmark: every shim export from N threads at once.
+ *
+ * Each thread repeats a round that calls every entry of the dispatch table
+ * (ShimApi.h) on one shared fixture: a file with user xattrs, a symlink whose
+ * target is longer than the initial readlink buffer, and a directory. Results
+ * are checked against the values seen on the main thread, so a data race that
+ * corrupts a result is reported as a mismatch. Thread 0 also reconfigures and
+ * preloads the name cache now and then, racing its clear against lookups.
+ * Walkers are opened per thread, as documented for handle-based objects.
+ *
+ * For every thread count from the limit down to 1 (halving) it runs for the
+ * given time and prints calls per second in total and per thread. The largest
+ * count goes first and its threads are released together, so state the shim
+ * grows lazily on first use is raced while it is still cold.
+ *
+ * Build with -DOSCALLS_BUILD_BENCH=ON (add -DOSCALLS_TSAN=ON to instrument
+ * the shims and this program with ThreadSanitizer) and run
+ * OsCallsConcurrencyBench [seconds] [max-threads] [path/to/libOsCallsLinuxShim.so].
+ * The exit status is 1 if any result mismatched.
+ */
+#include "Platform.h"
+// Platform.h must come first
+#include "ShimApi.h"
+#include "Xattr.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace OsCalls;
+
+namespace {
+using GetApiFn = int(uint32_t, LinuxShimApi *);
+
+LinuxShimApi api{};
+
+struct Fixture {
+    std::string dir;
+    std::string file;
+    std::string link;
+    std::string target;
+    StatRecord  fileStat;
+    int64_t     dirDev;
+    int64_t     dirIno;
+};
+
+std::atomic<int64_t> mismatches{0};
+
+void check(bool ok, const char *what) {
+    if (!ok && mismatches.fetch_add(1) < 10)
+        std::fprintf(stderr, "mismatch: %s\n", what);
+}
+
+// Walks a cursor to its end; returns the number of values
+int64_t drain(ValueT *value) {
+    int64_t steps = 0;
+    while (api.get_next_value(value)) {
+        ++steps;
+        if (value->Type == TypeT::IsComplex)
+            steps += drain(value->Complex);
+    }
+    api.release_handle(value);
+    return steps;
+}
+
+// Calls a packed export and frees its buffer; returns the errno value
+template <typename Fn> int packed(Fn &&fn) {
+    uint8_t *data = nullptr;
+    int64_t  length = 0;
+    auto     rc = fn(&data, &length);
+    if (rc == 0)
+        api.free_buffer(data);
+    return rc;
+}
+
+// One pass over the table; returns the number of calls made
+int64_t run_round(const Fixture &fx, int thread, int64_t n) {
+    int64_t     calls = 0;
+    const char *file = fx.file.c_str();
+    const char *link = fx.link.c_str();
+    auto        count = [&calls](auto) { ++calls; };
+
+    StatRecord st;
+    count(api.lstat_into(file, &st));
+    check(st.st_ino == fx.fileStat.st_ino, "lstat_into");
+    count(drain(api.lstat(file)));
+    count(packed([&](auto d, auto l) { return api.lstat_packed(file, d, l); }));
+    auto target = api.readlink(link);
+    check(api.get_next_value(target) && std::strlen(target->String) == fx.target.size(), "readlink");
+    count(drain(target));
+    count(drain(api.canonicalize_file_name(fx.dir.c_str())));
+
+    count(drain(api.llistxattr(file)));
+    count(packed([&](auto d, auto l) { return api.llistxattr_packed(file, d, l); }));
+    count(drain(api.lgetxattr(file, "user.bench0")));
+    count(packed([&](auto d, auto l) { return api.lgetxattrs_packed(file, XATTR_NS_ALL, d, l); }));
+    count(drain(api.acl_get_file_access(file)));
+    count(drain(api.acl_get_file_default(fx.dir.c_str())));
+    count(packed([&](auto d, auto l) { return api.acl_get_file_access_packed(file, d, l); }));
+    count(packed([&](auto d, auto l) { return api.acl_get_file_default_packed(fx.dir.c_str(), d, l); }));
+
+    auto uid = fx.fileStat.st_uid;
+    auto gid = fx.fileStat.st_gid;
+    count(drain(api.getpwuid(uid)));
+    count(drain(api.getgrgid(gid)));
+    count(packed([&](auto d, auto l) { return api.getpwuid_packed(uid, d, l); }));
+    count(packed([&](auto d, auto l) { return api.getgrgid_packed(gid, d, l); }));
+    count(packed([&](auto d, auto l) { return api.user_name_packed(uid, d, l); }));
+    count(packed([&](auto d, auto l) { return api.group_name_packed(gid, d, l); }));
+    count(packed([&](auto d, auto l) { return api.user_name_packed(0x7ffffff0 - n % 64, d, l); }));
+
+    int64_t dir = -1, entry = -1;
+    int32_t fd = -1, remote = 0;
+    check(api.opendir_handle(fx.dir.c_str(), &dir) == 0, "opendir_handle");
+    check(api.openat_handle(dir, "file", &entry) == 0, "openat_handle");
+    check(api.openat_read(dir, "file", &fd) == 0, "openat_read");
+    calls += 3;
+    count(api.fstatat_into(dir, "file", &st));
+    check(st.st_ino == fx.fileStat.st_ino, "fstatat_into");
+    count(drain(api.readlinkat(dir, "link")));
+    count(packed([&](auto d, auto l) { return api.flistxattr_packed(entry, d, l); }));
+    count(drain(api.fgetxattr(entry, "user.bench0")));
+    count(packed([&](auto d, auto l) { return api.fgetxattrs_packed(entry, XATTR_NS_USER, d, l); }));
+    count(packed([&](auto d, auto l) { return api.acl_get_access_at_packed(dir, "file", d, l); }));
+    count(packed([&](auto d, auto l) { return api.acl_get_default_at_packed(dir, ".", d, l); }));
+    StatxRecord stx;
+    count(api.statx(dir, "file", AT_STATX_SYNC_AS_STAT, STATX_BASIC_STATS, &stx));
+    check(stx.stx_ino == fx.fileStat.st_ino, "statx");
+    count(api.fs_is_remote(dir, &remote));
+    const char *names[] = {"file", "link"};
+    int64_t     offsets[2];
+    count(api.data_offsets(dir, names, 2, offsets));
+    count(packed([&](auto d, auto l) {
+        return api.collect_inode(dir, "file", COLLECT_OWNER | COLLECT_ACL | COLLECT_XATTRS, d, l);
+    }));
+    count(packed([&](auto d, auto l) { return api.collect_inode(dir, "link", COLLECT_LINK, d, l); }));
+    count(packed([&](auto d, auto l) { return api.read_directory(fx.dir.c_str(), READ_DIRECTORY_STAT, d, l); }));
+    if (fd >= 0)
+        ::close(fd);
+    int32_t content = -1;
+    if (api.open_content(dir, "file", &content) == 0) {
+        uint8_t buffer[64];
+        int64_t owned = 0, got = 0;
+        count(api.read_content(content, buffer, sizeof buffer, 0, CONTENT_DROP_BEHIND, &owned, &got));
+        check(got == 7 && std::memcmp(buffer, "content", 7) == 0, "read_content");
+        ::close(content);
+    }
+    ++calls;
+    count(api.close_handle(entry));
+    count(api.close_handle(dir));
+
+    if (n % 16 == 0) {
+        const char *roots[] = {fx.dir.c_str()};
+        int64_t     walker = 0;
+        if (api.walk_open(roots, 1, nullptr, 0, 1, 0, &walker) == 0) {
+            count(packed([&](auto d, auto l) {
+                return api.walk_take(walker, fx.dir.c_str(), fx.dirDev, fx.dirIno, d, l);
+            }));
+            count(api.walk_close(walker));
+        }
+        ++calls;
+    }
+    if (thread == 0 && n % 64 == 0) {
+        int32_t users = 0, groups = 0;
+        count(api.name_cache_configure(600, 60));
+        if (n % 1024 == 0)
+            count(api.name_cache_preload(&users, &groups));
+    }
+    return calls;
+}
+
+bool make_fixture(Fixture &fx) {
+    char path[] = "/tmp/oscalls-concurrency-XXXXXX";
+    if (mkdtemp(path) == nullptr)
+        return false;
+    fx.dir = path;
+    fx.file = fx.dir + "/file";
+    fx.link = fx.dir + "/link";
+    fx.target = std::string(3 * 1024, 't');
+    int fd = ::open(fx.file.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 || ::write(fd, "content", 7) != 7 || ::symlink(fx.target.c_str(), fx.link.c_str()) != 0)
+        return false;
+    ::close(fd);
+    for (int i = 0; i < 8; ++i)
+        ::lsetxattr(fx.file.c_str(), ("user.bench" + std::to_string(i)).c_str(), "value", 5, 0);
+    struct stat dirStat;
+    if (api.lstat_into(fx.file.c_str(), &fx.fileStat) != 0 || ::stat(path, &dirStat) != 0)
+        return false;
+    fx.dirDev = int64_t(dirStat.st_dev);
+    fx.dirIno = int64_t(dirStat.st_ino);
+    return true;
+}
+
+void remove_fixture(const Fixture &fx) {
+    ::unlink(fx.file.c_str());
+    ::unlink(fx.link.c_str());
+    ::rmdir(fx.dir.c_str());
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    int    maxThreads = argc > 2 ? std::atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    auto   lib = dlopen(argc > 3 ? argv[3] : "libOsCallsLinuxShim.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+        std::fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    auto getApi = reinterpret_cast<GetApiFn *>(dlsym(lib, "linux_shim_get_api"));
+    api.size = sizeof api;
+    if (getApi == nullptr || getApi(LINUX_SHIM_API_VERSION, &api) != 0 || api.size != sizeof api) {
+        std::fprintf(stderr, "linux_shim_get_api failed or table too short\n");
+        return 1;
+    }
+
+    Fixture fx;
+    if (!make_fixture(fx)) {
+        std::perror("fixture");
+        return 1;
+    }
+
+    for (int threads = maxThreads; threads > 0; threads /= 2) {
+        std::atomic<bool>        go{false};
+        std::atomic<bool>        stop{false};
+        std::atomic<int64_t>     total{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back([&, t] {
+                while (!go.load())
+                    std::this_thread::yield();
+                int64_t calls = 0;
+                for (int64_t n = 0; !stop.load(std::memory_order_relaxed); ++n)
+                    calls += run_round(fx, t, n);
+                total += calls;
+            });
+        auto start = std::chrono::steady_clock::now();
+        go = true;
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto &w : workers)
+            w.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto                          rate = double(total.load()) / elapsed.count();
+        std::printf("%3d threads %12.0f calls/s   %10.0f calls/s per thread\n", threads, rate, rate / threads);
+    }
+
+    remove_fixture(fx);
+    if (mismatches.load() != 0) {
+        std::printf("%lld mismatching results\n", static_cast<long long>(mismatches.load()));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file PackedBench.cpp
+ * @brief Micro-benchmark: ValueT cursor transport vs. packed transport.
+ *
+ * Measures the native cost of producing a complete result through each
+ * transport, the way the managed side consumes it: the cursor is walked with
+ * GetNextValue (recursing into nested cursors) and released, the packed
+ * buffer is produced and freed. Managed decoding cost is not included; with
+ * the cursor transport each step below is additionally one P/Invoke. The test
+ * OsCallsLinuxTests.PackedAndCursorTransportsAreTimedOnTheSameLookups times
+ * ValXfer.ToNode against DecodePacked end to end.
+ *
+ * Cases: lstat of a regular file, llistxattr of a file with many attributes
+ * (skipped if the filesystem has no user xattrs), getpwuid and getgrgid
+ * lookups through the exports (the user and group of the process, or the gid
+ * given), and a synthetic group with a large gr_mem list encoded straight
+ * from kGroupFields, the writer sized as linux_getgrgid_packed sizes it.
+ * The local database seldom has a group that large; pass the gid of one to
+ * time the real lookup.
+ *
+ * The Linux shim is loaded with dlopen(RTLD_LOCAL), as the .NET runtime does:
+ * linked directly, its legacy unprefixed exports (lstat, llistxattr, ...)
+ * would interpose the libc functions they wrap.
+ *
+ * Build with -DOSCALLS_BUILD_BENCH=ON and run
+ * OsCallsPackedBench [iterations] [path/to/libOsCallsLinuxShim.so] [gid].
+ */
+#include "Platform.h"
+// Platform.h must come first
+#include "Schemas.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <string>
+#include <sys/xattr.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace OsCalls;
+
+namespace {
+using CursorFn = ValueT *(const char *);
+using PackedFn = int(const char *, uint8_t **, int64_t *);
+using IdCursorFn = ValueT *(int64_t);
+using IdPackedFn = int(int64_t, uint8_t **, int64_t *);
+
+template <typename Fn> Fn *symbol(void *lib, const char *name) {
+    auto sym = reinterpret_cast<Fn *>(dlsym(lib, name));
+    if (sym == nullptr) {
+        std::fprintf(stderr, "missing export %s\n", name);
+        std::exit(1);
+    }
+    return sym;
+}
+
+// Walks a cursor the way ValXfer.ToNode does and counts the values seen.
+int64_t drain(ValueT *value) {
+    int64_t steps = 0;
+    while (GetNextValue(value)) {
+        ++steps;
+        if (value->Type == TypeT::IsComplex)
+            steps += drain(value->Complex);
+    }
+    ReleaseHandle(value);
+    return steps;
+}
+
+template <typename Fn> double time_ns(long iterations, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+        fn();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / double(iterations);
+}
+
+void report(const char *name, double cursorNs, double packedNs, int64_t steps, int64_t bytes) {
+    std::printf("%-24s cursor %10.0f ns (%lld steps)   packed %10.0f ns (%lld bytes)   %.2fx\n", name, cursorNs,
+                static_cast<long long>(steps), packedNs, static_cast<long long>(bytes), cursorNs / packedNs);
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 100000;
+    auto lib = dlopen(argc > 2 ? argv[2] : "libOsCallsLinuxShim.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+        std::fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    auto linux_lstat = symbol<CursorFn>(lib, "linux_lstat");
+    auto linux_lstat_packed = symbol<PackedFn>(lib, "linux_lstat_packed");
+    auto linux_llistxattr = symbol<CursorFn>(lib, "linux_llistxattr");
+    auto linux_llistxattr_packed = symbol<PackedFn>(lib, "linux_llistxattr_packed");
+    auto linux_getpwuid = symbol<IdCursorFn>(lib, "linux_getpwuid");
+    auto linux_getpwuid_packed = symbol<IdPackedFn>(lib, "linux_getpwuid_packed");
+    auto linux_getgrgid = symbol<IdCursorFn>(lib, "linux_getgrgid");
+    auto linux_getgrgid_packed = symbol<IdPackedFn>(lib, "linux_getgrgid_packed");
+
+    char path[] = "/tmp/oscalls-bench-XXXXXX";
+    int  fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    int64_t steps = 0;
+    int64_t bytes = 0;
+    auto    cursor = time_ns(iterations, [&] { steps = drain(linux_lstat(path)); });
+    auto    packed = time_ns(iterations, [&] {
+        uint8_t *data = nullptr;
+        linux_lstat_packed(path, &data, &bytes);
+        FreeBuffer(data);
+    });
+    report("lstat", cursor, packed, steps, bytes);
+
+    bool haveXattrs = true;
+    for (int i = 0; i < 64 && haveXattrs; ++i) {
+        auto name = "user.bench_attribute_" + std::to_string(i);
+        haveXattrs = lsetxattr(path, name.c_str(), "v", 1, 0) == 0;
+    }
+    if (haveXattrs) {
+        cursor = time_ns(iterations / 10, [&] { steps = drain(linux_llistxattr(path)); });
+        packed = time_ns(iterations / 10, [&] {
+            uint8_t *data = nullptr;
+            linux_llistxattr_packed(path, &data, &bytes);
+            FreeBuffer(data);
+        });
+        report("llistxattr (64 names)", cursor, packed, steps, bytes);
+    } else {
+        std::printf("%-24s skipped: no user xattr support on %s\n", "llistxattr", path);
+    }
+    unlink(path);
+
+    // Real lookups: both transports include the NSS query
+    auto lookup = [&](const char *name, IdCursorFn *cursorFn, IdPackedFn *packedFn, int64_t id) {
+        cursor = time_ns(iterations / 10, [&] { steps = drain(cursorFn(id)); });
+        packed = time_ns(iterations / 10, [&] {
+            uint8_t *data = nullptr;
+            packedFn(id, &data, &bytes);
+            FreeBuffer(data);
+        });
+        report(name, cursor, packed, steps, bytes);
+    };
+    lookup("getpwuid", linux_getpwuid, linux_getpwuid_packed, getuid());
+    lookup("getgrgid", linux_getgrgid, linux_getgrgid_packed, argc > 3 ? std::atoll(argv[3]) : getgid());
+
+    // Synthetic group so the result does not depend on the local group database
+    std::vector<std::string> names;
+    std::vector<char *>      members;
+    for (int i = 0; i < 10000; ++i)
+        names.push_back("member" + std::to_string(i));
+    for (auto &n : names)
+        members.push_back(n.data());
+    members.push_back(nullptr);
+    char  groupName[] = "benchgroup";
+    group gr{};
+    gr.gr_name = groupName;
+    gr.gr_gid = 4242;
+    gr.gr_mem = members.data();
+    // What getgrgid_r would need for it, by which linux_getgrgid_packed sizes its writer
+    auto bufsz = sizeof groupName + sizeof(char *);
+    for (auto &n : names)
+        bufsz += n.size() + 1 + sizeof(char *);
+
+    cursor = time_ns(iterations / 1000 + 1, [&] {
+        auto v = NewHandle(handle_table<kGroupFields>, nullptr, &gr, nullptr);
+        v->Type = TypeT::IsOk;
+        steps = drain(v);
+    });
+    packed = time_ns(iterations / 1000 + 1, [&] {
+        PackedWriter w(uint32_t(Schema::Group), bufsz + 64);
+        encode_table<kGroupFields>(w, gr);
+        FreeBuffer(w.release(&bytes));
+    });
+    report("synthetic group (10000)", cursor, packed, steps, bytes);
+    return 0;
+}
@@ -9,8 +9,19 @@
 #define ACL_H
 
 #include "ValXfer.h"
+#include <cstdint>
+#include <sys/acl.h>
 
 namespace OsCalls {
+/**
+ * @brief ACL of @p path in short text form (TEXT_ABBREVIATE), following
+ * symlinks like acl_get_file.
+ * @param type ACL_TYPE_ACCESS or ACL_TYPE_DEFAULT.
+ * @param en Receives 0 or the errno value.
+ * @return The text, to be freed with acl_free; nullptr on failure.
+ */
+char *acl_text(const char *path, acl_type_t type, int *en);
+
 /**
  * @name ACL operations
  * Functions exported with C linkage for consumption via P/Invoke.
@@ -33,6 +44,40 @@ ValueT *acl_get_file_default(const char *path);
 /* Linux-prefixed shim exports */
 ValueT *linux_acl_get_file_access(const char *path);
 ValueT *linux_acl_get_file_default(const char *path);
+
+/**
+ * @brief Read access ACL, packed encoding (schema AclText).
+ * @param path Filesystem path to read ACL from.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value (ENOTSUP without ACL
+ * support); no cursor is allocated on failure.
+ */
+int linux_acl_get_file_access_packed(const char *path, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Read default ACL, packed encoding (schema AclText).
+ * @param path Filesystem path (must be a directory).
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_acl_get_file_default_packed(const char *path, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Access ACL of an entry relative to a directory handle
+ * (linux_opendir_handle), packed encoding. Follows symlinks like
+ * acl_get_file.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_acl_get_access_at_packed(int64_t dir, const char *name, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Default ACL of an entry relative to a directory handle, packed
+ * encoding.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_acl_get_default_at_packed(int64_t dir, const char *name, uint8_t **data, int64_t *length);
 }
 
 /** @} */
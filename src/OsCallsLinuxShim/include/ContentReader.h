@@ -0,0 +1,83 @@
+/**
+ * @file ContentReader.h
+ * @brief File content reads that leave the page cache and atime alone.
+ *
+ * A backup reads every file once. Through ordinary reads that fills the page
+ * cache with data nobody will read again, evicting the hot pages of services
+ * running on the same machine, and updates every file's atime. Files are
+ * therefore opened with O_NOATIME (where the kernel allows it: owner or
+ * CAP_FOWNER) and POSIX_FADV_SEQUENTIAL, and linux_read_content drops the
+ * pages behind the read from the cache again, but only those the reader
+ * brought in: pages that were resident before (another process uses the
+ * file) stay. Residency is sampled with mincore before each read, over the
+ * range read and a lookahead (up to EOF); pages of the lookahead that were
+ * absent are the reader's own readahead and are dropped by the next read
+ * (the caller carries that boundary from one read to the next).
+ *
+ * linux_find_data reports where a sparse file has data, so holes need not be
+ * read (and hashed) as zeros.
+ */
+#ifndef CONTENTREADER_H
+#define CONTENTREADER_H
+
+#include <cstdint>
+
+namespace OsCalls {
+/** @brief linux_read_content flag: drop the pages this read brought into the page cache. */
+#define CONTENT_DROP_BEHIND 0x1u
+
+extern "C" {
+/**
+ * @brief Opens a regular file for reading its content.
+ *
+ * openat(O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC | O_NOATIME), retried
+ * without O_NOATIME when the kernel refuses it (EPERM: the caller neither
+ * owns the file nor has CAP_FOWNER), then POSIX_FADV_SEQUENTIAL.
+ *
+ * @param dir Directory handle (linux_opendir_handle), or AT_FDCWD (-100) for
+ *        a path.
+ * @param name Entry name within @p dir, or the path.
+ * @param fd Receives the file descriptor, owned by the caller.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_open_content(int64_t dir, const char *name, int32_t *fd);
+
+/**
+ * @brief pread(2) of up to @p length bytes at @p offset, until that many are
+ * read or end of file.
+ *
+ * @param fd Descriptor from linux_open_content (or any readable file).
+ * @param buffer Destination of at least @p length bytes.
+ * @param length Bytes wanted.
+ * @param offset File offset.
+ * @param flags Zero or CONTENT_DROP_BEHIND.
+ * @param owned In/out with CONTENT_DROP_BEHIND: cached pages below this
+ *        offset were brought in by this reader's earlier reads. Start at 0 and
+ *        pass the value back with the next read of the same file.
+ * @param count Receives the number of bytes read; 0 at end of file.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_read_content(int32_t fd, uint8_t *buffer, int64_t length, int64_t offset, uint32_t flags, int64_t *owned,
+                       int64_t *count);
+
+/**
+ * @brief Finds the first data extent at or after @p offset:
+ * lseek(SEEK_DATA) and from there lseek(SEEK_HOLE).
+ *
+ * Filesystems without hole tracking report all of the file as data. The
+ * extent is what the filesystem knew at the time of the call; the file may
+ * change afterwards.
+ *
+ * @param fd Open file.
+ * @param offset File offset to search from.
+ * @param start Receives the start of the data (offset if it lies in data).
+ * @param end Receives the end of the data: the next hole, or end of file.
+ * @return 0 on success, ENXIO if there is no data at or after @p offset
+ *         (only a hole up to end of file, or @p offset is past it),
+ *         otherwise the errno value.
+ */
+int linux_find_data(int32_t fd, int64_t offset, int64_t *start, int64_t *end);
+}
+}  // namespace OsCalls
+
+#endif  // CONTENTREADER_H
@@ -6,8 +6,81 @@
 #define FILESYSTEM_H
 
 #include "ValXfer.h"
+#include <cstdint>
+#include <sys/stat.h>
 
 namespace OsCalls {
+/**
+ * @brief Fixed-layout, blittable copy of the lstat(2) result.
+ *
+ * Filled in place by linux_lstat_into. Every field is an explicit 64-bit
+ * integer (or TimeSpec64) so the managed mirror
+ * (OsCallsLinux.FileSystem.StatRecord) has the same layout on every target
+ * and can be passed by pointer without marshalling.
+ */
+struct StatRecord {
+    int64_t    st_dev;
+    int64_t    st_ino;
+    int64_t    st_mode;
+    int64_t    st_nlink;
+    int64_t    st_uid;
+    int64_t    st_gid;
+    int64_t    st_rdev;
+    int64_t    st_size;
+    int64_t    st_blksize;
+    int64_t    st_blocks;
+    TimeSpec64 st_atim;
+    TimeSpec64 st_mtim;
+    TimeSpec64 st_ctim;
+};
+
+/**
+ * @brief Fixed-layout, blittable copy of the statx(2) result.
+ *
+ * Filled by linux_statx. Fields the kernel did not return (not requested, or
+ * not supported by the filesystem) are zero and absent from stx_mask.
+ * stx_dev and stx_rdev are combined with makedev() so they compare equal to
+ * st_dev and st_rdev. Mirrored by OsCallsLinux.FileSystem.StatxRecord.
+ */
+struct StatxRecord {
+    int64_t    stx_mask;             ///< STATX_* bits of the fields actually filled.
+    int64_t    stx_attributes;       ///< STATX_ATTR_* flags (compressed, immutable, nodump, ...).
+    int64_t    stx_attributes_mask;  ///< STATX_ATTR_* flags the filesystem supports.
+    int64_t    stx_dev;
+    int64_t    stx_ino;
+    int64_t    stx_mode;
+    int64_t    stx_nlink;
+    int64_t    stx_uid;
+    int64_t    stx_gid;
+    int64_t    stx_rdev;
+    int64_t    stx_size;
+    int64_t    stx_blksize;
+    int64_t    stx_blocks;
+    int64_t    stx_mnt_id;
+    TimeSpec64 stx_atime;
+    TimeSpec64 stx_btime;
+    TimeSpec64 stx_ctime;
+    TimeSpec64 stx_mtime;
+};
+
+/** @brief Copies a struct stat into the fixed-layout record shared with managed code. */
+void stat_to_record(const struct stat &st, StatRecord *out);
+
+/** @brief Callback of read_directory_fd for each subdirectory found. */
+using SubdirFn = void (*)(void *context, const char *name, const StatRecord &st);
+
+/**
+ * @brief Encodes every entry of the open directory @p fd as schema DirEntries.
+ *
+ * Implementation of linux_read_directory, shared with the parallel walker
+ * (Walker.h). With READ_DIRECTORY_STAT and a non-null @p onSubdir, the
+ * callback receives the name and stat of each entry that is a directory.
+ *
+ * @return 0 on success, otherwise the errno value.
+ */
+int read_directory_fd(int fd, uint32_t flags, uint8_t **data, int64_t *length, SubdirFn onSubdir = nullptr,
+                      void *context = nullptr);
+
 extern "C" {
 /**
  * @brief lstat(2) equivalent that does not follow symlinks.
@@ -50,6 +123,112 @@ ValueT *canonicalize_file_name(const char *path);
 ValueT *linux_lstat(const char *path);
 ValueT *linux_readlink(const char *path);
 ValueT *linux_canonicalize_file_name(const char *path);
+
+/**
+ * @brief lstat(2) into a caller-supplied StatRecord, without a cursor.
+ *
+ * Performs a single native call and no heap allocation. On failure the
+ * record is left untouched.
+ *
+ * @param path Input file system path.
+ * @param out Record to fill on success.
+ * @return 0 on success, otherwise the errno value reported by lstat(2).
+ */
+int linux_lstat_into(const char *path, StatRecord *out);
+
+/**
+ * @brief lstat(2) returning the packed encoding (schema Stat, see Schemas.h).
+ *
+ * @param path Input file system path.
+ * @param data Receives a pooled buffer on success; release with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_lstat_packed(const char *path, uint8_t **data, int64_t *length);
+
+/**
+ * @name Handle-relative (*at) calls
+ * An opaque int64_t handle pins a directory (or, from linux_openat_handle,
+ * a single entry) so that per-file calls take (handle, name) and the kernel
+ * does not re-walk the full path for every syscall.
+ * @{
+ */
+/** @brief Open a directory handle. @return 0 or errno. */
+int linux_opendir_handle(const char *path, int64_t *handle);
+/** @brief Open an O_PATH handle on an entry (no symlink follow). @return 0 or errno. */
+int linux_openat_handle(int64_t dir, const char *name, int64_t *handle);
+/** @brief Open an entry for reading; yields a caller-owned fd. @return 0 or errno. */
+int linux_openat_read(int64_t dir, const char *name, int32_t *fd);
+/** @brief Close a handle from linux_opendir_handle/linux_openat_handle. @return 0 or errno. */
+int linux_close_handle(int64_t handle);
+/** @brief fstatat(2), no symlink follow; empty name stats the handle. @return 0 or errno. */
+int linux_fstatat_into(int64_t dir, const char *name, StatRecord *out);
+/** @brief readlinkat(2); cursor like linux_readlink. */
+ValueT *linux_readlinkat(int64_t dir, const char *name);
+/** @} */
+
+/**
+ * @brief statx(2) of an entry, not following symlinks.
+ *
+ * Only the fields in @p mask are requested, and @p sync selects whether
+ * network filesystems may answer from cached attributes. Without statx in
+ * the kernel (ENOSYS) the entry is stat-ed with fstatat(2) and stx_mask is
+ * STATX_BASIC_STATS.
+ *
+ * @param dir Directory handle, or AT_FDCWD to resolve @p name as a path.
+ * @param name Entry name within @p dir; empty stats the handle itself.
+ * @param sync AT_STATX_SYNC_AS_STAT, AT_STATX_FORCE_SYNC or AT_STATX_DONT_SYNC.
+ * @param mask STATX_* fields wanted.
+ * @param out Record to fill on success.
+ * @return 0 on success, otherwise the errno value (EINVAL for another @p sync).
+ */
+int linux_statx(int64_t dir, const char *name, uint32_t sync, uint32_t mask, StatxRecord *out);
+
+/**
+ * @brief Reports whether a handle lives on a network filesystem (NFS, SMB/CIFS,
+ * Ceph, 9P, AFS), where a full stat may revalidate attributes with the server.
+ *
+ * @param handle Any handle from linux_opendir_handle or linux_openat_handle.
+ * @param remote Receives 1 for a network filesystem, otherwise 0.
+ * @return 0 on success, otherwise the errno value of fstatfs(2).
+ */
+int linux_fs_is_remote(int64_t handle, int32_t *remote);
+
+/**
+ * @brief Physical byte offset of the first data extent of each named file,
+ * from the FIEMAP ioctl, for reading files in on-disk order.
+ *
+ * @param dir Directory handle.
+ * @param names Entry names within @p dir (regular files).
+ * @param count Number of @p names.
+ * @param offsets Receives one offset per name; -1 when the file has no
+ *        mapped data yet, cannot be opened or the filesystem has no FIEMAP.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_data_offsets(int64_t dir, const char *const *names, int32_t count, int64_t *offsets);
+
+/** @brief linux_read_directory flag: fstatat every entry and include its StatRecord. */
+#define READ_DIRECTORY_STAT 0x1u
+
+/**
+ * @brief Lists a whole directory in one call (schema DirEntries, see Schemas.h).
+ *
+ * Reads the entries with getdents64(2) in large batches and, with
+ * READ_DIRECTORY_STAT, stats each one with fstatat(2) against the open
+ * directory, in inode number order. On network filesystems (see linux_fs_is_remote) entries are
+ * stat-ed with statx(2) instead, asking only for the fields of an inode
+ * record and accepting cached attributes (AT_STATX_DONT_SYNC), so atime,
+ * st_blksize and st_blocks may be zero. "." and ".." are skipped; entries
+ * come in directory order, or with READ_DIRECTORY_STAT in inode order.
+ *
+ * @param path Directory to list.
+ * @param flags Zero or READ_DIRECTORY_STAT.
+ * @param data Receives a pooled buffer on success; release with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno of opening or reading the
+ *         directory. Per-entry stat failures are reported in the records.
+ */
+int linux_read_directory(const char *path, uint32_t flags, uint8_t **data, int64_t *length);
 }
 }  // namespace OsCalls
 
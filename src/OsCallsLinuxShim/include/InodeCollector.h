@@ -0,0 +1,57 @@
+/**
+ * @file InodeCollector.h
+ * @brief All metadata of one inode in a single native call.
+ *
+ * Completing an inode record used to take a call per part: owner and group
+ * names, access and default ACL, the xattr listing and every value, and the
+ * link target, each resolving the path again and each a managed-to-native
+ * transition. linux_collect_inode opens the entry once (O_PATH, not
+ * following symlinks) and encodes everything into one packed buffer (schema
+ * InodeMetadata, see Schemas.h).
+ */
+#ifndef INODECOLLECTOR_H
+#define INODECOLLECTOR_H
+
+#include <cstdint>
+
+namespace OsCalls {
+/** @name linux_collect_inode flags */
+/** @{ */
+#define COLLECT_OWNER 0x1u            ///< User and group names of st_uid / st_gid.
+#define COLLECT_ACL 0x2u              ///< Access ACL, plus the default ACL of directories; not for symlinks.
+#define COLLECT_LINK 0x4u             ///< Target of a symlink, read with its exact st_size.
+#define COLLECT_ACL_RAW 0x8u          ///< With COLLECT_ACL: raw system.posix_acl_* values instead of text.
+#define COLLECT_XATTR_USER 0x10u      ///< Extended attributes in the user. namespace.
+#define COLLECT_XATTR_TRUSTED 0x20u   ///< ... trusted. (readable by privileged processes only).
+#define COLLECT_XATTR_SECURITY 0x40u  ///< ... security. (SELinux labels, capabilities).
+#define COLLECT_XATTR_SYSTEM 0x80u    ///< ... system. (including system.posix_acl_*).
+#define COLLECT_XATTRS 0xF0u          ///< Extended attributes of every namespace.
+/** @} */
+// COLLECT_XATTR_* are the XATTR_NS_* bits of Xattr.h shifted left by four.
+
+extern "C" {
+/**
+ * @brief Collects the metadata of one entry into a packed buffer.
+ *
+ * The stat record is always included. Parts the filesystem does not support
+ * or that vanish meanwhile (ENOTSUP, ENODATA) are left out; only a failure to
+ * open or stat the entry fails the call. Names of unknown ids are left out.
+ * ACLs are only read through libacl if the entry has their system.posix_acl_*
+ * xattr; otherwise the access ACL is reported as "just the mode bits". With
+ * COLLECT_ACL_RAW libacl is not used at all: the xattr values are returned
+ * as they are (struct posix_acl_xattr_header and entries, little endian, with
+ * numeric qualifiers), so no qualifier is resolved through NSS.
+ *
+ * @param dir Directory handle (linux_opendir_handle), or AT_FDCWD (-100) for
+ *        a path.
+ * @param name Entry name within @p dir, or the path.
+ * @param flags COLLECT_* parts wanted.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_collect_inode(int64_t dir, const char *name, uint32_t flags, uint8_t **data, int64_t *length);
+}
+}  // namespace OsCalls
+
+#endif  // INODECOLLECTOR_H
@@ -0,0 +1,166 @@
+/**
+ * @file Schemas.h
+ * @brief Field tables and packed schema ids for Linux shim results.
+ *
+ * Each table lists the fields of one result record in cursor order. The
+ * cursor handlers (handle_table) and the *_packed exports (encode_table) are
+ * both generated from these tables. Packed field ids are part of the wire
+ * protocol decoded by OsCallsLinux.PackedDecoders: never renumber or reuse
+ * an id, only append.
+ */
+#ifndef SCHEMAS_H
+#define SCHEMAS_H
+
+#include "FieldTable.h"
+#include <grp.h>
+#include <pwd.h>
+#include <sys/stat.h>
+
+// Safe wrappers for file type test macros (not all are available on all
+// platforms)
+#ifdef S_ISBLK
+#define SAFE_S_ISBLK(m) S_ISBLK(m)
+#else
+#define SAFE_S_ISBLK(m) false
+#endif
+
+#ifdef S_ISCHR
+#define SAFE_S_ISCHR(m) S_ISCHR(m)
+#else
+#define SAFE_S_ISCHR(m) false
+#endif
+
+#ifdef S_ISFIFO
+#define SAFE_S_ISFIFO(m) S_ISFIFO(m)
+#else
+#define SAFE_S_ISFIFO(m) false
+#endif
+
+#ifdef S_ISSOCK
+#define SAFE_S_ISSOCK(m) S_ISSOCK(m)
+#else
+#define SAFE_S_ISSOCK(m) false
+#endif
+
+#ifdef S_TYPEISMQ
+#define SAFE_S_TYPEISMQ(s) S_TYPEISMQ(s)
+#else
+#define SAFE_S_TYPEISMQ(s) ((void)(s), false)
+#endif
+
+#ifdef S_TYPEISSEM
+#define SAFE_S_TYPEISSEM(s) S_TYPEISSEM(s)
+#else
+#define SAFE_S_TYPEISSEM(s) ((void)(s), false)
+#endif
+
+#ifdef S_TYPEISSHM
+#define SAFE_S_TYPEISSHM(s) S_TYPEISSHM(s)
+#else
+#define SAFE_S_TYPEISSHM(s) ((void)(s), false)
+#endif
+
+#ifdef S_TYPEISTMO
+#define SAFE_S_TYPEISTMO(s) S_TYPEISTMO(s)
+#else
+#define SAFE_S_TYPEISTMO(s) ((void)(s), false)
+#endif
+
+namespace OsCalls {
+/**
+ * @brief Schema id written as the first varint of every packed buffer.
+ */
+enum class Schema : uint32_t {
+    Stat = 1,       ///< struct stat (kStatFields)
+    Passwd = 2,     ///< struct passwd (kPasswdFields)
+    Group = 3,      ///< struct group (kGroupFields)
+    XattrList = 4,  ///< field 1 repeated: attribute names
+    AclText = 5,    ///< field 1: ACL in short text form
+    /**
+     * Directory listing, one record per entry: field 1 name (starts a
+     * record), 2 d_type, 3 d_ino, then either 4 the raw StatRecord
+     * (FileSystem.h) or 5 the errno of its fstatat.
+     */
+    DirEntries = 6,
+    /**
+     * Metadata of one inode (linux_collect_inode): 1 the raw StatRecord,
+     * 2 user name, 3 group name, 4 access ACL text, 5 default ACL text,
+     * 6 xattr name (starts an attribute) and 7 its value, 8 symlink target
+     * or 9 the errno of reading it, 10 (instead of 4) the access ACL is just
+     * the mode bits (no system.posix_acl_access), 11 / 12 (instead of 4 / 5)
+     * the raw system.posix_acl_access / _default value.
+     */
+    InodeMetadata = 7,
+    /**
+     * Extended attributes with their values (linux_*getxattrs_packed):
+     * 1 name (starts an attribute), 2 its value as bytes.
+     */
+    XattrValues = 8,
+};
+
+/**
+ * @brief Convert a POSIX timespec to the fixed-width TimeSpec64.
+ */
+inline TimeSpec64 timespec_to_timespec64(const struct timespec &ts) {
+    TimeSpec64 result;
+    result.tv_sec = ts.tv_sec;
+    result.tv_nsec = ts.tv_nsec;
+    return result;
+}
+
+/** @brief lstat fields, in the order the cursor protocol has always used. */
+inline constexpr FieldDesc<struct stat> kStatFields[] = {
+    {1, "st_dev", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_dev; }},
+    {2, "st_ino", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_ino; }},
+    {3, "st_mode", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_mode; }},
+    {4, "S_ISBLK", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_ISBLK(s.st_mode); }},
+    {5, "S_ISCHR", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_ISCHR(s.st_mode); }},
+    {6, "S_ISDIR", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = S_ISDIR(s.st_mode); }},
+    {7, "S_ISFIFO", FieldKind::Boolean,
+     [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_ISFIFO(s.st_mode); }},
+    {8, "S_ISLNK", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = S_ISLNK(s.st_mode); }},
+    {9, "S_ISREG", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = S_ISREG(s.st_mode); }},
+    {10, "S_ISSOCK", FieldKind::Boolean,
+     [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_ISSOCK(s.st_mode); }},
+    {11, "S_TYPEISMQ", FieldKind::Boolean, [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_TYPEISMQ(&s); }},
+    {12, "S_TYPEISSEM", FieldKind::Boolean,
+     [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_TYPEISSEM(&s); }},
+    {13, "S_TYPEISSHM", FieldKind::Boolean,
+     [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_TYPEISSHM(&s); }},
+    {14, "S_TYPEISTMO", FieldKind::Boolean,
+     [](const struct stat &s, FieldValue &v) { v.boolean = SAFE_S_TYPEISTMO(&s); }},
+    {15, "st_nlink", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_nlink; }},
+    {16, "st_uid", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_uid; }},
+    {17, "st_gid", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_gid; }},
+    {18, "st_rdev", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_rdev; }},
+    {19, "st_size", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_size; }},
+    {20, "st_atim", FieldKind::TimeSpec,
+     [](const struct stat &s, FieldValue &v) { v.timespec = timespec_to_timespec64(s.st_atim); }},
+    {21, "st_mtim", FieldKind::TimeSpec,
+     [](const struct stat &s, FieldValue &v) { v.timespec = timespec_to_timespec64(s.st_mtim); }},
+    {22, "st_ctim", FieldKind::TimeSpec,
+     [](const struct stat &s, FieldValue &v) { v.timespec = timespec_to_timespec64(s.st_ctim); }},
+    {23, "st_blksize", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_blksize; }},
+    {24, "st_blocks", FieldKind::Number, [](const struct stat &s, FieldValue &v) { v.number = s.st_blocks; }},
+};
+
+/** @brief getpwuid fields. */
+inline constexpr FieldDesc<passwd> kPasswdFields[] = {
+    {1, "pw_name", FieldKind::String, [](const passwd &p, FieldValue &v) { v.string = p.pw_name; }},
+    {2, "pw_passwd", FieldKind::String, [](const passwd &p, FieldValue &v) { v.string = p.pw_passwd; }},
+    {3, "pw_uid", FieldKind::Number, [](const passwd &p, FieldValue &v) { v.number = p.pw_uid; }},
+    {4, "pw_gid", FieldKind::Number, [](const passwd &p, FieldValue &v) { v.number = p.pw_gid; }},
+    {5, "pw_gecos", FieldKind::String, [](const passwd &p, FieldValue &v) { v.string = p.pw_gecos; }},
+    {6, "pw_dir", FieldKind::String, [](const passwd &p, FieldValue &v) { v.string = p.pw_dir; }},
+    {7, "pw_shell", FieldKind::String, [](const passwd &p, FieldValue &v) { v.string = p.pw_shell; }},
+};
+
+/** @brief getgrgid fields; gr_mem is a nested list. */
+inline constexpr FieldDesc<group> kGroupFields[] = {
+    {1, "gr_name", FieldKind::String, [](const group &g, FieldValue &v) { v.string = g.gr_name; }},
+    {2, "gr_gid", FieldKind::Number, [](const group &g, FieldValue &v) { v.number = g.gr_gid; }},
+    {3, "gr_mem", FieldKind::StringList, [](const group &g, FieldValue &v) { v.list = g.gr_mem; }},
+};
+}  // namespace OsCalls
+
+#endif  // SCHEMAS_H
@@ -0,0 +1,173 @@
+/**
+ * @file ShimApi.h
+ * @brief Versioned dispatch table of all Linux shim entry points.
+ *
+ * Managed code binds the shim once at startup through linux_shim_get_api and
+ * then calls every native function through the returned pointers
+ * (`delegate* unmanaged` on the C# side), instead of resolving each export
+ * separately and invoking it through a marshalled delegate.
+ *
+ * Compatibility rules:
+ * - LINUX_SHIM_API_VERSION changes only for incompatible changes (a field
+ *   changes meaning or signature). Callers asking for another version fail.
+ * - New entry points are appended at the end. The caller passes the size of
+ *   its table in LinuxShimApi::size; the shim fills at most that many bytes
+ *   and reports how many it filled, so old callers keep working with newer
+ *   shims and new callers can detect entries an older shim does not provide.
+ *
+ * Thread safety: every entry point may be called from any number of threads
+ * at once. Scratch state (growing buffer size hints, xattr buffers) is per
+ * thread, shared caches are locked, and libacl's text conversion, which names
+ * qualifiers through the non-reentrant getpwuid / getgrgid, is serialized.
+ * An object behind a handle is the caller's to share: a walker may be taken
+ * from concurrently. bench/ConcurrencyBench.cpp calls every entry from N
+ * threads and is meant to be run under ThreadSanitizer (-DOSCALLS_TSAN=ON).
+ */
+#ifndef SHIMAPI_H
+#define SHIMAPI_H
+
+#include "ContentReader.h"
+#include "FileSystem.h"
+#include "InodeCollector.h"
+#include "Walker.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace OsCalls {
+/** @brief Current dispatch table version. */
+#define LINUX_SHIM_API_VERSION 1
+
+/**
+ * @brief Function pointers exported by the Linux shim, version 1.
+ *
+ * The layout is mirrored by OsCallsLinux.LinuxShim.Api in managed code.
+ */
+struct LinuxShimApi {
+    uint32_t size;     ///< In: size of the caller's table. Out: bytes filled by the shim.
+    uint32_t version;  ///< Out: LINUX_SHIM_API_VERSION.
+
+    /** @name Cursor protocol (GetNextValue is compiled into this shim) */
+    /** @{ */
+    bool (*get_next_value)(ValueT *value);
+    void (*release_handle)(ValueT *value);
+    void (*free_buffer)(void *buffer);
+    /** @} */
+
+    /** @name FileSystem.h */
+    /** @{ */
+    ValueT *(*lstat)(const char *path);
+    int (*lstat_into)(const char *path, StatRecord *out);
+    int (*lstat_packed)(const char *path, uint8_t **data, int64_t *length);
+    ValueT *(*readlink)(const char *path);
+    ValueT *(*canonicalize_file_name)(const char *path);
+    /** @} */
+
+    /** @name Xattr.h */
+    /** @{ */
+    ValueT *(*llistxattr)(const char *path);
+    int (*llistxattr_packed)(const char *path, uint8_t **data, int64_t *length);
+    ValueT *(*lgetxattr)(const char *path, const char *name);
+    /** @} */
+
+    /** @name Acl.h */
+    /** @{ */
+    ValueT *(*acl_get_file_access)(const char *path);
+    ValueT *(*acl_get_file_default)(const char *path);
+    /** @} */
+
+    /** @name UserGroupDatabase.h */
+    /** @{ */
+    ValueT *(*getpwuid)(int64_t uid);
+    int (*getpwuid_packed)(int64_t uid, uint8_t **data, int64_t *length);
+    ValueT *(*getgrgid)(int64_t gid);
+    int (*getgrgid_packed)(int64_t gid, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: errno-only ACL reads (Acl.h) */
+    /** @{ */
+    int (*acl_get_file_access_packed)(const char *path, uint8_t **data, int64_t *length);
+    int (*acl_get_file_default_packed)(const char *path, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: handle-relative (*at) calls */
+    /** @{ */
+    int (*opendir_handle)(const char *path, int64_t *handle);
+    int (*openat_handle)(int64_t dir, const char *name, int64_t *handle);
+    int (*openat_read)(int64_t dir, const char *name, int32_t *fd);
+    int (*close_handle)(int64_t handle);
+    int (*fstatat_into)(int64_t dir, const char *name, StatRecord *out);
+    ValueT *(*readlinkat)(int64_t dir, const char *name);
+    int (*flistxattr_packed)(int64_t handle, uint8_t **data, int64_t *length);
+    ValueT *(*fgetxattr)(int64_t handle, const char *name);
+    int (*acl_get_access_at_packed)(int64_t dir, const char *name, uint8_t **data, int64_t *length);
+    int (*acl_get_default_at_packed)(int64_t dir, const char *name, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: batched directory listing */
+    /** @{ */
+    int (*read_directory)(const char *path, uint32_t flags, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: parallel directory prefetch (Walker.h) */
+    /** @{ */
+    int (*walk_open)(const char *const *roots, int32_t rootCount, const char *const *excluded, int32_t excludedCount,
+                     int32_t threads, int64_t maxBuffered, int64_t *walker);
+    int (*walk_take)(int64_t walker, const char *path, int64_t dev, int64_t ino, uint8_t **data, int64_t *length);
+    int (*walk_close)(int64_t walker);
+    /** @} */
+
+    /** @name Appended: statx with field mask and sync mode */
+    /** @{ */
+    int (*statx)(int64_t dir, const char *name, uint32_t sync, uint32_t mask, StatxRecord *out);
+    int (*fs_is_remote)(int64_t handle, int32_t *remote);
+    /** @} */
+
+    /** @name Appended: disk-order scheduling */
+    /** @{ */
+    int (*data_offsets)(int64_t dir, const char *const *names, int32_t count, int64_t *offsets);
+    /** @} */
+
+    /** @name Appended: one-shot inode metadata (InodeCollector.h) */
+    /** @{ */
+    int (*collect_inode)(int64_t dir, const char *name, uint32_t flags, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: single-pass xattr values (Xattr.h) */
+    /** @{ */
+    int (*lgetxattrs_packed)(const char *path, uint32_t namespaces, uint8_t **data, int64_t *length);
+    int (*fgetxattrs_packed)(int64_t handle, uint32_t namespaces, uint8_t **data, int64_t *length);
+    /** @} */
+
+    /** @name Appended: cached name lookups (UserGroupDatabase.h) */
+    /** @{ */
+    int (*user_name_packed)(int64_t uid, uint8_t **data, int64_t *length);
+    int (*group_name_packed)(int64_t gid, uint8_t **data, int64_t *length);
+    int (*name_cache_configure)(int64_t ttl_seconds, int64_t negative_ttl_seconds);
+    int (*name_cache_preload)(int32_t *users, int32_t *groups);
+    /** @} */
+
+    /** @name Appended: page-cache-friendly content reads (ContentReader.h) */
+    /** @{ */
+    int (*open_content)(int64_t dir, const char *name, int32_t *fd);
+    int (*read_content)(int32_t fd, uint8_t *buffer, int64_t length, int64_t offset, uint32_t flags, int64_t *owned,
+                        int64_t *count);
+    /** @} */
+
+    /** @name Appended: sparse file extents (ContentReader.h) */
+    /** @{ */
+    int (*find_data)(int32_t fd, int64_t offset, int64_t *start, int64_t *end);
+    /** @} */
+};
+
+extern "C" {
+/**
+ * @brief Fill @p table with the shim's entry points.
+ * @param version Version the caller was built against (LINUX_SHIM_API_VERSION).
+ * @param table Caller-allocated table with LinuxShimApi::size set.
+ * @return 0 on success, ENOTSUP for an unknown version, EINVAL for a bad table.
+ */
+int linux_shim_get_api(uint32_t version, LinuxShimApi *table);
+}
+}  // namespace OsCalls
+
+#endif  // SHIMAPI_H
@@ -1,14 +1,44 @@
 /**
  * @file UserGroupDatabase.h
  * @brief Bindings for querying system user/group databases.
+ *
+ * Owner names are needed for every inode, and with sssd or LDAP each
+ * getpwuid_r / getgrgid_r may be a network round trip. The name lookups
+ * (user_name, group_name and their exports) therefore go through a
+ * thread-safe id -> name cache: found names are kept for 10 minutes, unknown
+ * ids for one (see linux_name_cache_configure), lookup errors not at all.
+ * They skip everything but the name, in particular the gr_mem list of large
+ * groups.
  */
 #ifndef USERGROUPDATABASE_H
 #define USERGROUPDATABASE_H
 
 #include "ValXfer.h"
 #include <cstdint>
+#include <grp.h>
+#include <pwd.h>
+#include <string>
 
 namespace OsCalls {
+/**
+ * @brief Looks up a passwd entry into one pooled block (getpwuid_r); an
+ * unknown uid yields a zeroed record with @p found false.
+ * @return The block (also on error, possibly nullptr); free with FreeBuffer.
+ */
+passwd *lookup_pwuid(int64_t uid, int *en, bool *found);
+
+/** @brief Group counterpart of lookup_pwuid (getgrgid_r). */
+group *lookup_grgid(int64_t gid, int *en, bool *found);
+
+/**
+ * @brief User name of @p uid through the name cache.
+ * @return Whether the uid is known; false with *en set on a lookup error.
+ */
+bool user_name(int64_t uid, std::string &name, int *en);
+
+/** @brief Group counterpart of user_name. */
+bool group_name(int64_t gid, std::string &name, int *en);
+
 extern "C" {
 /**
  * @brief Query passwd database by numeric UID.
@@ -27,6 +57,56 @@ ValueT *getgrgid(std::int64_t gid);
 /* Linux-prefixed shim exports */
 ValueT *linux_getpwuid(std::int64_t uid);
 ValueT *linux_getgrgid(std::int64_t gid);
+
+/**
+ * @brief Query passwd database by UID, packed encoding (schema Passwd, see Schemas.h).
+ * @param uid User ID to look up.
+ * @param data Receives a pooled buffer on success; release with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success (also for an unknown uid: no fields), otherwise errno.
+ */
+int linux_getpwuid_packed(std::int64_t uid, std::uint8_t **data, std::int64_t *length);
+
+/**
+ * @brief Query group database by GID, packed encoding (schema Group, see Schemas.h).
+ * @param gid Group ID to look up.
+ * @param data Receives a pooled buffer on success; release with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success (also for an unknown gid: no fields), otherwise errno.
+ */
+int linux_getgrgid_packed(std::int64_t gid, std::uint8_t **data, std::int64_t *length);
+
+/**
+ * @brief User name of a uid through the name cache, packed encoding (schema
+ * Passwd with only pw_name and pw_uid; no fields for an unknown uid).
+ * @return 0 on success, otherwise errno.
+ */
+int linux_user_name_packed(std::int64_t uid, std::uint8_t **data, std::int64_t *length);
+
+/**
+ * @brief Group name of a gid through the name cache, packed encoding (schema
+ * Group with only gr_name and gr_gid: gr_mem is never read out).
+ * @return 0 on success, otherwise errno.
+ */
+int linux_group_name_packed(std::int64_t gid, std::uint8_t **data, std::int64_t *length);
+
+/**
+ * @brief Sets how long names (@p ttl_seconds) and unknown ids
+ * (@p negative_ttl_seconds) are cached, 0 for not at all, and empties the
+ * cache.
+ * @return 0, or EINVAL for a negative time.
+ */
+int linux_name_cache_configure(std::int64_t ttl_seconds, std::int64_t negative_ttl_seconds);
+
+/**
+ * @brief Preloads the name cache with every user and group the system
+ * enumerates (getpwent / getgrent); directories with enumeration disabled
+ * contribute nothing, their ids are still looked up one by one.
+ * @param users Receives the number of users cached.
+ * @param groups Receives the number of groups cached.
+ * @return 0 on success, otherwise errno.
+ */
+int linux_name_cache_preload(std::int32_t *users, std::int32_t *groups);
 }
 }  // namespace OsCalls
 
@@ -0,0 +1,66 @@
+/**
+ * @file Walker.h
+ * @brief Parallel directory prefetcher for the backup traversal.
+ *
+ * A walker reads the directory trees below a set of roots on N worker
+ * threads, each listing (getdents64 plus fstatat of every entry, see
+ * linux_read_directory) one directory at a time and queueing the
+ * subdirectories it finds. Every worker owns a deque: it takes its own work
+ * from the front, so it proceeds breadth-first like the traversal, and an
+ * idle worker steals from the back of another worker's deque.
+ *
+ * The traversal itself stays sequential and deterministic. It pulls the
+ * listing of each directory it reaches with linux_walk_take, keyed by the
+ * directory's device and inode. A listing that is ready is handed over, one
+ * in progress is waited for, and one not started yet is read on the caller's
+ * thread. Finished listings that have not been taken are limited to a byte
+ * budget, so workers pause when the traversal falls behind.
+ *
+ * Only directories on the devices of the roots are prefetched, matching the
+ * traversal, which does not cross into other filesystems.
+ */
+#ifndef WALKER_H
+#define WALKER_H
+
+#include <cstdint>
+
+namespace OsCalls {
+extern "C" {
+/**
+ * @brief Starts prefetching the trees below @p roots.
+ *
+ * @param roots Directories to scan; non-directories are ignored.
+ * @param rootCount Number of @p roots.
+ * @param excluded Paths whose subtrees are not prefetched (e.g. the archive).
+ * @param excludedCount Number of @p excluded.
+ * @param threads Worker threads; 0 uses the number of online CPUs.
+ * @param maxBuffered Byte budget of listings not yet taken; 0 uses 256 MiB.
+ * @param walker Receives the walker; close it with linux_walk_close.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_walk_open(const char *const *roots, int32_t rootCount, const char *const *excluded, int32_t excludedCount,
+                    int32_t threads, int64_t maxBuffered, int64_t *walker);
+
+/**
+ * @brief Takes the listing of one directory, in the format of
+ * linux_read_directory with READ_DIRECTORY_STAT.
+ *
+ * @param walker Walker from linux_walk_open.
+ * @param path Path of the directory, used if it has not been prefetched.
+ * @param dev st_dev of the directory.
+ * @param ino st_ino of the directory.
+ * @param data Receives a pooled buffer on success; release with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value of reading @p path.
+ */
+int linux_walk_take(int64_t walker, const char *path, int64_t dev, int64_t ino, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Stops the workers and frees the walker with all untaken listings.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_walk_close(int64_t walker);
+}
+}  // namespace OsCalls
+
+#endif  // WALKER_H
@@ -4,13 +4,73 @@
  *
  * Exposes functions to list and read extended attributes from filesystem paths
  * without following symlinks (llistxattr and lgetxattr equivalents).
+ *
+ * Names and values are fetched into per-thread scratch buffers that only
+ * grow: a call normally costs one syscall, and the size query happens only
+ * when the kernel reports ERANGE. linux_*getxattrs_packed return every wanted
+ * name with its value in one buffer.
  */
 #ifndef XATTR_H
 #define XATTR_H
 
 #include "ValXfer.h"
+#include <cstdint>
+#include <sys/types.h>
 
 namespace OsCalls {
+class PackedWriter;
+
+/** @name Attribute namespaces (linux_*getxattrs_packed, put_xattr_values) */
+/** @{ */
+#define XATTR_NS_USER 0x1u      ///< user.
+#define XATTR_NS_TRUSTED 0x2u   ///< trusted. (readable by privileged processes only)
+#define XATTR_NS_SECURITY 0x4u  ///< security. (SELinux labels, capabilities)
+#define XATTR_NS_SYSTEM 0x8u    ///< system. (including system.posix_acl_*)
+#define XATTR_NS_ALL 0xFu       ///< Every namespace.
+/** @} */
+
+/**
+ * @brief flistxattr(2) that also works on O_PATH descriptors (through
+ * /proc/self/fd on kernels that reject them).
+ */
+ssize_t fd_listxattr(int fd, char *list, size_t size);
+
+/** @brief fgetxattr(2) that also works on O_PATH descriptors. */
+ssize_t fd_getxattr(int fd, const char *name, void *value, size_t size);
+
+/**
+ * @brief fd_listxattr into the calling thread's scratch buffer.
+ *
+ * @param names Receives the NUL-separated names; valid until the next
+ *        listing on this thread.
+ * @return The length of the listing, or -1 with errno set.
+ */
+ssize_t fd_listxattr_scratch(int fd, const char **names);
+
+/**
+ * @brief fd_getxattr into the calling thread's scratch buffer.
+ *
+ * @param value Receives the value; valid until the next read on this thread.
+ * @return The length of the value, or -1 with errno set.
+ */
+ssize_t fd_getxattr_scratch(int fd, const char *name, const char **value);
+
+/** @brief Whether a listing of @p size bytes contains @p name. */
+bool xattr_list_contains(const char *names, ssize_t size, const char *name);
+
+/**
+ * @brief Writes every attribute of @p fd in @p namespaces as a @p nameId
+ * string followed by a @p valueId bytes field.
+ *
+ * Attributes removed since the listing or unreadable are skipped.
+ * @return 0, or the errno value of the listing (ENOMEM when out of memory).
+ */
+int put_xattr_values(PackedWriter &w, int fd, uint32_t namespaces, uint32_t nameId, uint32_t valueId);
+
+/** @brief put_xattr_values for a listing already made (fd_listxattr_scratch). */
+int put_xattr_values(PackedWriter &w, int fd, const char *names, ssize_t size, uint32_t namespaces, uint32_t nameId,
+                     uint32_t valueId);
+
 /**
  * @name Extended attribute operations
  * Functions exported with C linkage for consumption via P/Invoke.
@@ -35,6 +95,41 @@ ValueT *lgetxattr(const char *path, const char *name);
 /* Linux-prefixed shim exports */
 ValueT *linux_llistxattr(const char *path);
 ValueT *linux_lgetxattr(const char *path, const char *name);
+
+/**
+ * @brief List extended attribute names into a packed buffer (schema XattrList).
+ * @param path Filesystem path to read xattrs from.
+ * @param data Receives the buffer; free it with FreeBuffer.
+ * @param length Receives the encoded length.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_llistxattr_packed(const char *path, uint8_t **data, int64_t *length);
+
+/**
+ * @brief List extended attribute names of a handle (linux_openat_handle),
+ * packed encoding.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_flistxattr_packed(int64_t handle, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Get an extended attribute of a handle (linux_openat_handle).
+ * @return ValueT cursor with the value as bytes or error.
+ */
+ValueT *linux_fgetxattr(int64_t handle, const char *name);
+
+/**
+ * @brief Get every attribute in @p namespaces (XATTR_NS_*) with its value,
+ * not following symlinks, packed encoding (schema XattrValues).
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_lgetxattrs_packed(const char *path, uint32_t namespaces, uint8_t **data, int64_t *length);
+
+/**
+ * @brief Handle (linux_openat_handle) counterpart of linux_lgetxattrs_packed.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_fgetxattrs_packed(int64_t handle, uint32_t namespaces, uint8_t **data, int64_t *length);
 }
 
 /** @} */
@@ -1,16 +1,23 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "Acl.h"
+#include "Schemas.h"
+#include "ValuePool.h"
 #include <acl/libacl.h>
 #include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
 #include <sys/acl.h>
+#include <unistd.h>
 
 namespace OsCalls {
 /**
  * @brief Handler function for ACL text results - yields ACL string.
  *
  * Returns the ACL as a short-form text string on the first iteration.
- * Uses acl_free to release the libacl-allocated text buffer.
+ * The libacl-allocated text is freed by release_acl_text.
  *
  * @param value Pointer to ValueT with Handle.data1 containing char* from
  * acl_to_any_text.
@@ -26,13 +33,97 @@ bool handle_acl_text(ValueT *value) {
         }
     // else fall through
     default:
-        if (value->Handle.data1 != nullptr)
-            acl_free(value->Handle.data1);
-        delete value;
         return false;
     }
 }
 
+/**
+ * @brief ReleaseT for ACL text cursors: frees the text with acl_free.
+ *
+ * @param value Cursor being released.
+ */
+void release_acl_text(ValueT *value) {
+    if (value->Handle.data1 != nullptr)
+        acl_free(value->Handle.data1);
+}
+
+namespace {
+std::mutex textMutex;
+
+// Short text form (TEXT_ABBREVIATE omits entries equal to the mode bits).
+// libacl names the qualifiers with getpwuid / getgrgid, whose static result
+// buffers concurrent conversions would overwrite: one at a time.
+char *to_text(acl_t acl) {
+    std::lock_guard lock(textMutex);
+    return ::acl_to_any_text(acl, nullptr, ',', TEXT_ABBREVIATE);
+}
+}  // namespace
+
+char *acl_text(const char *path, acl_type_t type, int *en) {
+    acl_t acl = ::acl_get_file(path, type);
+    if (acl == nullptr) {
+        *en = errno;
+        return nullptr;
+    }
+    errno = 0;
+    char *text = to_text(acl);
+    *en = text != nullptr ? 0 : errno != 0 ? errno : ENOMEM;
+    acl_free(acl);
+    return text;
+}
+
+/**
+ * @brief Shared body of the packed ACL exports.
+ *
+ * Same conversion as the cursor variants (short text, TEXT_ABBREVIATE), but
+ * a failure is only an errno: nothing is allocated for it.
+ *
+ * @param path Filesystem path to read ACL from.
+ * @param type ACL_TYPE_ACCESS or ACL_TYPE_DEFAULT.
+ * @param data Receives the encoded buffer on success.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+static int acl_get_file_packed(const char *path, acl_type_t type, uint8_t **data, int64_t *length) {
+    auto en = 0;
+    auto text = acl_text(path, type, &en);
+    if (text == nullptr)
+        return en;
+
+    PackedWriter w(uint32_t(Schema::AclText), strlen(text) + 16);
+    w.put_string(1, text);
+    acl_free(text);
+    if (!w.ok())
+        return ENOMEM;
+    *data = w.release(length);
+    return 0;
+}
+
+/**
+ * @brief Packed ACL of a (handle, name) entry.
+ *
+ * libacl has no *at variant and acl_get_fd needs a readable descriptor, so
+ * the entry is opened O_PATH (following symlinks, like acl_get_file) and read
+ * through its /proc/self/fd magic link, which resolves without a path walk.
+ *
+ * @param dir Directory handle.
+ * @param name Entry name within @p dir.
+ * @param type ACL_TYPE_ACCESS or ACL_TYPE_DEFAULT.
+ * @param data Receives the encoded buffer on success.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+static int acl_get_at_packed(int64_t dir, const char *name, acl_type_t type, uint8_t **data, int64_t *length) {
+    int fd = ::openat(int(dir), name, O_PATH | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    char path[32];
+    std::snprintf(path, sizeof path, "/proc/self/fd/%d", fd);
+    auto rc = acl_get_file_packed(path, type, data, length);
+    ::close(fd);
+    return rc;
+}
+
 extern "C" {
 /**
  * @brief Reads the access ACL from a file or directory.
@@ -50,14 +141,12 @@ ValueT *linux_acl_get_file_access(const char *path) {
 
     char *text = nullptr;
     if (acl != nullptr) {
-        // Convert to short text form (omits entries equal to mode bits)
-        text = ::acl_to_any_text(acl, nullptr, ',', TEXT_ABBREVIATE);
+        text = to_text(acl);
         acl_free(acl);
         en = errno;
     }
 
-    auto v = new ValueT();
-    CreateHandle(v, handle_acl_text, text, nullptr);
+    auto v = NewHandle(handle_acl_text, release_acl_text, text, nullptr);
 
     if (text != nullptr)
         v->Type = TypeT::IsOk;
@@ -87,14 +176,12 @@ ValueT *linux_acl_get_file_default(const char *path) {
 
     char *text = nullptr;
     if (acl != nullptr) {
-        // Convert to short text form (omits entries equal to mode bits)
-        text = ::acl_to_any_text(acl, nullptr, ',', TEXT_ABBREVIATE);
+        text = to_text(acl);
         acl_free(acl);
         en = errno;
     }
 
-    auto v = new ValueT();
-    CreateHandle(v, handle_acl_text, text, nullptr);
+    auto v = NewHandle(handle_acl_text, release_acl_text, text, nullptr);
 
     if (text != nullptr)
         v->Type = TypeT::IsOk;
@@ -107,5 +194,21 @@ ValueT *linux_acl_get_file_default(const char *path) {
 ValueT *acl_get_file_default(const char *path) {
     return linux_acl_get_file_default(path);
 };
+
+int linux_acl_get_file_access_packed(const char *path, uint8_t **data, int64_t *length) {
+    return acl_get_file_packed(path, ACL_TYPE_ACCESS, data, length);
+}
+
+int linux_acl_get_file_default_packed(const char *path, uint8_t **data, int64_t *length) {
+    return acl_get_file_packed(path, ACL_TYPE_DEFAULT, data, length);
+}
+
+int linux_acl_get_access_at_packed(int64_t dir, const char *name, uint8_t **data, int64_t *length) {
+    return acl_get_at_packed(dir, name, ACL_TYPE_ACCESS, data, length);
+}
+
+int linux_acl_get_default_at_packed(int64_t dir, const char *name, uint8_t **data, int64_t *length) {
+    return acl_get_at_packed(dir, name, ACL_TYPE_DEFAULT, data, length);
+}
 }
 }  // namespace OsCalls
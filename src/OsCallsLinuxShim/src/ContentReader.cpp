@@ -0,0 +1,140 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "ContentReader.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace OsCalls {
+namespace {
+constexpr int kOpenFlags = O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC;
+
+const int64_t kPageSize = ::sysconf(_SC_PAGESIZE) > 0 ? ::sysconf(_SC_PAGESIZE) : 4096;
+
+// Residency is sampled at least this far past a read: sequential readahead
+// runs up to twice read_ahead_kb ahead, which is several MiB on many devices
+constexpr int64_t kLookahead = int64_t(32) << 20;
+
+// Which pages of [start, start + size) are in the page cache, without
+// faulting any in; empty if that cannot be told (then nothing is dropped).
+std::vector<unsigned char> resident_pages(int fd, int64_t start, int64_t size) {
+    std::vector<unsigned char> pages;
+    auto map = ::mmap(nullptr, size_t(size), PROT_READ, MAP_SHARED, fd, start);
+    if (map == MAP_FAILED)
+        return pages;
+    pages.resize(size_t((size + kPageSize - 1) / kPageSize));
+    if (::mincore(map, size_t(size), pages.data()) != 0)
+        pages.clear();
+    ::munmap(map, size_t(size));
+    return pages;
+}
+
+// Drops the first @p count pages from @p start that were not resident before
+// the read or lie below @p owned (brought in by our earlier readahead), one
+// fadvise per run.
+void drop_pages(int fd, int64_t start, const std::vector<unsigned char> &pages, size_t count, int64_t owned) {
+    auto ours = [&](size_t i) { return (pages[i] & 1) == 0 || start + int64_t(i) * kPageSize < owned; };
+    for (size_t i = 0; i < count;) {
+        if (!ours(i)) {
+            ++i;
+            continue;
+        }
+        auto end = i;
+        while (end < count && ours(end))
+            ++end;
+        ::posix_fadvise(fd, start + int64_t(i) * kPageSize, int64_t(end - i) * kPageSize, POSIX_FADV_DONTNEED);
+        i = end;
+    }
+}
+}  // namespace
+
+extern "C" {
+/**
+ * @brief Opens a file with O_NOATIME where allowed and advises sequential
+ * reads; see ContentReader.h.
+ */
+int linux_open_content(int64_t dir, const char *name, int32_t *fd) {
+    auto rc = ::openat(int(dir), name, kOpenFlags | O_NOATIME);
+    if (rc < 0 && errno == EPERM)
+        rc = ::openat(int(dir), name, kOpenFlags);
+    if (rc < 0)
+        return errno;
+    ::posix_fadvise(rc, 0, 0, POSIX_FADV_SEQUENTIAL);
+    *fd = rc;
+    return 0;
+}
+
+/**
+ * @brief Reads content, optionally dropping the pages it brought into the
+ * page cache; see ContentReader.h.
+ */
+int linux_read_content(int32_t fd, uint8_t *buffer, int64_t length, int64_t offset, uint32_t flags, int64_t *owned,
+                       int64_t *count) {
+    if (length < 0 || offset < 0)
+        return EINVAL;
+    // Besides the range read, look ahead up to EOF: the kernel's readahead
+    // fills that range during this read, and only what is absent now is ours
+    auto                       start = offset / kPageSize * kPageSize;
+    std::vector<unsigned char> pages;
+    struct stat                st;
+    if ((flags & CONTENT_DROP_BEHIND) != 0 && length > 0 && ::fstat(fd, &st) == 0) {
+        auto sampleEnd = std::min(offset + length + std::max(length, kLookahead), int64_t(st.st_size));
+        try {
+            if (sampleEnd > start)
+                pages = resident_pages(fd, start, sampleEnd - start);
+        } catch (const std::bad_alloc &) {
+            // Read without dropping
+        }
+    }
+
+    int64_t done = 0;
+    while (done < length) {
+        auto n = ::pread(fd, buffer + done, size_t(length - done), offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return errno;
+        if (n == 0)
+            break;
+        done += n;
+    }
+    *count = done;
+
+    if (pages.empty())
+        return 0;
+    // A partial last page is kept for the next read, unless this one hit EOF
+    auto end = offset + done;
+    auto full = size_t(done < length ? (end - start + kPageSize - 1) / kPageSize : (end - start) / kPageSize);
+    drop_pages(fd, start, pages, std::min(full, pages.size()), *owned);
+    // Ours from here on: the run of absent pages the next read starts in
+    auto next = full;
+    while (next < pages.size() && ((pages[next] & 1) == 0 || start + int64_t(next) * kPageSize < *owned))
+        ++next;
+    *owned = start + int64_t(next) * kPageSize;
+    return 0;
+}
+
+/**
+ * @brief Locates the next data extent with SEEK_DATA / SEEK_HOLE; see
+ * ContentReader.h.
+ */
+int linux_find_data(int32_t fd, int64_t offset, int64_t *start, int64_t *end) {
+    if (offset < 0)
+        return EINVAL;
+    auto data = ::lseek(fd, offset, SEEK_DATA);
+    if (data < 0)
+        return errno;
+    auto hole = ::lseek(fd, data, SEEK_HOLE);
+    if (hole < 0)
+        return errno;
+    *start = data;
+    *end = hole;
+    return 0;
+}
+}
+}  // namespace OsCalls
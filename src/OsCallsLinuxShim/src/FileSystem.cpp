@@ -1,173 +1,119 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "FileSystem.h"
+#include "Schemas.h"
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <linux/magic.h>
+#include <new>
+#include <string>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
+#include <vector>
 
-// Helper function to convert timespec to TimeSpec64
-static OsCalls::TimeSpec64 timespec_to_timespec64(const struct timespec &ts) {
-    OsCalls::TimeSpec64 result;
-    result.tv_sec = ts.tv_sec;
-    result.tv_nsec = ts.tv_nsec;
-    return result;
+namespace OsCalls {
+void stat_to_record(const struct stat &st, StatRecord *out) {
+    out->st_dev = st.st_dev;
+    out->st_ino = st.st_ino;
+    out->st_mode = st.st_mode;
+    out->st_nlink = st.st_nlink;
+    out->st_uid = st.st_uid;
+    out->st_gid = st.st_gid;
+    out->st_rdev = st.st_rdev;
+    out->st_size = st.st_size;
+    out->st_blksize = st.st_blksize;
+    out->st_blocks = st.st_blocks;
+    out->st_atim = timespec_to_timespec64(st.st_atim);
+    out->st_mtim = timespec_to_timespec64(st.st_mtim);
+    out->st_ctim = timespec_to_timespec64(st.st_ctim);
 }
 
-// Safe wrappers for file type test macros (not all are available on all
-// platforms)
-#ifdef S_ISBLK
-#define SAFE_S_ISBLK(m) S_ISBLK(m)
-#else
-#define SAFE_S_ISBLK(m) false
-#endif
-
-#ifdef S_ISCHR
-#define SAFE_S_ISCHR(m) S_ISCHR(m)
-#else
-#define SAFE_S_ISCHR(m) false
-#endif
-
-#ifdef S_ISFIFO
-#define SAFE_S_ISFIFO(m) S_ISFIFO(m)
-#else
-#define SAFE_S_ISFIFO(m) false
-#endif
-
-#ifdef S_ISSOCK
-#define SAFE_S_ISSOCK(m) S_ISSOCK(m)
-#else
-#define SAFE_S_ISSOCK(m) false
-#endif
-
-#ifdef S_TYPEISMQ
-#define SAFE_S_TYPEISMQ(s) S_TYPEISMQ(s)
-#else
-#define SAFE_S_TYPEISMQ(s) false
-#endif
-
-#ifdef S_TYPEISSEM
-#define SAFE_S_TYPEISSEM(s) S_TYPEISSEM(s)
-#else
-#define SAFE_S_TYPEISSEM(s) false
-#endif
-
-#ifdef S_TYPEISSHM
-#define SAFE_S_TYPEISSHM(s) S_TYPEISSHM(s)
-#else
-#define SAFE_S_TYPEISSHM(s) false
-#endif
-
-#ifdef S_TYPEISTMO
-#define SAFE_S_TYPEISTMO(s) S_TYPEISTMO(s)
-#else
-#define SAFE_S_TYPEISTMO(s) false
-#endif
+static TimeSpec64 statx_timestamp_to_timespec64(const struct statx_timestamp &ts) {
+    return TimeSpec64{ts.tv_sec, ts.tv_nsec};
+}
 
-namespace OsCalls {
-/**
- * @brief Handler function for lstat results - iterates through stat structure
- * fields.
- *
- * Yields stat buffer fields sequentially (st_dev, st_ino, st_mode, file type
- * flags, st_nlink, owner/group IDs, size, timestamps, etc.) via the ValueT
- * cursor protocol. Cleans up allocated stat buffer and ValueT on completion or
- * error.
- *
- * @param value Pointer to ValueT with Handle.data1 containing struct stat*.
- * @return true if more fields remain, false when iteration completes.
- */
-bool handle_lstat(ValueT *value) {
-    auto stbuf = reinterpret_cast<struct stat *>(value->Handle.data1);
-    switch (value->Handle.index) {
-    case 0:
-        if (value->Type == TypeT::IsOk) {
-            set_val(Number, "st_dev", stbuf->st_dev);
-            return true;
-        }
-    // else fall through
+// Copy a struct statx into the record shared with managed code
+static void statx_to_record(const struct statx &stx, StatxRecord *out) {
+    out->stx_mask = stx.stx_mask;
+    out->stx_attributes = int64_t(stx.stx_attributes);
+    out->stx_attributes_mask = int64_t(stx.stx_attributes_mask);
+    out->stx_dev = int64_t(makedev(stx.stx_dev_major, stx.stx_dev_minor));
+    out->stx_ino = int64_t(stx.stx_ino);
+    out->stx_mode = stx.stx_mode;
+    out->stx_nlink = stx.stx_nlink;
+    out->stx_uid = stx.stx_uid;
+    out->stx_gid = stx.stx_gid;
+    out->stx_rdev = int64_t(makedev(stx.stx_rdev_major, stx.stx_rdev_minor));
+    out->stx_size = int64_t(stx.stx_size);
+    out->stx_blksize = stx.stx_blksize;
+    out->stx_blocks = int64_t(stx.stx_blocks);
+    out->stx_mnt_id = (stx.stx_mask & STATX_MNT_ID) != 0 ? int64_t(stx.stx_mnt_id) : 0;
+    out->stx_atime = statx_timestamp_to_timespec64(stx.stx_atime);
+    out->stx_btime = statx_timestamp_to_timespec64(stx.stx_btime);
+    out->stx_ctime = statx_timestamp_to_timespec64(stx.stx_ctime);
+    out->stx_mtime = statx_timestamp_to_timespec64(stx.stx_mtime);
+}
+
+// The same fields as a StatRecord, for listings (zero where not in stx_mask)
+static void statx_to_stat_record(const struct statx &stx, StatRecord *out) {
+    out->st_dev = int64_t(makedev(stx.stx_dev_major, stx.stx_dev_minor));
+    out->st_ino = int64_t(stx.stx_ino);
+    out->st_mode = stx.stx_mode;
+    out->st_nlink = stx.stx_nlink;
+    out->st_uid = stx.stx_uid;
+    out->st_gid = stx.stx_gid;
+    out->st_rdev = int64_t(makedev(stx.stx_rdev_major, stx.stx_rdev_minor));
+    out->st_size = int64_t(stx.stx_size);
+    out->st_blksize = stx.stx_blksize;
+    out->st_blocks = int64_t(stx.stx_blocks);
+    out->st_atim = statx_timestamp_to_timespec64(stx.stx_atime);
+    out->st_mtim = statx_timestamp_to_timespec64(stx.stx_mtime);
+    out->st_ctim = statx_timestamp_to_timespec64(stx.stx_ctime);
+}
+
+// Fields of an inode record (see LinuxHighLevelOsApi.FromStat): everything
+// basic except atime and the block counts.
+constexpr unsigned kInodeStatxMask = STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_INO |
+                                     STATX_SIZE | STATX_MTIME | STATX_CTIME;
+
+// Filesystems whose attributes live on a server; a full stat there may cost
+// a round trip to revalidate them.
+static bool is_remote_fs_type(__fsword_t type) {
+    switch (static_cast<unsigned long>(type)) {
+    case NFS_SUPER_MAGIC:
+    case SMB_SUPER_MAGIC:
+    case 0xFF534D42UL:  // CIFS_MAGIC_NUMBER
+    case 0xFE534D42UL:  // SMB2_MAGIC_NUMBER
+    case CEPH_SUPER_MAGIC:
+    case V9FS_MAGIC:
+    case AFS_SUPER_MAGIC:
+        return true;
     default:
-        delete reinterpret_cast<struct stat *>(value->Handle.data1);
-        delete value;
         return false;
-    case 1:
-        set_val(Number, "st_ino", stbuf->st_ino);
-        return true;
-    case 2:
-        set_val(Number, "st_mode", stbuf->st_mode);
-        return true;
-    case 3:
-        set_val(Boolean, "S_ISBLK", SAFE_S_ISBLK(stbuf->st_mode));
-        return true;
-    case 4:
-        set_val(Boolean, "S_ISCHR", SAFE_S_ISCHR(stbuf->st_mode));
-        return true;
-    case 5:
-        set_val(Boolean, "S_ISDIR", S_ISDIR(stbuf->st_mode));
-        return true;
-    case 6:
-        set_val(Boolean, "S_ISFIFO", SAFE_S_ISFIFO(stbuf->st_mode));
-        return true;
-    case 7:
-        set_val(Boolean, "S_ISLNK", S_ISLNK(stbuf->st_mode));
-        return true;
-    case 8:
-        set_val(Boolean, "S_ISREG", S_ISREG(stbuf->st_mode));
-        return true;
-    case 9:
-        set_val(Boolean, "S_ISSOCK", SAFE_S_ISSOCK(stbuf->st_mode));
-        return true;
-    case 10:
-        set_val(Boolean, "S_TYPEISMQ", SAFE_S_TYPEISMQ(stbuf));
-        return true;
-    case 11:
-        set_val(Boolean, "S_TYPEISSEM", SAFE_S_TYPEISSEM(stbuf));
-        return true;
-    case 12:
-        set_val(Boolean, "S_TYPEISSHM", SAFE_S_TYPEISSHM(stbuf));
-        return true;
-    case 13:
-        set_val(Boolean, "S_TYPEISTMO", SAFE_S_TYPEISTMO(stbuf));
-        return true;
-    case 14:
-        set_val(Number, "st_nlink", stbuf->st_nlink);
-        return true;
-    case 15:
-        set_val(Number, "st_uid", stbuf->st_uid);
-        return true;
-    case 16:
-        set_val(Number, "st_gid", stbuf->st_gid);
-        return true;
-    case 17:
-        set_val(Number, "st_rdev", stbuf->st_rdev);
-        return true;
-    case 18:
-        set_val(Number, "st_size", stbuf->st_size);
-        return true;
-    case 19:
-        set_val(TimeSpec, "st_atim", timespec_to_timespec64(stbuf->st_atim));
-        return true;
-    case 20:
-        set_val(TimeSpec, "st_mtim", timespec_to_timespec64(stbuf->st_mtim));
-        return true;
-    case 21:
-        set_val(TimeSpec, "st_ctim", timespec_to_timespec64(stbuf->st_ctim));
-        return true;
-    case 22:
-        set_val(Number, "st_blksize", stbuf->st_blksize);
-        return true;
-    case 23:
-        set_val(Number, "st_blocks", stbuf->st_blocks);
-        return true;
     }
 }
 
+static bool is_remote_fs(int fd) {
+    struct statfs sfs;
+    return ::fstatfs(fd, &sfs) == 0 && is_remote_fs_type(sfs.f_type);
+}
+
 /**
  * @brief Handler function for readlink results - returns symlink target path.
  *
  * Yields a single string value containing the symlink's target path.
- * Cleans up allocated buffer and ValueT on completion or error.
+ * The pooled buffer is freed by ReleaseHandle.
  *
  * @param value Pointer to ValueT with Handle.data1 containing char* buffer.
  * @return true on first call if successful, false to signal completion.
@@ -182,8 +128,6 @@ bool handle_readlink(ValueT *value) {
         }
     // else fall through
     default:
-        delete[] reinterpret_cast<char *>(value->Handle.data1);
-        delete value;
         return false;
     }
 }
@@ -194,10 +138,10 @@ bool handle_readlink(ValueT *value) {
  *
  * Yields a single string value containing the resolved absolute path with all
  * symlinks expanded and relative components removed.
- * Uses ::free() on data1 since canonicalize_file_name uses malloc.
+ * The pooled buffer is freed by ReleaseHandle.
  *
- * @param value Pointer to ValueT with Handle.data1 containing char* from
- * canonicalize_file_name.
+ * @param value Pointer to ValueT with Handle.data1 containing the resolved
+ * path.
  * @return true on first call if successful, false to signal completion.
  */
 bool handle_cfn(ValueT *value) {
@@ -210,13 +154,151 @@ bool handle_cfn(ValueT *value) {
         }
     // else fall through
     default:
-        ::free(value->Handle.data1);
-        delete value;
         return false;
     }
 }
 
-auto slbufsz = _POSIX_PATH_MAX;
+// Per thread: growing a shared size hint raced with concurrent readers of it
+thread_local auto slbufsz = _POSIX_PATH_MAX;
+
+// readlinkat(2) into a pooled, growing buffer, yielded by handle_readlink
+static ValueT *readlink_cursor(int dirfd, const char *path) {
+    if (slbufsz <= 0)
+        slbufsz = 1024;
+    auto  cnt = 0;
+    auto  en = 0;
+    char *strbuf = nullptr;
+    bool  truncated;
+    do {
+        strbuf = static_cast<char *>(AllocBuffer(slbufsz));
+        if (strbuf == nullptr) {
+            cnt = -1;
+            en = ENOMEM;
+            break;
+        }
+        errno = 0;
+        cnt = ::readlinkat(dirfd, path, strbuf, slbufsz - 1);
+        en = errno;
+        // Decide before growing slbufsz: testing against the doubled size
+        // would end the loop with the buffer already freed
+        truncated = cnt >= slbufsz - 1;
+        if (truncated) {
+            slbufsz <<= 1;
+            FreeBuffer(strbuf);
+        }
+    } while (truncated);
+    auto v = NewHandle(handle_readlink, ReleaseBuffer, strbuf, nullptr);
+    if (cnt < 0)
+        v->Number = en;
+    else {
+        v->Type = TypeT::IsOk;
+        strbuf[cnt] = '\0';
+    }
+    return v;
+}
+
+namespace {
+// A directory entry waiting for its stat; the name is an offset into a
+// shared buffer so collecting a large directory costs two allocations.
+struct PendingEntry {
+    uint64_t ino;
+    size_t   name;
+    uint8_t  type;
+};
+}  // namespace
+
+// Stats one entry of @p fd and appends field 4 (or 5 on failure). @p remote
+// drops to false for good when the kernel has no statx.
+static void put_entry_stat(PackedWriter &w, int fd, const char *name, bool &remote, SubdirFn onSubdir,
+                           void *context) {
+    StatRecord record;
+    int        statRc = 0;
+    if (remote) {
+        struct statx stx;
+        if (::statx(fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, kInodeStatxMask, &stx) == 0)
+            statx_to_stat_record(stx, &record);
+        else if ((statRc = errno) == ENOSYS)
+            remote = false;  // no statx: fstatat this and the remaining entries
+    }
+    if (!remote) {
+        struct stat stbuf;
+        if (::fstatat(fd, name, &stbuf, AT_SYMLINK_NOFOLLOW) == 0) {
+            stat_to_record(stbuf, &record);
+            statRc = 0;
+        } else {
+            statRc = errno;
+        }
+    }
+    if (statRc == 0) {
+        w.put_bytes(4, &record, sizeof(record));
+        if (onSubdir != nullptr && S_ISDIR(record.st_mode))
+            onSubdir(context, name, record);
+    } else {
+        w.put_int(5, statRc);
+    }
+}
+
+// getdents64 is called directly (rather than readdir) so one syscall fills a
+// 64 KiB batch, typically a few thousand entries. With READ_DIRECTORY_STAT
+// the whole directory is read first and the entries are stat-ed in inode
+// number order: filesystems such as ext4 place inodes in tables ordered by
+// number, so on a cold cache this sweeps the inode table forward instead of
+// seeking back and forth in name or hash order.
+int read_directory_fd(int fd, uint32_t flags, uint8_t **data, int64_t *length, SubdirFn onSubdir, void *context) {
+    constexpr size_t kBatchSize = size_t(1) << 16;
+    auto             batch = static_cast<char *>(AllocBuffer(kBatchSize));
+    if (batch == nullptr)
+        return ENOMEM;
+    PackedWriter              w(uint32_t(Schema::DirEntries), kBatchSize);
+    int                       rc = 0;
+    bool                      withStat = (flags & READ_DIRECTORY_STAT) != 0;
+    std::vector<PendingEntry> pending;
+    std::string               names;
+    try {
+        for (;;) {
+            auto n = ::syscall(SYS_getdents64, fd, batch, kBatchSize);
+            if (n <= 0) {
+                rc = n < 0 ? errno : 0;
+                break;
+            }
+            for (long pos = 0; pos < n;) {
+                auto d = reinterpret_cast<const struct dirent64 *>(batch + pos);
+                pos += d->d_reclen;
+                auto name = d->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                    continue;
+                if (withStat) {
+                    pending.push_back(PendingEntry{uint64_t(d->d_ino), names.size(), d->d_type});
+                    names.append(name, std::strlen(name) + 1);
+                    continue;
+                }
+                w.put_string(1, name);
+                w.put_int(2, d->d_type);
+                w.put_int(3, int64_t(d->d_ino));
+            }
+        }
+        if (rc == 0 && withStat) {
+            std::sort(pending.begin(), pending.end(),
+                      [](const PendingEntry &a, const PendingEntry &b) { return a.ino < b.ino; });
+            bool remote = is_remote_fs(fd);
+            for (auto &entry : pending) {
+                auto name = names.data() + entry.name;
+                w.put_string(1, name);
+                w.put_int(2, entry.type);
+                w.put_int(3, int64_t(entry.ino));
+                put_entry_stat(w, fd, name, remote, onSubdir, context);
+            }
+        }
+    } catch (const std::bad_alloc &) {
+        rc = ENOMEM;
+    }
+    FreeBuffer(batch);
+    if (rc == 0 && !w.ok())
+        rc = ENOMEM;
+    if (rc == 0)
+        *data = w.release(length);
+    return rc;
+}
 
 extern "C" {
 /**
@@ -230,12 +312,15 @@ extern "C" {
  * @return ValueT* cursor initialized with stat data or error number.
  */
 ValueT *linux_lstat(const char *path) {
-    auto stbuf = new struct stat();
+    auto stbuf = static_cast<struct stat *>(AllocBuffer(sizeof(struct stat)));
+    auto v = NewHandle(handle_table<kStatFields>, ReleaseBuffer, stbuf, nullptr);
+    if (stbuf == nullptr) {
+        v->Number = ENOMEM;
+        return v;
+    }
     errno = 0;
     auto rc = ::lstat(path, stbuf);
     auto en = errno;
-    auto v = new ValueT();
-    CreateHandle(v, handle_lstat, stbuf, nullptr);
     if (rc < 0)
         v->Number = en;
     else
@@ -248,6 +333,46 @@ ValueT *lstat(const char *path) {
     return linux_lstat(path);
 };
 
+/**
+ * @brief Performs lstat(2) and copies the result into a caller-owned record.
+ *
+ * Flat alternative to linux_lstat: one native transition, no ValueT cursor
+ * and no heap allocation per call.
+ *
+ * @param path Filesystem path to inspect.
+ * @param out StatRecord to fill on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_lstat_into(const char *path, StatRecord *out) {
+    struct stat stbuf;
+    if (::lstat(path, &stbuf) < 0)
+        return errno;
+    stat_to_record(stbuf, out);
+    return 0;
+};
+
+/**
+ * @brief Performs lstat(2) and returns the result in the packed encoding.
+ *
+ * Fields and ids follow kStatFields (schema Stat) in Schemas.h.
+ *
+ * @param path Filesystem path to inspect.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_lstat_packed(const char *path, uint8_t **data, int64_t *length) {
+    struct stat stbuf;
+    if (::lstat(path, &stbuf) < 0)
+        return errno;
+    PackedWriter w(uint32_t(Schema::Stat));
+    encode_table<kStatFields>(w, stbuf);
+    if (!w.ok())
+        return ENOMEM;
+    *data = w.release(length);
+    return 0;
+};
+
 /**
  * @brief Reads the target of a symbolic link and returns it as a string.
  *
@@ -258,30 +383,7 @@ ValueT *lstat(const char *path) {
  * @return ValueT* cursor with symlink target string or error number.
  */
 ValueT *linux_readlink(const char *path) {
-    if (slbufsz <= 0)
-        slbufsz = 1024;
-    auto  cnt = 0;
-    auto  en = 0;
-    char *strbuf = nullptr;
-    do {
-        strbuf = new char[slbufsz];
-        errno = 0;
-        cnt = ::readlink(path, strbuf, slbufsz - 1);
-        en = errno;
-        if (cnt >= slbufsz - 1) {
-            slbufsz <<= 1;
-            delete[] strbuf;
-        }
-    } while (cnt >= slbufsz - 1);
-    auto v = new ValueT();
-    CreateHandle(v, handle_readlink, strbuf, nullptr);
-    if (cnt < 0)
-        v->Number = en;
-    else {
-        v->Type = TypeT::IsOk;
-        strbuf[cnt] = '\0';
-    }
-    return v;
+    return readlink_cursor(AT_FDCWD, path);
 };
 
 // Backwards-compatibility wrapper: call the linux_* prefixed implementation.
@@ -299,13 +401,17 @@ ValueT *readlink(const char *path) {
  * @return ValueT* cursor with canonical path string or error number.
  */
 ValueT *linux_canonicalize_file_name(const char *path) {
-    // ::chown("*** before ***", errno, (intptr_t)path);
+    // realpath(3) into a pooled PATH_MAX buffer is canonicalize_file_name
+    // without the per-call malloc.
+    auto buf = static_cast<char *>(AllocBuffer(PATH_MAX));
+    auto v = NewHandle(handle_cfn, ReleaseBuffer, buf, nullptr);
+    if (buf == nullptr) {
+        v->Number = ENOMEM;
+        return v;
+    }
     errno = 0;
-    auto cfn = ::canonicalize_file_name(path);
+    auto cfn = ::realpath(path, buf);
     auto en = errno;
-    // ::chown("*** after ***", errno, (intptr_t)cfn);
-    auto v = new ValueT();
-    CreateHandle(v, handle_cfn, cfn, nullptr);
     if (cfn != nullptr)
         v->Type = TypeT::IsOk;
     else
@@ -317,5 +423,228 @@ ValueT *linux_canonicalize_file_name(const char *path) {
 ValueT *canonicalize_file_name(const char *path) {
     return linux_canonicalize_file_name(path);
 };
+
+/**
+ * @brief Opens a directory handle for the *at calls.
+ *
+ * The handle pins the directory: entries are then addressed by name and the
+ * kernel resolves only that last component instead of the full path.
+ *
+ * @param path Directory to open.
+ * @param handle Receives the handle; close it with linux_close_handle.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_opendir_handle(const char *path, int64_t *handle) {
+    int fd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    *handle = fd;
+    return 0;
+}
+
+/**
+ * @brief Opens an O_PATH handle on a directory entry (not following symlinks).
+ *
+ * The handle references the inode itself and is meant for the handle-based
+ * xattr calls; it cannot be read from.
+ *
+ * @param dir Directory handle.
+ * @param name Entry name within @p dir.
+ * @param handle Receives the handle; close it with linux_close_handle.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_openat_handle(int64_t dir, const char *name, int64_t *handle) {
+    int fd = ::openat(int(dir), name, O_PATH | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    *handle = fd;
+    return 0;
+}
+
+/**
+ * @brief Opens a directory entry for reading (not following symlinks).
+ *
+ * Unlike the opaque handles, the result is a plain file descriptor owned by
+ * the caller, so managed code can wrap it in a SafeFileHandle/FileStream.
+ *
+ * @param dir Directory handle.
+ * @param name Entry name within @p dir.
+ * @param fd Receives the file descriptor.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_openat_read(int64_t dir, const char *name, int32_t *fd) {
+    int rc = ::openat(int(dir), name, O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC);
+    if (rc < 0)
+        return errno;
+    *fd = rc;
+    return 0;
+}
+
+/**
+ * @brief Closes a handle from linux_opendir_handle or linux_openat_handle.
+ *
+ * @param handle Handle to close.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_close_handle(int64_t handle) {
+    return ::close(int(handle)) < 0 ? errno : 0;
+}
+
+/**
+ * @brief fstatat(2) of an entry, not following symlinks, into a StatRecord.
+ *
+ * Same result as linux_lstat_into on the joined path. An empty @p name
+ * stats the handle itself (AT_EMPTY_PATH).
+ *
+ * @param dir Directory handle (or any handle when @p name is empty).
+ * @param name Entry name within @p dir.
+ * @param out StatRecord to fill on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_fstatat_into(int64_t dir, const char *name, StatRecord *out) {
+    struct stat stbuf;
+    int         flags = AT_SYMLINK_NOFOLLOW;
+    if (name == nullptr || *name == '\0') {
+        name = "";
+        flags |= AT_EMPTY_PATH;
+    }
+    if (::fstatat(int(dir), name, &stbuf, flags) < 0)
+        return errno;
+    stat_to_record(stbuf, out);
+    return 0;
+}
+
+/**
+ * @brief readlinkat(2) of an entry; same cursor as linux_readlink.
+ *
+ * @param dir Directory handle.
+ * @param name Symlink name within @p dir.
+ * @return ValueT* cursor with symlink target string or error number.
+ */
+ValueT *linux_readlinkat(int64_t dir, const char *name) {
+    return readlink_cursor(int(dir), name);
+}
+
+/**
+ * @brief statx(2) of an entry with a caller-chosen field mask and sync mode.
+ *
+ * Lets callers on network filesystems ask only for the fields they use and
+ * accept cached attributes, and returns what lstat cannot: birth time, mount
+ * id and the file attribute flags.
+ *
+ * @param dir Directory handle, or AT_FDCWD.
+ * @param name Entry name within @p dir (or a path); empty stats the handle.
+ * @param sync One of the AT_STATX_SYNC_TYPE values.
+ * @param mask STATX_* fields wanted.
+ * @param out StatxRecord to fill on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_statx(int64_t dir, const char *name, uint32_t sync, uint32_t mask, StatxRecord *out) {
+    if ((sync & ~uint32_t(AT_STATX_SYNC_TYPE)) != 0 || sync == AT_STATX_SYNC_TYPE)
+        return EINVAL;
+    int flags = AT_SYMLINK_NOFOLLOW | int(sync);
+    if (name == nullptr || *name == '\0') {
+        name = "";
+        flags |= AT_EMPTY_PATH;
+    }
+    struct statx stx;
+    if (::statx(int(dir), name, flags, mask, &stx) == 0) {
+        statx_to_record(stx, out);
+        return 0;
+    }
+    if (errno != ENOSYS)
+        return errno;
+
+    struct stat stbuf;
+    if (::fstatat(int(dir), name, &stbuf, flags & (AT_SYMLINK_NOFOLLOW | AT_EMPTY_PATH)) < 0)
+        return errno;
+    *out = StatxRecord{};
+    out->stx_mask = STATX_BASIC_STATS;
+    out->stx_dev = int64_t(stbuf.st_dev);
+    out->stx_ino = int64_t(stbuf.st_ino);
+    out->stx_mode = stbuf.st_mode;
+    out->stx_nlink = int64_t(stbuf.st_nlink);
+    out->stx_uid = stbuf.st_uid;
+    out->stx_gid = stbuf.st_gid;
+    out->stx_rdev = int64_t(stbuf.st_rdev);
+    out->stx_size = stbuf.st_size;
+    out->stx_blksize = stbuf.st_blksize;
+    out->stx_blocks = stbuf.st_blocks;
+    out->stx_atime = timespec_to_timespec64(stbuf.st_atim);
+    out->stx_ctime = timespec_to_timespec64(stbuf.st_ctim);
+    out->stx_mtime = timespec_to_timespec64(stbuf.st_mtim);
+    return 0;
+}
+
+/**
+ * @brief Reports whether @p handle is on a network filesystem.
+ *
+ * @param handle Any shim handle.
+ * @param remote Receives 1 for NFS, SMB/CIFS, Ceph, 9P or AFS, otherwise 0.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_fs_is_remote(int64_t handle, int32_t *remote) {
+    struct statfs sfs;
+    if (::fstatfs(int(handle), &sfs) != 0)
+        return errno;
+    *remote = is_remote_fs_type(sfs.f_type) ? 1 : 0;
+    return 0;
+}
+
+/**
+ * @brief Physical offsets of the first data extent of several files (FIEMAP).
+ *
+ * Lets the caller read the files of a directory in on-disk order. The map
+ * is taken without FIEMAP_FLAG_SYNC, so data still in the page cache only
+ * (delayed allocation) reports no offset rather than forcing writeback.
+ *
+ * @param dir Directory handle.
+ * @param names Entry names within @p dir.
+ * @param count Number of @p names.
+ * @param offsets Receives one byte offset per name, or -1 if unknown.
+ * @return 0 on success (per-file failures are -1 offsets), EINVAL for bad
+ *         arguments.
+ */
+int linux_data_offsets(int64_t dir, const char *const *names, int32_t count, int64_t *offsets) {
+    if (count < 0 || (count > 0 && (names == nullptr || offsets == nullptr)))
+        return EINVAL;
+    alignas(struct fiemap) unsigned char request[sizeof(struct fiemap) + sizeof(struct fiemap_extent)];
+    auto                                 map = reinterpret_cast<struct fiemap *>(request);
+    for (int32_t i = 0; i < count; ++i) {
+        offsets[i] = -1;
+        int fd = ::openat(int(dir), names[i], O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        std::memset(request, 0, sizeof(request));
+        map->fm_length = FIEMAP_MAX_OFFSET;
+        map->fm_extent_count = 1;
+        if (::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0 &&
+            (map->fm_extents[0].fe_flags & FIEMAP_EXTENT_UNKNOWN) == 0)
+            offsets[i] = int64_t(map->fm_extents[0].fe_physical);
+        ::close(fd);
+    }
+    return 0;
+}
+
+/**
+ * @brief Lists a directory, optionally with every entry's stat, in one call.
+ *
+ * Replaces one native call per entry (plus the managed enumeration) with a
+ * single packed buffer; see read_directory_fd.
+ *
+ * @param path Directory to list.
+ * @param flags Zero or READ_DIRECTORY_STAT.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_read_directory(const char *path, uint32_t flags, uint8_t **data, int64_t *length) {
+    int fd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    int rc = read_directory_fd(fd, flags, data, length);
+    ::close(fd);
+    return rc;
+}
 }
 }  // namespace OsCalls
@@ -0,0 +1,145 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "InodeCollector.h"
+#include "Acl.h"
+#include "FileSystem.h"
+#include "Schemas.h"
+#include "UserGroupDatabase.h"
+#include "Xattr.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace OsCalls {
+namespace {
+// Closes the entry descriptor on every return path
+struct Fd {
+    int fd;
+    ~Fd() {
+        if (fd >= 0)
+            ::close(fd);
+    }
+};
+
+// COLLECT_ACL_RAW: the xattr values as they are, no libacl and no NSS lookups
+// of the qualifiers. Any failure to read the access ACL means there is none.
+void put_raw_acls(PackedWriter &w, int fd, const struct stat &st, const char *names, ssize_t size) {
+    const char *value;
+    auto        n = size >= 0 && !xattr_list_contains(names, size, "system.posix_acl_access")
+                        ? -1
+                        : fd_getxattr_scratch(fd, "system.posix_acl_access", &value);
+    if (n > 0)
+        w.put_bytes(11, value, size_t(n));
+    else
+        w.put_int(10, 1);
+    if (!S_ISDIR(st.st_mode) || (size >= 0 && !xattr_list_contains(names, size, "system.posix_acl_default")))
+        return;
+    n = fd_getxattr_scratch(fd, "system.posix_acl_default", &value);
+    if (n > 0)
+        w.put_bytes(12, value, size_t(n));
+}
+
+// Through the name cache: most entries share a handful of owners
+void put_owner(PackedWriter &w, const struct stat &st) {
+    auto        en = 0;
+    std::string name;
+    if (user_name(st.st_uid, name, &en))
+        w.put_string(2, name.c_str());
+    if (group_name(st.st_gid, name, &en))
+        w.put_string(3, name.c_str());
+}
+
+// An ACL is stored as its system.posix_acl_* xattr. Without the access one,
+// libacl would only synthesize the ACL from the mode bits, so field 10 says
+// that instead; without the default one there is none. Only an entry that
+// has an ACL (or whose listing failed) costs libacl calls and formatting.
+// libacl has no fd variant for O_PATH descriptors: read through the magic link.
+void put_acls(PackedWriter &w, int fd, const struct stat &st, const char *names, ssize_t size) {
+    auto listed = size >= 0;
+    char path[32];
+    std::snprintf(path, sizeof path, "/proc/self/fd/%d", fd);
+    auto en = 0;
+    if (listed && !xattr_list_contains(names, size, "system.posix_acl_access")) {
+        w.put_int(10, 1);
+    } else if (auto text = acl_text(path, ACL_TYPE_ACCESS, &en)) {
+        w.put_string(4, text);
+        acl_free(text);
+    }
+    if (!S_ISDIR(st.st_mode) || (listed && !xattr_list_contains(names, size, "system.posix_acl_default")))
+        return;
+    if (auto text = acl_text(path, ACL_TYPE_DEFAULT, &en)) {
+        w.put_string(5, text);
+        acl_free(text);
+    }
+}
+
+// st_size is the target length, so one readlinkat usually suffices; it is
+// 0 on some pseudo filesystems, and a link replaced meanwhile may be longer.
+void put_link(PackedWriter &w, int fd, const struct stat &st) {
+    std::vector<char> target(st.st_size > 0 ? size_t(st.st_size) + 1 : PATH_MAX);
+    for (;;) {
+        auto n = ::readlinkat(fd, "", target.data(), target.size());
+        if (n < 0) {
+            w.put_int(9, errno);
+            return;
+        }
+        if (size_t(n) < target.size()) {
+            w.put_bytes(8, target.data(), size_t(n));
+            return;
+        }
+        target.resize(target.size() * 2);
+    }
+}
+}  // namespace
+
+extern "C" {
+/**
+ * @brief Collects stat, owner names, ACLs, xattrs and link target of one
+ * entry; see InodeCollector.h.
+ */
+int linux_collect_inode(int64_t dir, const char *name, uint32_t flags, uint8_t **data, int64_t *length) {
+    Fd entry{::openat(int(dir), name, O_PATH | O_NOFOLLOW | O_CLOEXEC)};
+    if (entry.fd < 0)
+        return errno;
+    struct stat st;
+    if (::fstatat(entry.fd, "", &st, AT_EMPTY_PATH) != 0)
+        return errno;
+
+    try {
+        PackedWriter w(uint32_t(Schema::InodeMetadata), 512);
+        StatRecord   record;
+        stat_to_record(st, &record);
+        w.put_bytes(1, &record, sizeof record);
+        if ((flags & COLLECT_OWNER) != 0)
+            put_owner(w, st);
+        // One listing serves the ACL check and the xattr values
+        const char *names = nullptr;
+        ssize_t     size = -1;
+        if ((flags & (COLLECT_ACL | COLLECT_XATTRS)) != 0)
+            size = fd_listxattr_scratch(entry.fd, &names);
+        if ((flags & COLLECT_ACL) != 0 && !S_ISLNK(st.st_mode)) {
+            if ((flags & COLLECT_ACL_RAW) != 0)
+                put_raw_acls(w, entry.fd, st, names, size);
+            else
+                put_acls(w, entry.fd, st, names, size);
+        }
+        if ((flags & COLLECT_XATTRS) != 0 && size >= 0)
+            put_xattr_values(w, entry.fd, names, size, (flags & COLLECT_XATTRS) >> 4, 6, 7);
+        if ((flags & COLLECT_LINK) != 0 && S_ISLNK(st.st_mode))
+            put_link(w, entry.fd, st);
+        if (!w.ok())
+            return ENOMEM;
+        *data = w.release(length);
+        return 0;
+    } catch (const std::bad_alloc &) {
+        return ENOMEM;
+    }
+}
+}
+}  // namespace OsCalls
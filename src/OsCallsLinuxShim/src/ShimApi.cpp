@@ -0,0 +1,94 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "ShimApi.h"
+#include "Acl.h"
+#include "UserGroupDatabase.h"
+#include "ValuePool.h"
+#include "Xattr.h"
+#include <cerrno>
+#include <cstring>
+
+namespace OsCalls {
+namespace {
+// Local copy of GetNextValue: managed code iterates cursors through the
+// table without a call into OsCallsCommonShim per value.
+bool shim_get_next_value(ValueT *value) {
+    return next_value(value);
+}
+
+const LinuxShimApi kApi = {
+    sizeof(LinuxShimApi),
+    LINUX_SHIM_API_VERSION,
+    shim_get_next_value,
+    ReleaseHandle,
+    FreeBuffer,
+    linux_lstat,
+    linux_lstat_into,
+    linux_lstat_packed,
+    linux_readlink,
+    linux_canonicalize_file_name,
+    linux_llistxattr,
+    linux_llistxattr_packed,
+    linux_lgetxattr,
+    linux_acl_get_file_access,
+    linux_acl_get_file_default,
+    linux_getpwuid,
+    linux_getpwuid_packed,
+    linux_getgrgid,
+    linux_getgrgid_packed,
+    linux_acl_get_file_access_packed,
+    linux_acl_get_file_default_packed,
+    linux_opendir_handle,
+    linux_openat_handle,
+    linux_openat_read,
+    linux_close_handle,
+    linux_fstatat_into,
+    linux_readlinkat,
+    linux_flistxattr_packed,
+    linux_fgetxattr,
+    linux_acl_get_access_at_packed,
+    linux_acl_get_default_at_packed,
+    linux_read_directory,
+    linux_walk_open,
+    linux_walk_take,
+    linux_walk_close,
+    linux_statx,
+    linux_fs_is_remote,
+    linux_data_offsets,
+    linux_collect_inode,
+    linux_lgetxattrs_packed,
+    linux_fgetxattrs_packed,
+    linux_user_name_packed,
+    linux_group_name_packed,
+    linux_name_cache_configure,
+    linux_name_cache_preload,
+    linux_open_content,
+    linux_read_content,
+    linux_find_data,
+};
+}  // namespace
+
+extern "C" {
+/**
+ * @brief Hands out the dispatch table described in ShimApi.h.
+ *
+ * Copies at most table->size bytes, so a caller built against an older,
+ * shorter table is never overrun, and sets table->size to the number of
+ * bytes actually provided.
+ *
+ * @param version Version the caller was built against.
+ * @param table Caller-allocated table with its size field set.
+ * @return 0 on success, otherwise an errno value.
+ */
+int linux_shim_get_api(uint32_t version, LinuxShimApi *table) {
+    if (table == nullptr || table->size < offsetof(LinuxShimApi, get_next_value))
+        return EINVAL;
+    if (version != LINUX_SHIM_API_VERSION)
+        return ENOTSUP;
+    auto size = table->size < sizeof(LinuxShimApi) ? table->size : uint32_t(sizeof(LinuxShimApi));
+    std::memcpy(table, &kApi, size);
+    table->size = size;
+    return 0;
+}
+}  // extern "C"
+}  // namespace OsCalls
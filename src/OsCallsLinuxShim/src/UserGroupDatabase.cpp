@@ -1,144 +1,231 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "UserGroupDatabase.h"
+#include "Schemas.h"
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <grp.h>
+#include <mutex>
+#include <new>
 #include <pwd.h>
+#include <shared_mutex>
+#include <string>
 #include <unistd.h>
+#include <unordered_map>
 
 namespace OsCalls {
+// Buffer size hints, grown on ERANGE; per thread so concurrent lookups never
+// see a size another thread is changing
+thread_local auto pwbufsz = sysconf(_SC_GETPW_R_SIZE_MAX);
+thread_local auto grbufsz = sysconf(_SC_GETGR_R_SIZE_MAX);
+
 /**
- * @brief Handler for passwd structure results - iterates through passwd fields.
+ * @brief Looks up a passwd entry into one pooled block.
  *
- * Yields passwd structure fields sequentially (pw_name, pw_passwd, pw_uid,
- * pw_gid, pw_gecos, pw_dir, pw_shell). Cleans up allocated passwd buffer
- * and string buffer on completion.
+ * Uses getpwuid_r (thread-safe) with automatic buffer resizing on ERANGE. The
+ * record is followed by its string storage in the same AllocBuffer block, so
+ * one FreeBuffer releases both. An unknown uid yields a zeroed record.
  *
- * @param value Pointer to ValueT with Handle.data1 containing passwd* and data2
- * containing char* buffer.
- * @return true if more fields remain, false when iteration completes.
+ * @param uid Numeric user ID to look up.
+ * @param en Receives 0 or the errno value.
+ * @param found Receives whether an entry exists.
+ * @return The block (also on error, possibly nullptr); free with FreeBuffer.
  */
-bool handle_passwd(ValueT *value) {
-    auto pw = reinterpret_cast<passwd *>(value->Handle.data1);
-    switch (value->Handle.index) {
-    case 0:
-        if (value->Type == TypeT::IsOk) {
-            set_val(String, "pw_name", pw->pw_name);
-            return true;
+passwd *lookup_pwuid(int64_t uid, int *en, bool *found) {
+    if (pwbufsz <= 0)
+        pwbufsz = 1024;
+    struct passwd *pwbufp = nullptr;
+    passwd        *pwbuf = nullptr;
+    do {
+        pwbuf = static_cast<passwd *>(AllocBuffer(sizeof(passwd) + pwbufsz));
+        if (pwbuf == nullptr) {
+            *en = ENOMEM;
+            break;
         }
-    // else fall through
-    default:
-        delete reinterpret_cast<passwd *>(value->Handle.data1);
-        delete[] reinterpret_cast<char *>(value->Handle.data2);
-        delete value;
-        return false;
-    case 1:
-        set_val(String, "pw_passwd", pw->pw_passwd);
-        return true;
-    case 2:
-        set_val(Number, "pw_uid", pw->pw_uid);
-        return true;
-    case 3:
-        set_val(Number, "pw_gid", pw->pw_gid);
-        return true;
-    case 4:
-        set_val(String, "pw_gecos", pw->pw_gecos);
-        return true;
-    case 5:
-        set_val(String, "pw_dir", pw->pw_dir);
-        return true;
-    case 6:
-        set_val(String, "pw_shell", pw->pw_shell);
-        return true;
-    }
+        *pwbuf = passwd{};
+        *en = ::getpwuid_r(uid, pwbuf, reinterpret_cast<char *>(pwbuf + 1), pwbufsz, &pwbufp);
+        if (*en == ERANGE) {
+            pwbufsz <<= 1;
+            FreeBuffer(pwbuf);
+        }
+    } while (*en == ERANGE);
+    *found = pwbufp != nullptr;
+    return pwbuf;
 }
 
 /**
- * @brief Handler for group member list - iterates through gr_mem array.
+ * @brief Looks up a group entry into one pooled block.
  *
- * Yields group member names as string array elements until reaching
- * null terminator.
+ * Same scheme as lookup_pwuid, using getgrgid_r.
  *
- * @param value Pointer to ValueT with Handle.data1 containing char** member
- * list.
- * @return true if more members remain, false at null terminator.
+ * @param gid Numeric group ID to look up.
+ * @param en Receives 0 or the errno value.
+ * @param found Receives whether an entry exists.
+ * @return The block (also on error, possibly nullptr); free with FreeBuffer.
  */
-bool handle_group_mem(OsCalls::ValueT *value) {
-    auto mem = reinterpret_cast<char **>(value->Handle.data1);
-    if (mem[value->Handle.index] == nullptr) {
-        delete value;
-        return false;
-    }
-    set_val(String, "[]", mem[value->Handle.index]);
-    return true;
+group *lookup_grgid(int64_t gid, int *en, bool *found) {
+    if (grbufsz <= 0)
+        grbufsz = 1024;
+    struct group *grbufp = nullptr;
+    group        *grbuf = nullptr;
+    do {
+        grbuf = static_cast<group *>(AllocBuffer(sizeof(group) + grbufsz));
+        if (grbuf == nullptr) {
+            *en = ENOMEM;
+            break;
+        }
+        *grbuf = group{};
+        *en = ::getgrgid_r(gid, grbuf, reinterpret_cast<char *>(grbuf + 1), grbufsz, &grbufp);
+        if (*en == ERANGE) {
+            grbufsz <<= 1;
+            FreeBuffer(grbuf);
+        }
+    } while (*en == ERANGE);
+    *found = grbufp != nullptr;
+    return grbuf;
 }
 
+namespace {
+using Clock = std::chrono::steady_clock;
+
 /**
- * @brief Handler for group structure results - iterates through group fields.
- *
- * Yields group structure fields sequentially (gr_name, gr_gid, gr_mem).
- * The gr_mem field is a complex nested array handled by handle_group_mem.
- * Cleans up allocated group buffer and string buffer on completion.
- *
- * @param value Pointer to ValueT with Handle.data1 containing group* and data2
- * containing char* buffer.
- * @return true if more fields remain, false when iteration completes.
+ * @brief id -> name map of one database; unknown ids are cached as well
+ * (negative entries), lookup errors are not.
+ */
+struct NameCache {
+    struct Entry {
+        std::string       name;
+        bool              found;
+        Clock::time_point expires;
+    };
+
+    std::shared_mutex                  mutex;
+    std::unordered_map<int64_t, Entry> entries;
+
+    void clear() {
+        std::unique_lock lock(mutex);
+        entries.clear();
+    }
+
+    void put(int64_t id, const char *name, Clock::time_point expires) {
+        std::unique_lock lock(mutex);
+        entries[id] = Entry{name != nullptr ? name : "", name != nullptr, expires};
+    }
+};
+
+NameCache userNames;
+NameCache groupNames;
+
+// Seconds a found / an unknown id is remembered; 0 disables that kind
+std::atomic<int64_t> nameTtl{600};
+std::atomic<int64_t> negativeTtl{60};
+
+// getpwent / getgrent keep their position in global state
+std::mutex enumerateMutex;
+
+/**
+ * @brief Name of @p id from @p cache, else from @p lookup (lookup_pwuid or
+ * lookup_grgid), remembered for the configured time.
  */
-bool handle_group(ValueT *value) {
-    auto gr = reinterpret_cast<group *>(value->Handle.data1);
-    switch (value->Handle.index) {
-    case 0:
-        if (value->Type == TypeT::IsOk) {
-            set_val(String, "gr_name", gr->gr_name);
-            return true;
+template <typename Record, typename Lookup, typename Name>
+bool cached_name(NameCache &cache, int64_t id, std::string &name, int *en, Lookup lookup, Name nameOf) {
+    auto now = Clock::now();
+    {
+        std::shared_lock lock(cache.mutex);
+        auto             it = cache.entries.find(id);
+        if (it != cache.entries.end() && it->second.expires > now) {
+            *en = 0;
+            if (it->second.found)
+                name = it->second.name;
+            return it->second.found;
         }
-    // else fall through
-    default:
-        delete reinterpret_cast<group *>(value->Handle.data1);
-        delete[] reinterpret_cast<char *>(value->Handle.data2);
-        delete value;
+    }
+
+    auto    found = false;
+    Record *record = lookup(id, en, &found);
+    if (*en == 0 && found)
+        name = nameOf(*record);
+    FreeBuffer(record);
+    if (*en != 0)
+        return false;
+    auto ttl = found ? nameTtl.load() : negativeTtl.load();
+    if (ttl > 0)
+        cache.put(id, found ? name.c_str() : nullptr, now + std::chrono::seconds(ttl));
+    return found;
+}
+
+// Schema Passwd / Group with just the id and the name (or no fields if unknown)
+int name_packed(Schema schema, int64_t id, bool found, const std::string &name, uint8_t **data, int64_t *length) {
+    PackedWriter w(uint32_t(schema), name.size() + 32);
+    if (found) {
+        w.put_string(1, name.c_str());
+        w.put_int(schema == Schema::Passwd ? 3 : 2, id);
+    }
+    if (!w.ok())
+        return ENOMEM;
+    *data = w.release(length);
+    return 0;
+}
+
+// Bytes of the lookup block after @p gr that the record uses. All its strings
+// and the gr_mem array lie there without overlapping, so the string furthest
+// in ends the strings; no string but that one needs measuring.
+size_t group_extent(const group &gr) {
+    std::less<const char *> before;
+    auto                    base = reinterpret_cast<const char *>(&gr + 1);
+    const char             *last = nullptr;
+    auto                    take = [&](const char *s) {
+        if (s != nullptr && (last == nullptr || before(last, s)))
+            last = s;
+    };
+    take(gr.gr_name);
+    take(gr.gr_passwd);
+    auto mem = gr.gr_mem;
+    for (; mem != nullptr && *mem != nullptr; ++mem)
+        take(*mem);
+    auto end = last != nullptr ? last + std::strlen(last) + 1 : base;
+    if (mem != nullptr)
+        end = std::max(end, reinterpret_cast<const char *>(mem + 1), before);
+    return before(base, end) ? size_t(end - base) : 0;
+}
+}  // namespace
+
+bool user_name(int64_t uid, std::string &name, int *en) {
+    try {
+        return cached_name<passwd>(userNames, uid, name, en, lookup_pwuid, [](const passwd &p) { return p.pw_name; });
+    } catch (const std::bad_alloc &) {
+        *en = ENOMEM;
         return false;
-    case 1:
-        set_val(Number, "gr_gid", gr->gr_gid);
-        return true;
-    case 2:
-        set_val(Complex, "gr_mem", new ValueT());
-        CreateHandle(value->Complex, handle_group_mem, gr->gr_mem, nullptr);
-        value->Complex->Type = TypeT::IsOk;
-        return true;
     }
 }
 
-auto pwbufsz = sysconf(_SC_GETPW_R_SIZE_MAX);
-auto grbufsz = sysconf(_SC_GETGR_R_SIZE_MAX);
+bool group_name(int64_t gid, std::string &name, int *en) {
+    try {
+        return cached_name<group>(groupNames, gid, name, en, lookup_grgid, [](const group &g) { return g.gr_name; });
+    } catch (const std::bad_alloc &) {
+        *en = ENOMEM;
+        return false;
+    }
+}
 
 extern "C" {
 /**
  * @brief Queries the passwd database for a user ID.
  *
- * Uses getpwuid_r (thread-safe) with automatic buffer resizing on ERANGE.
- * Returns passwd structure fields via ValueT cursor.
+ * Returns passwd structure fields (kPasswdFields) via ValueT cursor.
  *
  * @param uid Numeric user ID to look up.
  * @return ValueT* cursor with passwd fields or error number.
  */
 ValueT *linux_getpwuid(int64_t uid) {
-    if (pwbufsz <= 0)
-        pwbufsz = 1024;
-    auto           pwbuf = new passwd();
-    struct passwd *pwbufp = nullptr;
-    auto           en = 0;
-    char          *strbuf = nullptr;
-    do {
-        strbuf = new char[pwbufsz];
-        en = ::getpwuid_r(uid, pwbuf, strbuf, pwbufsz, &pwbufp);
-        if (en == ERANGE) {
-            pwbufsz <<= 1;
-            delete[] strbuf;
-        }
-    } while (en == ERANGE);
-    auto v = new ValueT();
-    CreateHandle(v, handle_passwd, pwbuf, strbuf);
+    auto en = 0;
+    auto found = false;
+    auto pwbuf = lookup_pwuid(uid, &en, &found);
+    auto v = NewHandle(handle_table<kPasswdFields>, ReleaseBuffer, pwbuf, nullptr);
     if (en == 0)
         v->Type = TypeT::IsOk;
     else
@@ -151,32 +238,47 @@ ValueT *getpwuid(int64_t uid) {
     return linux_getpwuid(uid);
 };
 
+/**
+ * @brief Queries the passwd database and returns the packed encoding.
+ *
+ * Schema Passwd (kPasswdFields). An unknown uid succeeds with no fields.
+ *
+ * @param uid Numeric user ID to look up.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_getpwuid_packed(int64_t uid, uint8_t **data, int64_t *length) {
+    auto en = 0;
+    auto found = false;
+    auto pwbuf = lookup_pwuid(uid, &en, &found);
+    if (en == 0) {
+        PackedWriter w(uint32_t(Schema::Passwd));
+        if (found)
+            encode_table<kPasswdFields>(w, *pwbuf);
+        if (w.ok())
+            *data = w.release(length);
+        else
+            en = ENOMEM;
+    }
+    FreeBuffer(pwbuf);
+    return en;
+};
+
 /**
  * @brief Queries the group database for a group ID.
  *
- * Uses getgrgid_r (thread-safe) with automatic buffer resizing on ERANGE.
- * Returns group structure fields including member list via ValueT cursor.
+ * Returns group structure fields (kGroupFields) including the member list via
+ * ValueT cursor.
  *
  * @param gid Numeric group ID to look up.
  * @return ValueT* cursor with group fields or error number.
  */
 ValueT *linux_getgrgid(int64_t gid) {
-    if (grbufsz <= 0)
-        grbufsz = 1024;
-    auto          grbuf = new group();
-    struct group *grbufp = nullptr;
-    auto          en = 0;
-    char         *strbuf = nullptr;
-    do {
-        strbuf = new char[grbufsz];
-        en = ::getgrgid_r(gid, grbuf, strbuf, grbufsz, &grbufp);
-        if (en == ERANGE) {
-            grbufsz <<= 1;
-            delete[] strbuf;
-        }
-    } while (en == ERANGE);
-    auto v = new ValueT();
-    CreateHandle(v, handle_group, grbuf, strbuf);
+    auto en = 0;
+    auto found = false;
+    auto grbuf = lookup_grgid(gid, &en, &found);
+    auto v = NewHandle(handle_table<kGroupFields>, ReleaseBuffer, grbuf, nullptr);
     if (en == 0)
         v->Type = TypeT::IsOk;
     else
@@ -188,5 +290,101 @@ ValueT *linux_getgrgid(int64_t gid) {
 ValueT *getgrgid(int64_t gid) {
     return linux_getgrgid(gid);
 };
+
+/**
+ * @brief Queries the group database and returns the packed encoding.
+ *
+ * Schema Group (kGroupFields); gr_mem becomes repeated field 3. An unknown
+ * gid succeeds with no fields.
+ *
+ * @param gid Numeric group ID to look up.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_getgrgid_packed(int64_t gid, uint8_t **data, int64_t *length) {
+    auto en = 0;
+    auto found = false;
+    auto grbuf = lookup_grgid(gid, &en, &found);
+    if (en == 0) {
+        // Sized once: each member takes its NUL and a pointer in the lookup block, more than its tag and length
+        // in the encoding, so the used part of the block plus room for the name's prefix, the gid and the
+        // writer's slack holds it. A large gr_mem list would otherwise double the buffer many times.
+        PackedWriter w(uint32_t(Schema::Group), found ? group_extent(*grbuf) + 64 : 16);
+        if (found)
+            encode_table<kGroupFields>(w, *grbuf);
+        if (w.ok())
+            *data = w.release(length);
+        else
+            en = ENOMEM;
+    }
+    FreeBuffer(grbuf);
+    return en;
+};
+
+/**
+ * @brief User name of a uid through the name cache; see UserGroupDatabase.h.
+ */
+int linux_user_name_packed(int64_t uid, uint8_t **data, int64_t *length) {
+    auto        en = 0;
+    std::string name;
+    auto        found = user_name(uid, name, &en);
+    return en != 0 ? en : name_packed(Schema::Passwd, uid, found, name, data, length);
+}
+
+/**
+ * @brief Group name of a gid through the name cache, without gr_mem.
+ */
+int linux_group_name_packed(int64_t gid, uint8_t **data, int64_t *length) {
+    auto        en = 0;
+    std::string name;
+    auto        found = group_name(gid, name, &en);
+    return en != 0 ? en : name_packed(Schema::Group, gid, found, name, data, length);
+}
+
+/**
+ * @brief Sets the name cache lifetimes and drops everything cached so far.
+ */
+int linux_name_cache_configure(int64_t ttl_seconds, int64_t negative_ttl_seconds) {
+    if (ttl_seconds < 0 || negative_ttl_seconds < 0)
+        return EINVAL;
+    nameTtl = ttl_seconds;
+    negativeTtl = negative_ttl_seconds;
+    userNames.clear();
+    groupNames.clear();
+    return 0;
+}
+
+/**
+ * @brief Fills the name cache from a full getpwent / getgrent enumeration.
+ */
+int linux_name_cache_preload(int32_t *users, int32_t *groups) {
+    *users = 0;
+    *groups = 0;
+    auto ttl = nameTtl.load();
+    if (ttl <= 0)
+        return 0;
+    try {
+        std::lock_guard lock(enumerateMutex);
+        auto            expires = Clock::now() + std::chrono::seconds(ttl);
+        ::setpwent();
+        while (auto pw = ::getpwent()) {
+            userNames.put(pw->pw_uid, pw->pw_name, expires);
+            ++*users;
+        }
+        ::endpwent();
+        ::setgrent();
+        while (auto gr = ::getgrent()) {
+            groupNames.put(gr->gr_gid, gr->gr_name, expires);
+            ++*groups;
+        }
+        ::endgrent();
+        return 0;
+    } catch (const std::bad_alloc &) {
+        ::endpwent();
+        ::endgrent();
+        return ENOMEM;
+    }
+}
 }
 }  // namespace OsCalls
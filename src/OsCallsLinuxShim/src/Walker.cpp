@@ -0,0 +1,338 @@
+#include "Platform.h"
+// Platform.h must come first
+#include "Walker.h"
+#include "FileSystem.h"
+#include "ValuePool.h"
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace OsCalls {
+namespace {
+constexpr int64_t kDefaultMaxBuffered = int64_t(256) << 20;
+
+struct DirKey {
+    int64_t dev;
+    int64_t ino;
+
+    bool operator==(const DirKey &other) const { return dev == other.dev && ino == other.ino; }
+};
+
+struct DirKeyHash {
+    size_t operator()(const DirKey &key) const {
+        return std::hash<int64_t>()(key.ino) ^ (std::hash<int64_t>()(key.dev) << 1);
+    }
+};
+
+struct Task {
+    std::string path;
+    DirKey      key;
+};
+
+// Directories stay in the map once taken, so a directory reachable twice
+// (bind mounts) is listed only once.
+enum class State { Queued, Running, Ready, Taken };
+
+struct Listing {
+    State    state = State::Queued;
+    int      rc = 0;
+    uint8_t *data = nullptr;
+    int64_t  length = 0;
+};
+
+// A worker's deque. Tasks are whole directories, so a mutex per deque costs
+// little next to the syscalls behind each task.
+struct WorkQueue {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+};
+
+std::string join_path(const std::string &dir, const char *name) {
+    std::string path = dir;
+    if (path.empty() || path.back() != '/')
+        path += '/';
+    return path += name;
+}
+
+class Walker {
+  public:
+    Walker(const char *const *excluded, int32_t excludedCount, size_t threads, int64_t maxBuffered)
+        : maxBuffered_(maxBuffered) {
+        for (int32_t i = 0; i < excludedCount; ++i) {
+            std::string path = excluded[i];
+            while (path.size() > 1 && path.back() == '/')
+                path.pop_back();
+            excluded_.push_back(std::move(path));
+        }
+        for (size_t i = 0; i < threads; ++i)
+            queues_.push_back(std::make_unique<WorkQueue>());
+    }
+
+    ~Walker() {
+        stop_ = true;
+        {
+            std::lock_guard<std::mutex> lock(workMutex_);
+        }
+        workReady_.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        spaceFreed_.notify_all();
+        for (auto &thread : threads_)
+            thread.join();
+        for (auto &entry : listings_)
+            FreeBuffer(entry.second.data);
+    }
+
+    // Roots are added before start(): workers read devices_ without locking.
+    void add_roots(const char *const *roots, int32_t rootCount) {
+        std::vector<std::pair<const char *, DirKey>> dirs;
+        for (int32_t i = 0; i < rootCount; ++i) {
+            struct stat st;
+            if (::lstat(roots[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+                dirs.emplace_back(roots[i], DirKey{int64_t(st.st_dev), int64_t(st.st_ino)});
+                devices_.push_back(int64_t(st.st_dev));
+            }
+        }
+        for (auto &dir : dirs)
+            schedule(dir.first, dir.second);
+    }
+
+    void start() {
+        for (size_t i = 0; i < queues_.size(); ++i)
+            threads_.emplace_back([this, i] { run(i); });
+    }
+
+    int take(const char *path, DirKey key, uint8_t **data, int64_t *length) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         it = listings_.find(key);
+        if (it == listings_.end()) {
+            listings_[key].state = State::Taken;
+        } else if (it->second.state == State::Queued || it->second.state == State::Taken) {
+            it->second.state = State::Taken;
+        } else {
+            // Node-based map: the reference survives rehashing by workers.
+            auto &listing = it->second;
+            listingReady_.wait(lock, [&] { return listing.state == State::Ready; });
+            listing.state = State::Taken;
+            buffered_ -= listing.length;
+            int  rc = listing.rc;
+            auto buffer = listing.data;
+            auto bufferLength = listing.length;
+            listing.data = nullptr;
+            lock.unlock();
+            spaceFreed_.notify_all();
+            if (rc == 0) {
+                *data = buffer;
+                *length = bufferLength;
+                return 0;
+            }
+            // The prefetch failed or found another directory at this path:
+            // read again below so the caller gets the current result.
+        }
+        if (lock.owns_lock())
+            lock.unlock();
+        return read(path, nullptr, next_queue(), data, length);
+    }
+
+  private:
+    struct SubdirContext {
+        Walker            *walker;
+        const std::string *parent;
+        size_t             queue;
+    };
+
+    static void on_subdir(void *context, const char *name, const StatRecord &st) {
+        auto ctx = static_cast<SubdirContext *>(context);
+        ctx->walker->schedule(join_path(*ctx->parent, name), DirKey{st.st_dev, st.st_ino}, ctx->queue);
+    }
+
+    // Lists @p path and queues its subdirectories on @p queue. With @p expected,
+    // a directory other than the one queued (replaced meanwhile) is ESTALE.
+    int read(const std::string &path, const DirKey *expected, size_t queue, uint8_t **data, int64_t *length) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | (expected != nullptr ? O_NOFOLLOW : 0));
+        if (fd < 0)
+            return errno;
+        struct stat st;
+        int         rc = 0;
+        if (expected != nullptr && (::fstat(fd, &st) != 0 || int64_t(st.st_dev) != expected->dev ||
+                                    int64_t(st.st_ino) != expected->ino))
+            rc = ESTALE;
+        if (rc == 0) {
+            SubdirContext context{this, &path, queue};
+            rc = read_directory_fd(fd, READ_DIRECTORY_STAT, data, length, on_subdir, &context);
+        }
+        ::close(fd);
+        return rc;
+    }
+
+    bool wanted(const std::string &path, int64_t dev) const {
+        bool onDevice = false;
+        for (auto d : devices_)
+            onDevice = onDevice || d == dev;
+        if (!onDevice)
+            return false;
+        for (auto &ex : excluded_)
+            if (path.compare(0, ex.size(), ex) == 0 && (path.size() == ex.size() || path[ex.size()] == '/'))
+                return false;
+        return true;
+    }
+
+    void schedule(std::string path, DirKey key, size_t queue = SIZE_MAX) {
+        if (!wanted(path, key.dev))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!listings_.emplace(key, Listing{}).second)
+                return;
+        }
+        auto &target = *queues_[queue < queues_.size() ? queue : next_queue()];
+        {
+            std::lock_guard<std::mutex> lock(target.mutex);
+            target.tasks.push_back(Task{std::move(path), key});
+            ++queued_;
+        }
+        {
+            std::lock_guard<std::mutex> lock(workMutex_);
+        }
+        workReady_.notify_one();
+    }
+
+    size_t next_queue() { return nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size(); }
+
+    // Own deque from the front (breadth-first, the order the traversal takes
+    // listings in); otherwise steal from the back of another worker's deque.
+    bool next_task(size_t self, Task &task) {
+        for (size_t n = 0; n < queues_.size(); ++n) {
+            auto                       &queue = *queues_[(self + n) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            if (n == 0) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            --queued_;
+            return true;
+        }
+        return false;
+    }
+
+    void run(size_t self) {
+        while (!stop_) {
+            Task task;
+            if (!next_task(self, task)) {
+                std::unique_lock<std::mutex> lock(workMutex_);
+                workReady_.wait(lock, [this] { return stop_ || queued_ > 0; });
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                spaceFreed_.wait(lock, [this] { return stop_ || buffered_ < maxBuffered_; });
+                auto &listing = listings_[task.key];
+                if (stop_ || listing.state != State::Queued)
+                    continue;  // taken by the traversal meanwhile
+                listing.state = State::Running;
+            }
+            uint8_t *data = nullptr;
+            int64_t  length = 0;
+            int      rc = read(task.path, &task.key, self, &data, &length);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto                       &listing = listings_[task.key];
+                listing.rc = rc;
+                listing.data = rc == 0 ? data : nullptr;
+                listing.length = rc == 0 ? length : 0;
+                listing.state = State::Ready;
+                buffered_ += listing.length;
+            }
+            listingReady_.notify_all();
+        }
+    }
+
+    const int64_t            maxBuffered_;
+    std::vector<std::string> excluded_;
+    std::vector<int64_t>     devices_;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread>                threads_;
+    std::atomic<size_t>                     nextQueue_{0};
+    std::atomic<bool>                       stop_{false};
+
+    // Idle workers sleep here until something is queued.
+    std::mutex              workMutex_;
+    std::condition_variable workReady_;
+    std::atomic<int64_t>    queued_{0};
+
+    // Guards listings_ and buffered_.
+    std::mutex                                        mutex_;
+    std::condition_variable                           listingReady_;
+    std::condition_variable                           spaceFreed_;
+    std::unordered_map<DirKey, Listing, DirKeyHash> listings_;
+    int64_t                                           buffered_ = 0;
+};
+}  // namespace
+
+extern "C" {
+/**
+ * @brief Creates a walker and starts its threads; see Walker.h.
+ */
+int linux_walk_open(const char *const *roots, int32_t rootCount, const char *const *excluded, int32_t excludedCount,
+                    int32_t threads, int64_t maxBuffered, int64_t *walker) {
+    if (rootCount < 0 || excludedCount < 0 || threads < 0 || walker == nullptr)
+        return EINVAL;
+    if (threads == 0) {
+        auto cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? int32_t(cpus) : 1;
+    }
+    try {
+        auto w = std::make_unique<Walker>(excluded, excludedCount, size_t(threads),
+                                          maxBuffered > 0 ? maxBuffered : kDefaultMaxBuffered);
+        w->add_roots(roots, rootCount);
+        w->start();
+        *walker = reinterpret_cast<intptr_t>(w.release());
+        return 0;
+    } catch (const std::bad_alloc &) {
+        return ENOMEM;
+    } catch (const std::system_error &e) {
+        return e.code().value() != 0 ? e.code().value() : EAGAIN;
+    }
+}
+
+/**
+ * @brief Hands over (or reads) the listing of one directory; see Walker.h.
+ */
+int linux_walk_take(int64_t walker, const char *path, int64_t dev, int64_t ino, uint8_t **data, int64_t *length) {
+    if (walker == 0 || path == nullptr)
+        return EINVAL;
+    try {
+        return reinterpret_cast<Walker *>(walker)->take(path, DirKey{dev, ino}, data, length);
+    } catch (const std::bad_alloc &) {
+        return ENOMEM;
+    }
+}
+
+/**
+ * @brief Joins the worker threads and frees the walker; see Walker.h.
+ */
+int linux_walk_close(int64_t walker) {
+    delete reinterpret_cast<Walker *>(walker);
+    return 0;
+}
+}
+}  // namespace OsCalls
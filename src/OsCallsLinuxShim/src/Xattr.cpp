@@ -1,14 +1,23 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "Xattr.h"
+#include "Schemas.h"
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 #include <sys/xattr.h>
+#include <vector>
 
 namespace OsCalls {
 /**
- * @brief Context structure for llistxattr iteration
+ * @brief Context structure for llistxattr iteration.
+ *
+ * Lives at the start of a single pooled buffer; the attribute names follow
+ * it directly, so one FreeBuffer releases both.
  */
 struct XattrListContext {
     char *buffer;   // Original buffer start
@@ -20,8 +29,8 @@ struct XattrListContext {
  * @brief Handler for llistxattr that returns an array of attribute names.
  *
  * Iterates through null-terminated attribute names in the buffer, yielding
- * each as a string array element. Cleans up allocated buffer and context
- * on completion.
+ * each as a string array element. The context buffer is freed by
+ * ReleaseHandle.
  *
  * @param value Pointer to ValueT with Handle.data1 containing
  * XattrListContext*.
@@ -54,84 +63,268 @@ bool handle_llistxattr(ValueT *value) {
         return true;
     }
 
-    // Cleanup on completion
-    if (ctx != nullptr) {
-        if (ctx->buffer != nullptr)
-            free(ctx->buffer);
-        delete ctx;
-    }
-    delete value;
     return false;
 }
 
 /**
- * @brief Handler for lgetxattr that returns the attribute value as a string.
+ * @brief Handler for lgetxattr that returns the attribute value as bytes.
  *
- * Yields a single string value containing the extended attribute's data.
- * Uses ::free() to release the malloc'd buffer.
+ * Yields a single IsBytes value with the exact attribute length, so binary
+ * values (e.g. security.capability) pass through unmodified. The pooled
+ * buffer is freed by ReleaseHandle.
  *
- * @param value Pointer to ValueT with Handle.data1 containing char* attribute
- * value.
+ * @param value Pointer to ValueT with Handle.data1 containing the attribute
+ * bytes and Handle.data2 holding their length.
  * @return true on first call if successful, false to signal completion.
  */
 bool handle_lgetxattr(ValueT *value) {
-    auto attr_value = reinterpret_cast<char *>(value->Handle.data1);
+    auto attr_value = reinterpret_cast<const char *>(value->Handle.data1);
+    auto attr_len = reinterpret_cast<intptr_t>(value->Handle.data2);
     switch (value->Handle.index) {
     case 0:
         if (value->Type == TypeT::IsOk) {
-            set_val(String, "value", attr_value);
+            set_bytes("value", attr_value, attr_len);
             return true;
         }
     // else fall through
     default:
-        if (attr_value != nullptr)
-            free(attr_value);
-        delete value;
         return false;
     }
 }
 
+// /proc/self/fd path of a descriptor, for the fallbacks below
+struct ProcFdPath {
+    char path[32];
+    explicit ProcFdPath(int fd) { std::snprintf(path, sizeof path, "/proc/self/fd/%d", fd); }
+};
+
+// Set once flistxattr/fgetxattr rejected a descriptor the fallback accepted,
+// so later calls skip the failing first try.
+static std::atomic<bool> fdXattrUnsupported{false};
+
+// flistxattr/fgetxattr on O_PATH descriptors fail with EBADF on kernels that
+// do not support them there; the (followed) /proc/self/fd magic link leads
+// straight to the same inode, also for symlinks, without a path walk.
+ssize_t fd_listxattr(int fd, char *list, size_t size) {
+    if (!fdXattrUnsupported.load(std::memory_order_relaxed)) {
+        auto n = ::flistxattr(fd, list, size);
+        if (n >= 0 || errno != EBADF)
+            return n;
+        n = ::listxattr(ProcFdPath(fd).path, list, size);
+        if (n >= 0 || errno != ENOENT)
+            fdXattrUnsupported.store(true, std::memory_order_relaxed);
+        return n;
+    }
+    return ::listxattr(ProcFdPath(fd).path, list, size);
+}
+
+ssize_t fd_getxattr(int fd, const char *name, void *value, size_t size) {
+    if (!fdXattrUnsupported.load(std::memory_order_relaxed)) {
+        auto n = ::fgetxattr(fd, name, value, size);
+        if (n >= 0 || errno != EBADF)
+            return n;
+        n = ::getxattr(ProcFdPath(fd).path, name, value, size);
+        if (n >= 0 || errno != ENOENT)
+            fdXattrUnsupported.store(true, std::memory_order_relaxed);
+        return n;
+    }
+    return ::getxattr(ProcFdPath(fd).path, name, value, size);
+}
+
+namespace {
+// Names and values are at most XATTR_LIST_MAX / XATTR_SIZE_MAX (64 KiB), so
+// the per-thread scratch buffers stay small and are never shrunk.
+constexpr size_t kInitialScratch = 1024;
+
+thread_local std::vector<char> tlsNames;
+thread_local std::vector<char> tlsValue;
+
+/**
+ * Runs @p fetch (list/getxattr(2) semantics) into @p scratch: a single call
+ * when the result fits, a size query and another try only on ERANGE (the
+ * attribute may grow again in between, hence the loop).
+ */
+template <typename Fetch> ssize_t fetch_scratch(std::vector<char> &scratch, Fetch fetch) {
+    try {
+        if (scratch.empty())
+            scratch.resize(kInitialScratch);
+        for (;;) {
+            auto n = fetch(scratch.data(), scratch.size());
+            if (n >= 0 || errno != ERANGE)
+                return n;
+            n = fetch(nullptr, 0);
+            if (n < 0)
+                return n;
+            scratch.resize(std::max(scratch.size() * 2, size_t(n)));
+        }
+    } catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+        return -1;
+    }
+}
+
+struct Namespace {
+    const char *prefix;
+    size_t      length;
+    uint32_t    flag;
+};
+
+constexpr Namespace kNamespaces[] = {
+    {"user.", 5, XATTR_NS_USER},
+    {"trusted.", 8, XATTR_NS_TRUSTED},
+    {"security.", 9, XATTR_NS_SECURITY},
+    {"system.", 7, XATTR_NS_SYSTEM},
+};
+
+bool in_namespaces(const char *name, uint32_t namespaces) {
+    for (const auto &ns : kNamespaces)
+        if (std::strncmp(name, ns.prefix, ns.length) == 0)
+            return (namespaces & ns.flag) != 0;
+    return false;
+}
+
+// Every wanted name of a listing with its value; get has lgetxattr(2)
+// semantics. An attribute removed since the listing is skipped.
+template <typename Get>
+int put_values(PackedWriter &w, const char *names, ssize_t size, Get get, uint32_t namespaces, uint32_t nameId,
+               uint32_t valueId) {
+    for (auto p = names, end = p + size; p < end && *p != '\0'; p += strlen(p) + 1) {
+        if (!in_namespaces(p, namespaces))
+            continue;
+        auto n = fetch_scratch(tlsValue, [&](char *value, size_t capacity) { return get(p, value, capacity); });
+        if (n < 0) {
+            if (errno == ENOMEM)
+                return ENOMEM;
+            continue;
+        }
+        w.put_string(nameId, p);
+        w.put_bytes(valueId, tlsValue.data(), size_t(n));
+    }
+    return w.ok() ? 0 : ENOMEM;
+}
+
+// Packed attribute name list; list(buffer, size) has llistxattr(2) semantics
+template <typename List> int listxattr_packed(List list, uint8_t **data, int64_t *length) {
+    auto size = fetch_scratch(tlsNames, list);
+    if (size < 0)
+        return errno;
+    PackedWriter w(uint32_t(Schema::XattrList), size_t(size) + 64);
+    for (auto p = tlsNames.data(), end = p + size; p < end && *p != '\0'; p += strlen(p) + 1)
+        w.put_string(1, p);
+    if (!w.ok())
+        return ENOMEM;
+    *data = w.release(length);
+    return 0;
+}
+
+// Packed names and values (schema XattrValues)
+template <typename List, typename Get>
+int getxattrs_packed(List list, Get get, uint32_t namespaces, uint8_t **data, int64_t *length) {
+    auto size = fetch_scratch(tlsNames, list);
+    if (size < 0)
+        return errno;
+    PackedWriter w(uint32_t(Schema::XattrValues), 512);
+    auto         rc = put_values(w, tlsNames.data(), size, get, namespaces, 1, 2);
+    if (rc == 0)
+        *data = w.release(length);
+    return rc;
+}
+
+// IsBytes cursor of one attribute value; get(buffer, size) has lgetxattr(2) semantics
+template <typename Get> ValueT *getxattr_cursor(Get get) {
+    auto  buflen = fetch_scratch(tlsValue, get);
+    auto  en = buflen < 0 ? errno : 0;
+    char *buffer = nullptr;
+    if (buflen > 0) {
+        // The cursor outlives the call: hand over an exactly sized copy
+        buffer = static_cast<char *>(AllocBuffer(buflen));
+        if (buffer == nullptr) {
+            buflen = -1;
+            en = ENOMEM;
+        } else {
+            std::memcpy(buffer, tlsValue.data(), size_t(buflen));
+        }
+    }
+
+    auto v = NewHandle(handle_lgetxattr, ReleaseBuffer, buffer, reinterpret_cast<void *>(intptr_t(buflen)));
+
+    if (buflen >= 0)
+        v->Type = TypeT::IsOk;
+    else
+        v->Number = en;
+
+    return v;
+}
+}  // namespace
+
+ssize_t fd_listxattr_scratch(int fd, const char **names) {
+    auto size = fetch_scratch(tlsNames, [fd](char *list, size_t size) { return fd_listxattr(fd, list, size); });
+    *names = tlsNames.data();
+    return size;
+}
+
+ssize_t fd_getxattr_scratch(int fd, const char *name, const char **value) {
+    auto size = fetch_scratch(tlsValue, [fd, name](char *buffer, size_t capacity) {
+        return fd_getxattr(fd, name, buffer, capacity);
+    });
+    *value = tlsValue.data();
+    return size;
+}
+
+bool xattr_list_contains(const char *names, ssize_t size, const char *name) {
+    for (auto p = names, end = p + size; p < end && *p != '\0'; p += strlen(p) + 1)
+        if (std::strcmp(p, name) == 0)
+            return true;
+    return false;
+}
+
+int put_xattr_values(PackedWriter &w, int fd, const char *names, ssize_t size, uint32_t namespaces, uint32_t nameId,
+                     uint32_t valueId) {
+    return put_values(
+        w, names, size, [fd](const char *name, char *value, size_t n) { return fd_getxattr(fd, name, value, n); },
+        namespaces, nameId, valueId);
+}
+
+int put_xattr_values(PackedWriter &w, int fd, uint32_t namespaces, uint32_t nameId, uint32_t valueId) {
+    const char *names;
+    auto        size = fd_listxattr_scratch(fd, &names);
+    if (size < 0)
+        return errno;
+    return put_xattr_values(w, fd, names, size, namespaces, nameId, valueId);
+}
+
 extern "C" {
 /**
  * @brief Lists all extended attribute names for a path (not following
  * symlinks).
  *
- * Uses llistxattr(2) to retrieve the list of attribute names. The buffer
- * is automatically sized based on the syscall's return value.
+ * Uses llistxattr(2) to retrieve the list of attribute names, normally with
+ * a single call into a per-thread scratch buffer (retried on ERANGE).
  *
  * @param path Filesystem path to read xattrs from.
  * @return ValueT* cursor yielding array of attribute name strings or error
  * number.
  */
 ValueT *linux_llistxattr(const char *path) {
-    errno = 0;
-
-    // First call to get the size needed
-    ssize_t buflen = ::llistxattr(path, nullptr, 0);
-    auto    en = errno;
+    auto buflen = fetch_scratch(tlsNames, [path](char *list, size_t size) { return ::llistxattr(path, list, size); });
+    auto en = buflen < 0 ? errno : 0;
 
-    char             *buffer = nullptr;
     XattrListContext *ctx = nullptr;
 
     if (buflen > 0) {
-        // Allocate buffer and get the attribute names
-        buffer = static_cast<char *>(malloc(buflen));
-        errno = 0;
-        buflen = ::llistxattr(path, buffer, buflen);
-        en = errno;
-
-        if (buflen >= 0) {
-            // Create context structure
-            ctx = new XattrListContext{buffer, buffer, buffer + buflen};
+        // One pooled block: context header followed by the attribute names
+        ctx = static_cast<XattrListContext *>(AllocBuffer(sizeof(XattrListContext) + buflen));
+        if (ctx == nullptr) {
+            buflen = -1;
+            en = ENOMEM;
         } else {
-            // Error occurred, clean up
-            free(buffer);
-            buffer = nullptr;
+            auto buffer = reinterpret_cast<char *>(ctx + 1);
+            std::memcpy(buffer, tlsNames.data(), size_t(buflen));
+            *ctx = XattrListContext{buffer, buffer, buffer + buflen};
         }
     }
 
-    auto v = new ValueT();
-    CreateHandle(v, handle_llistxattr, ctx, nullptr);
+    auto v = NewHandle(handle_llistxattr, ReleaseBuffer, ctx, nullptr);
 
     if (buflen >= 0)
         v->Type = TypeT::IsOk;
@@ -146,50 +339,103 @@ ValueT *llistxattr(const char *path) {
     return linux_llistxattr(path);
 };
 
+/**
+ * @brief Lists extended attribute names, packed encoding.
+ *
+ * Schema XattrList: each name is one occurrence of repeated field 1.
+ *
+ * @param path Filesystem path to read xattrs from.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_llistxattr_packed(const char *path, uint8_t **data, int64_t *length) {
+    return listxattr_packed([path](char *list, size_t size) { return ::llistxattr(path, list, size); }, data,
+                            length);
+}
+
 /**
  * @brief Gets the value of a specific extended attribute (not following
  * symlinks).
  *
- * Uses lgetxattr(2) to read the attribute value. The buffer is automatically
- * sized and null-terminated for string interpretation.
+ * Uses lgetxattr(2) to read the attribute value, normally with a single
+ * call into a per-thread scratch buffer; the value is yielded as
+ * length-prefixed bytes.
  *
  * @param path Filesystem path to read xattr from.
  * @param name Name of the extended attribute to retrieve.
- * @return ValueT* cursor with attribute value as string or error number.
+ * @return ValueT* cursor with attribute value as bytes or error number.
  */
 ValueT *linux_lgetxattr(const char *path, const char *name) {
-    errno = 0;
-
-    // First call to get the size needed
-    ssize_t buflen = ::lgetxattr(path, name, nullptr, 0);
-    auto    en = errno;
-
-    char *buffer = nullptr;
-    if (buflen > 0) {
-        // Allocate buffer and get the attribute value
-        buffer = static_cast<char *>(malloc(buflen + 1));  // +1 for null terminator
-        errno = 0;
-        buflen = ::lgetxattr(path, name, buffer, buflen);
-        en = errno;
-
-        if (buflen >= 0)
-            buffer[buflen] = '\0';  // Null-terminate the string
-    }
-
-    auto v = new ValueT();
-    CreateHandle(v, handle_lgetxattr, buffer, nullptr);
-
-    if (buflen >= 0)
-        v->Type = TypeT::IsOk;
-    else
-        v->Number = en;
-
-    return v;
+    return getxattr_cursor(
+        [path, name](void *value, size_t size) { return ::lgetxattr(path, name, value, size); });
 }
 
 // Backwards-compatibility wrapper: call the linux_* prefixed implementation.
 ValueT *lgetxattr(const char *path, const char *name) {
     return linux_lgetxattr(path, name);
 };
+
+/**
+ * @brief Lists extended attribute names of a handle, packed encoding.
+ *
+ * @param handle Handle from linux_openat_handle (O_PATH is fine).
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value.
+ */
+int linux_flistxattr_packed(int64_t handle, uint8_t **data, int64_t *length) {
+    return listxattr_packed([handle](char *list, size_t size) { return fd_listxattr(int(handle), list, size); },
+                            data, length);
+}
+
+/**
+ * @brief Gets an extended attribute of a handle; same cursor as
+ * linux_lgetxattr.
+ *
+ * @param handle Handle from linux_openat_handle (O_PATH is fine).
+ * @param name Name of the extended attribute to retrieve.
+ * @return ValueT* cursor with attribute value as bytes or error number.
+ */
+ValueT *linux_fgetxattr(int64_t handle, const char *name) {
+    return getxattr_cursor(
+        [handle, name](void *value, size_t size) { return fd_getxattr(int(handle), name, value, size); });
+}
+
+/**
+ * @brief Gets every wanted attribute with its value (not following
+ * symlinks), packed encoding.
+ *
+ * @param path Filesystem path to read xattrs from.
+ * @param namespaces XATTR_NS_* namespaces to include.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value of the listing.
+ */
+int linux_lgetxattrs_packed(const char *path, uint32_t namespaces, uint8_t **data, int64_t *length) {
+    return getxattrs_packed([path](char *list, size_t size) { return ::llistxattr(path, list, size); },
+                            [path](const char *name, char *value, size_t size) {
+                                return ::lgetxattr(path, name, value, size);
+                            },
+                            namespaces, data, length);
+}
+
+/**
+ * @brief Gets every wanted attribute of a handle with its value, packed
+ * encoding.
+ *
+ * @param handle Handle from linux_openat_handle (O_PATH is fine).
+ * @param namespaces XATTR_NS_* namespaces to include.
+ * @param data Receives a pooled buffer on success; free it with FreeBuffer.
+ * @param length Receives the encoded length on success.
+ * @return 0 on success, otherwise the errno value of the listing.
+ */
+int linux_fgetxattrs_packed(int64_t handle, uint32_t namespaces, uint8_t **data, int64_t *length) {
+    PackedWriter w(uint32_t(Schema::XattrValues), 512);
+    auto         rc = put_xattr_values(w, int(handle), namespaces, 1, 2);
+    if (rc == 0)
+        *data = w.release(length);
+    return rc;
+}
 }
 }  // namespace OsCalls
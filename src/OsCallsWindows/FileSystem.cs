@@ -71,6 +71,18 @@ public static unsafe partial class FileSystem
         return ToNode(win_lstat(path), path, nameof(win_lstat));
     }
 
+    /// <summary>
+    ///     Non-throwing variant of <see cref="LStat" />: a native failure (e.g. ERROR_FILE_NOT_FOUND) is returned
+    ///     as its Win32 error code, nothing is logged or thrown.
+    /// </summary>
+    /// <param name="path">Filesystem path to inspect.</param>
+    /// <param name="stat">Receives the file attributes on success, null otherwise.</param>
+    /// <returns>0 on success, otherwise the Win32 error code.</returns>
+    public static int TryLStat(string path, out JsonNode? stat)
+    {
+        return TryToNode(win_lstat(path), path, nameof(win_lstat), out stat);
+    }
+
     /// <summary>
     ///     Reads the target of a reparse point (symlink/junction/mount point).
     /// </summary>
@@ -25,6 +25,19 @@ public static unsafe partial class Security
         return ValXfer.ToNode(win_get_sd(path, includeSacl), path, nameof(win_get_sd));
     }
 
+    /// <summary>
+    ///     Non-throwing variant of <see cref="GetSecurityDescriptor" />: a native failure is returned as its Win32
+    ///     error code, nothing is logged or thrown.
+    /// </summary>
+    /// <param name="path">Filesystem path to read security descriptor from.</param>
+    /// <param name="descriptor">Receives the JsonNode with the "sddl" field on success, null otherwise.</param>
+    /// <param name="includeSacl">Whether to include SACL (requires SeSecurityPrivilege).</param>
+    /// <returns>0 on success, otherwise the Win32 error code.</returns>
+    public static int TryGetSecurityDescriptor(string path, out JsonNode? descriptor, bool includeSacl = false)
+    {
+        return ValXfer.TryToNode(win_get_sd(path, includeSacl), path, nameof(win_get_sd), out descriptor);
+    }
+
     /// <summary>
     ///     Reads security descriptor using Windows GetNamedSecurityInfoW API.
     ///     Primary implementation - wraps windows_GetNamedSecurityInfoW native export.
@@ -1,3 +1,4 @@
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Text.Json.Nodes;
 using ArchiveDataHandler;
@@ -27,7 +28,38 @@ public class WindowsHighLevelOsApi : IHighLevelOsApi
     /// <exception cref="OsException">Thrown on permission denied, not found, or I/O errors</exception>
     public InodeData CreateMinimalInodeDataFromPath(string path)
     {
-        var statBuf = FileSystem.LStat(path);
+        return FromStat(FileSystem.LStat(path));
+    }
+
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(string path, out InodeData? data)
+    {
+        var rc = FileSystem.TryLStat(path, out var statBuf);
+        data = rc == 0 ? FromStat(statBuf) : null;
+        return rc;
+    }
+
+    /// <summary>
+    ///     No directory handles on Windows yet: always null, so callers keep using paths.
+    /// </summary>
+    /// <param name="path">Directory path.</param>
+    /// <returns>Always null.</returns>
+    public SafeHandle? OpenDirectoryHandle(string path)
+    {
+        return null;
+    }
+
+    /// <inheritdoc />
+    public int TryCreateMinimalInodeDataFromPath(SafeHandle? directory, string path, out InodeData? data)
+    {
+        return TryCreateMinimalInodeDataFromPath(path, out data);
+    }
+
+    /// <summary>
+    ///     Builds the minimal <see cref="InodeData" /> from the JSON stat result of <see cref="FileSystem.LStat" />.
+    /// </summary>
+    private static InodeData FromStat(JsonNode? statBuf)
+    {
         var statObj = statBuf as JsonObject;
 
         // Determine textual flags (reg/dir/lnk etc.) from S_IS* or S_TYPEIS* booleans
@@ -76,6 +108,17 @@ public class WindowsHighLevelOsApi : IHighLevelOsApi
     /// <param name="archiveStore">Archive store used to save auxiliary data streams.</param>
     /// <returns>Completed <see cref="InodeData" /> instance.</returns>
     public InodeData CompleteInodeDataFromPath(string path, ref InodeData data, IArchiveStore archiveStore)
+    {
+        return CompleteInodeDataFromPath(null, path, ref data, archiveStore);
+    }
+
+    /// <inheritdoc />
+    public InodeData CompleteInodeDataFromPath(
+        SafeHandle? directory,
+        string path,
+        ref InodeData data,
+        IArchiveStore archiveStore
+    )
     {
         ArgumentNullException.ThrowIfNull(data);
 
@@ -84,19 +127,21 @@ public class WindowsHighLevelOsApi : IHighLevelOsApi
         data.UserName = data.Uid != 0 ? data.Uid.ToString() : "0";
         data.GroupName = data.Gid != 0 ? data.Gid.ToString() : "0";
 
-        // Try to capture security descriptor (SDDL) and save via archiveStore
+        // Try to capture security descriptor (SDDL) and save via archiveStore; a native failure is returned
+        // as an error code and simply leaves the ACL empty
         try
         {
-            var sd = Security.GetSecurityDescriptor(path);
-            if (sd is JsonObject sdObj && sdObj.ContainsKey("sddl"))
+            if (
+                Security.TryGetSecurityDescriptor(path, out var sd) == 0
+                && sd is JsonObject sdObj
+                && sdObj.ContainsKey("sddl")
+            )
             {
                 var sddl = sdObj["sddl"]?.ToString() ?? string.Empty;
                 if (!string.IsNullOrEmpty(sddl))
                 {
                     var sdBytes = Encoding.UTF8.GetBytes(sddl);
-                    using var ms = new MemoryStream(sdBytes);
-                    var sdHashes = archiveStore.SaveStream(ms, sdBytes.Length, $"{path} $acl", _ => { }).ToArray();
-                    data.Acl = sdHashes;
+                    data.Acl = archiveStore.SaveValue(sdBytes, $"{path} $acl").ToArray();
                 }
             }
         }
@@ -170,6 +215,47 @@ public class WindowsHighLevelOsApi : IHighLevelOsApi
         }
     }
 
+    /// <summary>
+    ///     <see cref="ListDirectory" /> without prefetched metadata: the traversal stats each entry itself.
+    /// </summary>
+    /// <param name="path">Directory to list.</param>
+    /// <returns>Ordered entries, all with null <see cref="DirectoryListingEntry.Data" />.</returns>
+    public DirectoryListingEntry[] ReadDirectory(string path)
+    {
+        return [.. ListDirectory(path).Select(entry => new DirectoryListingEntry(entry, null))];
+    }
+
+    /// <summary>
+    ///     No background scanner on Windows; the traversal uses <see cref="ReadDirectory" />.
+    /// </summary>
+    /// <returns>Always null.</returns>
+    public IDirectoryScanner? OpenDirectoryScanner(
+        IReadOnlyList<string> roots,
+        IReadOnlyList<string> excluded,
+        int threads
+    )
+    {
+        return null;
+    }
+
+    /// <summary>
+    ///     Not implemented on Windows; the traversal keeps name order.
+    /// </summary>
+    /// <returns>Always null.</returns>
+    public long[]? GetDataOffsets(string directory, IReadOnlyList<string> names)
+    {
+        return null;
+    }
+
+    /// <summary>
+    ///     Not implemented on Windows; SIDs are resolved as they are met.
+    /// </summary>
+    /// <returns>Always 0.</returns>
+    public int PreloadOwnerNames()
+    {
+        return 0;
+    }
+
     /// <summary>
     ///     Canonicalizes a filesystem path by resolving symlinks and normalizing separators.
     ///     Delegates to the FileSystem module's platform-specific implementation.
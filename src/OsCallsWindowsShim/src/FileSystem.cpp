@@ -83,6 +83,7 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "FileSystem.h"
+#include "ValuePool.h"
 #include <cstdio>
 #include <cstring>
 #include <vector>
@@ -616,7 +617,7 @@ static bool handle_GetFileInformationByHandle(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_GetFileInformationByHandle(const wchar_t *path) {
     auto               info = new WinFileInfo{};
-    auto               v = new ValueT();
+    auto               v = AllocValue();
     static const char *errno_name = "errno";
 
     // Open file/directory without following reparse points
@@ -721,7 +722,7 @@ static bool handle_DeviceIoControl_GetReparsePoint(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_DeviceIoControl_GetReparsePoint(const wchar_t *path) {
     wchar_t *target = nullptr;
-    auto     v = new ValueT();
+    auto     v = AllocValue();
 
     // Open the reparse point
     HANDLE hFile = win_open_path(path, FILE_FLAG_OPEN_REPARSE_POINT);
@@ -823,7 +824,7 @@ static bool handle_GetFinalPathNameByHandleW(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_GetFinalPathNameByHandleW(const wchar_t *path) {
     wchar_t           *canonical = nullptr;
-    auto               v = new ValueT();
+    auto               v = AllocValue();
     static const char *errno_name = "errno";
 
     // Open the file/directory
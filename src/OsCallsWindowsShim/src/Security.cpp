@@ -100,6 +100,7 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "Security.h"
+#include "ValuePool.h"
 // windows.h must be first
 // WIN32_LEAN_AND_MEAN and NOMINMAX are defined centrally in Platform.h
 #include <windows.h>
@@ -164,7 +165,7 @@ static bool handle_GetNamedSecurityInfoW(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_GetNamedSecurityInfoW(const wchar_t *path, bool include_sacl) {
     wchar_t           *sddl = nullptr;
-    auto               v = new ValueT();
+    auto               v = AllocValue();
     static const char *errno_name = "errno";  // Stable static pointer
 
     // Determine which security information to retrieve
@@ -103,6 +103,7 @@
 #include "Platform.h"
 // Platform.h must come first
 #include "Streams.h"
+#include "ValuePool.h"
 #include <algorithm>
 #include <string>
 #include <vector>
@@ -176,7 +177,7 @@ static bool handle_FindFirstStreamW(ValueT *value) {
 
     // Return stream info as a complex value (object with name and size)
     // Create a single ValueT for the stream object with its own iterator
-    auto streamObj = new ValueT();
+    auto streamObj = AllocValue();
     memset(streamObj, 0, sizeof(ValueT));
 
     // Allocate data to hold name and size
@@ -229,7 +230,7 @@ static bool handle_FindFirstStreamW(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_FindFirstStreamW(const wchar_t *path) {
     auto               streams = new StreamInfo{};
-    auto               v = new ValueT();
+    auto               v = AllocValue();
     static const char *errno_name = "errno";  // Stable static pointer
 
     WIN32_FIND_STREAM_DATA findStreamData;
@@ -335,7 +336,7 @@ static bool handle_ReadFile_Stream(ValueT *value) {
 
 extern "C" DLL_EXPORT ValueT *windows_ReadFile_Stream(const wchar_t *path, const wchar_t *stream_name) {
     auto               streamData = new StreamData{};
-    auto               v = new ValueT();
+    auto               v = AllocValue();
     static const char *errno_name = "errno";  // Stable static pointer
 
     // Construct full stream path: path:streamname:\c DATA